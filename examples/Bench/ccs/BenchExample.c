@@ -0,0 +1,63 @@
+/**
+ * @file BenchExample.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief An example project that benchmarks the drivers and reports the
+ *        results over UART.
+ * @version 0.1
+ * @date 2022-03-06
+ * @copyright Copyright (c) 2022
+ * @note
+ * Connect to UART_MODULE_0 (the debug USB port) at 115200 baud. The results
+ * are printed as CSV; see Bench.h for the format. Add `__FAST__` to the
+ * preprocessor defines to benchmark the fast GPIO functions. See BenchSuite.h
+ * for the pins used. Running examples/Bench/host/BenchHost.c against the
+ * register simulator produces the same report on a Linux host.
+ */
+
+/** General imports. */
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/UART/UART.h>
+#include <lib/Bench/BenchSuite.h>
+
+
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+/** @brief The UART the results are reported on. */
+UART_t uart;
+
+/** Sends a result over UART. */
+void reportResult(BenchResult_t result) {
+    char line[BENCH_LINE_SIZE];
+    uint8_t length = BenchFormat(result, line);
+    UARTSend(uart, (uint8_t *)line, length);
+}
+
+int main(void) {
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_0,
+        .baudrate=115200,
+        .dataLength=UART_BITS_8,
+        .isFIFODisabled=false,
+        .isTwoStopBits=false,
+        .parity=UART_PARITY_DISABLED,
+        .isLoopback=false
+    };
+    uart = UARTInit(uartConfig);
+
+    UARTSend(uart, (uint8_t *)BENCH_HEADER, sizeof(BENCH_HEADER) - 1);
+    BenchSuiteRun(reportResult);
+
+    EnableInterrupts();
+    while (1) {
+        WaitForInterrupt();
+    }
+}
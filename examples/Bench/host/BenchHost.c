@@ -0,0 +1,63 @@
+/**
+ * @file BenchHost.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Runs the driver benchmark suite on a Linux host against the register
+ *        simulator.
+ * @version 0.1
+ * @date 2022-03-06
+ * @copyright Copyright (c) 2022
+ * @note
+ * Build and run from the repository root:
+ *
+ *      gcc -std=c99 -O2 -D__HOST__ -I. -o bench \
+ *          examples/Bench/host/BenchHost.c lib/Bench/Bench.c \
+ *          lib/Bench/BenchSuite.c lib/RegSim/RegSim.c lib/PLL/PLL.c \
+ *          lib/GPIO/GPIO.c lib/Timer/Timer.c lib/ADC/ADC.c lib/UART/UART.c \
+ *          lib/SSI/SSI.c lib/I2C/I2C.c lib/DAC/DAC.c lib/DMA/DMA.c \
+ *          lib/Check/Check.c lib/Log/Log.c lib/CrashDump/CrashDump.c \
+ *          lib/Common/Common.c -lm
+ *      ./bench report.csv
+ *
+ * `make` at the repository root builds the same binary as build/host/bench.
+ *
+ * Add `-D__FAST__` to benchmark the fast GPIO functions. The report is the
+ * CSV described in Bench.h, written to the file given or to stdout.
+ */
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/Bench/BenchSuite.h>
+
+
+/** @brief The report destination. */
+static FILE * report;
+
+/** Writes a result to the report. */
+void reportResult(BenchResult_t result) {
+    char line[BENCH_LINE_SIZE];
+    BenchFormat(result, line);
+    fputs(line, report);
+}
+
+int main(int argc, char ** argv) {
+    report = stdout;
+    if (argc > 1) {
+        report = fopen(argv[1], "w");
+        if (report == NULL) {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    PLLInit(BUS_80_MHZ);
+
+    fputs(BENCH_HEADER, report);
+    BenchSuiteRun(reportResult);
+
+    if (report != stdout) fclose(report);
+    return EXIT_SUCCESS;
+}
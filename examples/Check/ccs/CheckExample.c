@@ -0,0 +1,133 @@
+/**
+ * @file CheckExample.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief An example project showing how to use the check policies.
+ * @version 0.1
+ * @date 2022-03-12
+ * @copyright Copyright (c) 2022
+ * @note
+ * Modify __MAIN__ on L13 to determine which main method is executed.
+ * __MAIN__ = 0 - A logged check on SW1 (PF4) and a resetting check on SW2
+ *                (PF0), reported over UART_MODULE_0.
+ */
+#define __MAIN__ 0
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/GPIO/GPIO.h>
+#include <lib/Timer/Timer.h>
+#include <lib/UART/UART.h>
+#include <lib/Log/Log.h>
+#include <lib/CrashDump/CrashDump.h>
+#include <lib/Check/Check.h>
+
+
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+
+#if __MAIN__ == 0
+/**
+ * @brief Tick logs the number of failed checks once a second.
+ *
+ * @param args Unused.
+ */
+void Tick(uint32_t * args) {
+    LOG("%u failed checks", CheckGetTotal());
+}
+
+/**
+ * @brief Sw1Pressed starts a timer that does not exist. CHECK_TIMER is set to
+ *        CHECK_LOG, so TimerStart logs the failure and returns.
+ *
+ * @param args Unused.
+ */
+void Sw1Pressed(uint32_t * args) {
+    Timer_t timer = { .timerID=TIMER_COUNT };
+    TimerStart(timer);
+}
+
+/**
+ * @brief Sw2Pressed fails a check of the application. CHECK_USER is set to
+ *        CHECK_RESET, so the TM4C resets and reports a crash dump whose last
+ *        trace record names this check.
+ *
+ * @param args Unused.
+ */
+void Sw2Pressed(uint32_t * args) {
+    static uint32_t presses = 0;
+    ++presses;
+    CHECK(CHECK_USER, presses < 2);
+}
+
+int main(void) {
+    /**
+     * @brief This program shows two check policies. Pressing SW1 (PF4) fails
+     *        an always on check in the timer driver, which is logged and
+     *        counted. Pressing SW2 (PF0) twice fails a check in the
+     *        application, which resets the TM4C. The log lines and any crash
+     *        dump are sent to the user PC at 921600 baud. Note that only UART0
+     *        on the TM4C is connected through USB. No other hardware
+     *        configuration outside of the TM4C Tiva C Launchpad is required
+     *        for this example. Run examples/CrashDump/host/CrashDumpDecoder.c
+     *        to decode the dump.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_0,
+        .baudrate=921600
+    };
+    UART_t uart = UARTInit(uartConfig);
+    CrashDumpReport(uart);
+
+    LogInit();
+    CheckSetPolicy(CHECK_TIMER, CHECK_LOG);
+    CheckSetPolicy(CHECK_USER, CHECK_RESET);
+
+    GPIOConfig_t sw1Config = {
+        .pin=PIN_F4,
+        .pull=GPIO_PULL_UP
+    };
+    GPIOInterruptConfig_t sw1IntConfig = {
+        .priority=3,
+        .touchTask=NULL,
+        .releaseTask=Sw1Pressed,
+        .pinStatus=RAISED
+    };
+    GPIOIntInit(sw1Config, sw1IntConfig);
+
+    GPIOConfig_t sw2Config = {
+        .pin=PIN_F0,
+        .pull=GPIO_PULL_UP
+    };
+    GPIOInterruptConfig_t sw2IntConfig = {
+        .priority=3,
+        .touchTask=NULL,
+        .releaseTask=Sw2Pressed,
+        .pinStatus=RAISED
+    };
+    GPIOIntInit(sw2Config, sw2IntConfig);
+
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_0A,
+        .period=freqToPeriod(1, MAX_FREQ),
+        .timerTask=Tick,
+        .isPeriodic=true,
+        .priority=5
+    };
+    Timer_t timer = TimerInit(timerConfig);
+    TimerStart(timer);
+
+    EnableInterrupts();
+    while (1) {
+        LogFlush(uart, 4);
+        WaitForInterrupt();
+    }
+}
+#endif
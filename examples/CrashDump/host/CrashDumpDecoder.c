@@ -0,0 +1,450 @@
+/**
+ * @file CrashDumpDecoder.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Finds crash dumps in a serial stream or file and decodes them against
+ *        the firmware ELF image.
+ * @version 0.1
+ * @date 2022-03-11
+ * @copyright Copyright (c) 2022
+ * @note
+ * Build and run from the repository root:
+ *
+ *      gcc -std=c99 -O2 -o crashdump examples/CrashDump/host/CrashDumpDecoder.c
+ *      ./crashdump /dev/ttyACM0 examples/CrashDump/keil/Objects/CrashDump.axf
+ *
+ * Arguments are the serial port or capture file, the ELF image the firmware
+ * was built as (.axf for Keil, .out for CCS), and the baud rate for serial
+ * ports, which defaults to 921600. Reset the TM4C after starting the decoder.
+ * Without the ELF image, addresses and trace records are printed raw.
+ *
+ * For each dump found, the decoder prints:
+ *      - The fault status registers, with the CFSR and HFSR bits named.
+ *      - The stacked registers, with pc and lr resolved to function + offset.
+ *      - Stack words that point into functions, i.e. likely return addresses,
+ *        as a rough backtrace.
+ *      - The Log records leading up to the fault, formatted with the strings
+ *        read from the ELF image.
+ *
+ * The dump format is described in lib/CrashDump/CrashDump.h. Bytes around the
+ * dump (i.e. log lines) are ignored. A serial port is read until the first
+ * dump; a file is read to the end.
+ */
+
+#define _DEFAULT_SOURCE
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+
+/** @brief The dump format this decoder understands, as in CrashDump.h. */
+#define CRASHDUMP_MAGIC 0x48535243
+#define CRASHDUMP_VERSION 1
+#define CRASHDUMP_STACK_WORDS 64
+#define CRASHDUMP_TRACE_RECORDS 8
+#define CRASHDUMP_TRACE_SIZE 28
+#define CRASHDUMP_SIZE 560
+
+/** @brief Byte offsets of the dump fields. */
+enum DumpOffset {
+    OFFSET_VERSION = 4,
+    OFFSET_SIZE = 6,
+    OFFSET_TIMESTAMP = 8,
+    OFFSET_CFSR = 12,
+    OFFSET_HFSR = 16,
+    OFFSET_MMFAR = 20,
+    OFFSET_BFAR = 24,
+    OFFSET_EXC_RETURN = 28,
+    OFFSET_SP = 32,
+    OFFSET_FRAME = 36,
+    OFFSET_NUM_STACK = 68,
+    OFFSET_STACK = 72,
+    OFFSET_NUM_TRACE = 328,
+    OFFSET_TRACE = 332,
+    OFFSET_CRC = 556
+};
+
+/** @brief A function symbol of the ELF image. */
+struct Symbol {
+    uint32_t address;
+    uint32_t size;
+    const char * name;
+};
+
+/** @brief The loaded ELF image. */
+static struct Image {
+    uint8_t * bytes;
+    size_t length;
+    const Elf32_Shdr * sections;
+    uint16_t numSections;
+    struct Symbol * symbols;
+    size_t numSymbols;
+} image;
+
+/** Reads a little endian value. */
+static uint32_t get(const uint8_t * bytes, int numBytes) {
+    uint32_t value = 0;
+    while (numBytes-- > 0) value = (value << 8) | bytes[numBytes];
+    return value;
+}
+
+/** Computes the CRC-32 (IEEE 802.3) of a buffer. */
+static uint32_t crc32(const uint8_t * bytes, size_t numBytes) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < numBytes; ++i) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/** ------------- ELF image. ------------- */
+
+/** Orders symbols by address. */
+static int compareSymbols(const void * a, const void * b) {
+    uint32_t left = ((const struct Symbol *)a)->address;
+    uint32_t right = ((const struct Symbol *)b)->address;
+    return (left > right) - (left < right);
+}
+
+/** Loads the sections and function symbols of a 32 bit little endian ELF. */
+static bool loadImage(const char * path) {
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    image.length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    image.bytes = malloc(image.length);
+    if (image.bytes == NULL || fread(image.bytes, 1, image.length, file) != image.length) {
+        fprintf(stderr, "%s: could not read\n", path);
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
+    const Elf32_Ehdr * header = (const Elf32_Ehdr *)image.bytes;
+    if (image.length < sizeof(Elf32_Ehdr) || memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 ||
+        header->e_ident[EI_CLASS] != ELFCLASS32 || header->e_ident[EI_DATA] != ELFDATA2LSB ||
+        header->e_shoff + (size_t)header->e_shnum * sizeof(Elf32_Shdr) > image.length) {
+        fprintf(stderr, "%s: not a 32 bit little endian ELF image\n", path);
+        return false;
+    }
+    image.sections = (const Elf32_Shdr *)(image.bytes + header->e_shoff);
+    image.numSections = header->e_shnum;
+
+    /* Collect function symbols. Mapping symbols ($t, $d) are skipped. */
+    for (uint16_t i = 0; i < image.numSections; ++i) {
+        const Elf32_Shdr * table = &image.sections[i];
+        if (table->sh_type != SHT_SYMTAB || table->sh_link >= image.numSections) continue;
+        const Elf32_Shdr * strings = &image.sections[table->sh_link];
+        const Elf32_Sym * symbols = (const Elf32_Sym *)(image.bytes + table->sh_offset);
+        size_t count = table->sh_size / sizeof(Elf32_Sym);
+
+        image.symbols = realloc(image.symbols, (image.numSymbols + count) * sizeof(struct Symbol));
+        for (size_t j = 0; j < count; ++j) {
+            if (ELF32_ST_TYPE(symbols[j].st_info) != STT_FUNC) continue;
+            const char * name = (const char *)image.bytes + strings->sh_offset + symbols[j].st_name;
+            if (name[0] == '\0' || name[0] == '$') continue;
+            image.symbols[image.numSymbols++] = (struct Symbol){
+                .address=symbols[j].st_value & ~1u,
+                .size=symbols[j].st_size,
+                .name=name
+            };
+        }
+    }
+    qsort(image.symbols, image.numSymbols, sizeof(struct Symbol), compareSymbols);
+    return true;
+}
+
+/** Returns the function containing a code address, or NULL. */
+static const struct Symbol * findSymbol(uint32_t address) {
+    address &= ~1u;
+    const struct Symbol * best = NULL;
+    for (size_t i = 0; i < image.numSymbols && image.symbols[i].address <= address; ++i) {
+        best = &image.symbols[i];
+    }
+    if (best == NULL) return NULL;
+    if (best->size != 0 && address >= best->address + best->size) return NULL;
+    return best;
+}
+
+/** Returns the image bytes at a device address, with the number of bytes
+    available after it, or NULL. */
+static const uint8_t * findBytes(uint32_t address, size_t * available) {
+    for (uint16_t i = 0; i < image.numSections; ++i) {
+        const Elf32_Shdr * section = &image.sections[i];
+        if (!(section->sh_flags & SHF_ALLOC) || section->sh_type == SHT_NOBITS) continue;
+        if (address < section->sh_addr || address - section->sh_addr >= section->sh_size) continue;
+        *available = section->sh_size - (address - section->sh_addr);
+        return image.bytes + section->sh_offset + (address - section->sh_addr);
+    }
+    return NULL;
+}
+
+/** Returns a null terminated string at a device address, or NULL. */
+static const char * findString(uint32_t address) {
+    size_t available;
+    const char * string = (const char *)findBytes(address, &available);
+    if (string == NULL || memchr(string, '\0', available) == NULL) return NULL;
+    return string;
+}
+
+/** Prints " function+0xoffset" for a code address, if it resolves. */
+static void printSymbol(uint32_t address) {
+    const struct Symbol * symbol = findSymbol(address);
+    if (symbol != NULL) printf("  %s+0x%x", symbol->name, (address & ~1u) - symbol->address);
+}
+
+/** ------------- Dump. ------------- */
+
+/** Prints the names of the set bits of a register. */
+static void printBits(uint32_t value, const char * const names[32]) {
+    for (int bit = 0; bit < 32; ++bit) {
+        if ((value & (1u << bit)) && names[bit] != NULL) printf(" %s", names[bit]);
+    }
+}
+
+/** Formats a Log record like LogFormat, reading strings from the image. */
+static void printTrace(const uint8_t * trace) {
+    uint32_t timestamp = get(trace, 4);
+    uint32_t formatAddress = get(trace + 4, 4);
+    uint32_t numArgs = get(trace + 8, 4);
+    uint32_t args[4];
+    for (int i = 0; i < 4; ++i) args[i] = get(trace + 12 + 4 * i, 4);
+
+    printf("  %10u  ", timestamp);
+    const char * format = findString(formatAddress);
+    if (format == NULL) {
+        printf("<format 0x%08x>", formatAddress);
+        for (uint32_t i = 0; i < numArgs && i < 4; ++i) printf(" 0x%08x", args[i]);
+        printf("\n");
+        return;
+    }
+
+    uint32_t arg = 0;
+    while (*format != '\0') {
+        if (*format != '%') {
+            putchar(*format++);
+            continue;
+        }
+        ++format;
+
+        /* Rebuild the conversion for printf, i.e. "%08x". */
+        char spec[16] = "%";
+        size_t length = 1;
+        while (strchr("0123456789", *format) != NULL && *format != '\0' && length < 8) {
+            spec[length++] = *format++;
+        }
+        if (*format == '\0') break;
+        if (*format == '%') {
+            putchar('%');
+            ++format;
+            continue;
+        }
+
+        uint32_t value = (arg < numArgs && arg < 4) ? args[arg] : 0;
+        ++arg;
+        switch (*format) {
+            case 'd':
+            case 'i':
+                spec[length++] = 'd';
+                printf(spec, (int32_t)value);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'c':
+                spec[length++] = *format;
+                printf(spec, value);
+                break;
+            case 'p':
+                printf("0x%08x", value);
+                break;
+            case 's': {
+                const char * string = findString(value);
+                if (string != NULL) printf("%s", string);
+                else printf("<0x%08x>", value);
+                break;
+            }
+            default:
+                break;
+        }
+        ++format;
+    }
+    printf("\n");
+}
+
+/** Prints a dump. */
+static void printDump(const uint8_t * dump) {
+    static const char * const cfsrNames[32] = {
+        [0]="IACCVIOL", [1]="DACCVIOL", [3]="MUNSTKERR", [4]="MSTKERR",
+        [5]="MLSPERR", [7]="MMARVALID", [8]="IBUSERR", [9]="PRECISERR",
+        [10]="IMPRECISERR", [11]="UNSTKERR", [12]="STKERR", [13]="LSPERR",
+        [15]="BFARVALID", [16]="UNDEFINSTR", [17]="INVSTATE", [18]="INVPC",
+        [19]="NOCP", [24]="UNALIGNED", [25]="DIVBYZERO"
+    };
+    static const char * const hfsrNames[32] = {
+        [1]="VECTTBL", [30]="FORCED", [31]="DEBUGEVT"
+    };
+    static const char * const frameNames[8] = {
+        "r0", "r1", "r2", "r3", "r12", "lr", "pc", "xpsr"
+    };
+
+    uint32_t cfsr = get(dump + OFFSET_CFSR, 4);
+    uint32_t hfsr = get(dump + OFFSET_HFSR, 4);
+    uint32_t excReturn = get(dump + OFFSET_EXC_RETURN, 4);
+    uint32_t sp = get(dump + OFFSET_SP, 4);
+
+    printf("Crash dump at cycle %u\n\n", get(dump + OFFSET_TIMESTAMP, 4));
+
+    /* 1. Fault status. */
+    printf("Fault status:\n");
+    printf("  CFSR        0x%08x", cfsr);
+    printBits(cfsr, cfsrNames);
+    printf("\n  HFSR        0x%08x", hfsr);
+    printBits(hfsr, hfsrNames);
+    printf("\n  MMFAR       0x%08x%s\n", get(dump + OFFSET_MMFAR, 4),
+           (cfsr & (1u << 7)) ? "" : " (not valid)");
+    printf("  BFAR        0x%08x%s\n", get(dump + OFFSET_BFAR, 4),
+           (cfsr & (1u << 15)) ? "" : " (not valid)");
+    if (excReturn == 0) {
+        /* CheckFail under CHECK_RESET. The last log record names the check. */
+        printf("  EXC_RETURN  none (reset by a failed check)\n\n");
+    } else {
+        printf("  EXC_RETURN  0x%08x (%s mode, %s, %s frame)\n\n", excReturn,
+               (excReturn & 0x8) ? "thread" : "handler",
+               (excReturn & 0x4) ? "PSP" : "MSP",
+               (excReturn & 0x10) ? "basic" : "floating point");
+    }
+
+    /* 2. Stacked registers. */
+    printf("Registers (sp 0x%08x):\n", sp);
+    for (int i = 0; i < 8; ++i) {
+        uint32_t value = get(dump + OFFSET_FRAME + 4 * i, 4);
+        printf("  %-4s        0x%08x", frameNames[i], value);
+        if (i == 5 || i == 6) printSymbol(value);
+        printf("\n");
+    }
+
+    /* 3. Likely return addresses. Thumb return addresses are odd. */
+    uint32_t numStack = get(dump + OFFSET_NUM_STACK, 4);
+    if (numStack > CRASHDUMP_STACK_WORDS) numStack = CRASHDUMP_STACK_WORDS;
+    uint32_t frameWords = (excReturn & 0x10) ? 8 : 26;
+    printf("\nStack (%u words above the frame, code addresses only):\n", numStack);
+    for (uint32_t i = 0; i < numStack; ++i) {
+        uint32_t value = get(dump + OFFSET_STACK + 4 * i, 4);
+        if (!(value & 1) || findSymbol(value) == NULL) continue;
+        printf("  0x%08x: 0x%08x", sp + 4 * (frameWords + i), value);
+        printSymbol(value);
+        printf("\n");
+    }
+    if (image.numSymbols == 0) printf("  (no ELF image symbols)\n");
+
+    /* 4. Log records. */
+    uint32_t numTrace = get(dump + OFFSET_NUM_TRACE, 4);
+    if (numTrace > CRASHDUMP_TRACE_RECORDS) numTrace = CRASHDUMP_TRACE_RECORDS;
+    printf("\nLast %u log records:\n", numTrace);
+    for (uint32_t i = 0; i < numTrace; ++i) {
+        printTrace(dump + OFFSET_TRACE + CRASHDUMP_TRACE_SIZE * i);
+    }
+    printf("\n");
+}
+
+/** Returns whether a complete, valid dump starts at bytes. */
+static bool isDump(const uint8_t * bytes) {
+    return get(bytes, 4) == CRASHDUMP_MAGIC &&
+        get(bytes + OFFSET_VERSION, 2) == CRASHDUMP_VERSION &&
+        get(bytes + OFFSET_SIZE, 2) == CRASHDUMP_SIZE &&
+        crc32(bytes, OFFSET_CRC) == get(bytes + OFFSET_CRC, 4);
+}
+
+/** Puts a serial port into raw mode at a baud rate. */
+static bool configureSerial(int fd, unsigned long baudrate) {
+    static const struct { unsigned long rate; speed_t speed; } speeds[] = {
+        { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 },
+        { 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 },
+        { 460800, B460800 }, { 921600, B921600 }, { 1000000, B1000000 },
+        { 2000000, B2000000 }, { 3000000, B3000000 }
+    };
+
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0) return false;
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+        if (speeds[i].rate == baudrate) {
+            cfsetispeed(&tty, speeds[i].speed);
+            cfsetospeed(&tty, speeds[i].speed);
+            return tcsetattr(fd, TCSANOW, &tty) == 0;
+        }
+    }
+    fprintf(stderr, "crashdump: unsupported baud rate %lu\n", baudrate);
+    return false;
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <device or file> [image.axf|image.out] [baudrate]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 2 && !loadImage(argv[2])) return EXIT_FAILURE;
+
+    int fd = open(argv[1], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    bool isSerial = isatty(fd);
+    unsigned long baudrate = (argc > 3) ? strtoul(argv[3], NULL, 10) : 921600;
+    if (isSerial && !configureSerial(fd, baudrate)) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    /* Slide a window over the stream, looking for the magic. A candidate that
+       fails its CRC is skipped one byte at a time. */
+    uint8_t window[2 * CRASHDUMP_SIZE];
+    size_t length = 0;
+    unsigned long numDumps = 0;
+    ssize_t numRead;
+    while ((numRead = read(fd, window + length, sizeof(window) - length)) > 0) {
+        length += numRead;
+
+        size_t start = 0;
+        while (length - start >= CRASHDUMP_SIZE) {
+            if (!isDump(window + start)) {
+                ++start;
+                continue;
+            }
+            printDump(window + start);
+            ++numDumps;
+            start += CRASHDUMP_SIZE;
+            if (isSerial) break;
+        }
+        if (isSerial && numDumps > 0) break;
+
+        memmove(window, window + start, length - start);
+        length -= start;
+    }
+
+    if (numDumps == 0) fprintf(stderr, "crashdump: no crash dump found\n");
+    close(fd);
+    free(image.bytes);
+    free(image.symbols);
+    return numDumps > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
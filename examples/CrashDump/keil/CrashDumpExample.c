@@ -0,0 +1,112 @@
+/**
+ * @file CrashDumpExample.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief An example project showing how to use the crash dump driver.
+ * @version 0.1
+ * @date 2022-03-11
+ * @copyright Copyright (c) 2022
+ * @note
+ * Modify __MAIN__ on L13 to determine which main method is executed.
+ * __MAIN__ = 0 - Faulting on SW1 (PF4), reporting the dump on the next boot
+ *                over UART_MODULE_0.
+ */
+#define __MAIN__ 0
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/GPIO/GPIO.h>
+#include <lib/Timer/Timer.h>
+#include <lib/UART/UART.h>
+#include <lib/Log/Log.h>
+#include <lib/CrashDump/CrashDump.h>
+
+
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+
+#if __MAIN__ == 0
+/**
+ * @brief Tick leaves a breadcrumb in the Log ring at 10 Hz. The most recent
+ *        ones end up in the dump.
+ *
+ * @param args Unused.
+ */
+void Tick(uint32_t * args) {
+    static uint32_t count = 0;
+    ++count;
+    LOG("tick %u", count);
+}
+
+/**
+ * @brief SwitchPressed reads from reserved memory above the flash, causing a
+ *        precise bus fault. The bus fault handler is not enabled, so it
+ *        escalates to a hard fault.
+ *
+ * @param args Unused.
+ */
+void SwitchPressed(uint32_t * args) {
+    LOG("%s pressed, faulting", "SW1");
+    volatile uint32_t * reserved = (volatile uint32_t *)0x00100000;
+    LOG("read 0x%08x", *reserved);
+}
+
+int main(void) {
+    /**
+     * @brief This program leaves a crash dump when SW1 (PF4) is pressed. The
+     *        fault handler resets the TM4C, and on the next boot the dump is
+     *        sent to the user PC at 921600 baud, followed by the usual log
+     *        lines. Note that only UART0 on the TM4C is connected through USB.
+     *        No other hardware configuration outside of the TM4C Tiva C
+     *        Launchpad is required for this example. Run
+     *        examples/CrashDump/host/CrashDumpDecoder.c with the serial port
+     *        and the ELF image of this project to decode the dump.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_0,
+        .baudrate=921600
+    };
+    UART_t uart = UARTInit(uartConfig);
+
+    /* Send the dump left by the last fault, if any, ahead of the log lines. */
+    CrashDumpReport(uart);
+
+    LogInit();
+    LOG("crash dump example started at %u Hz", PLLGetFrequency());
+
+    GPIOConfig_t switchConfig = {
+        .pin=PIN_F4,
+        .pull=GPIO_PULL_UP
+    };
+    GPIOInterruptConfig_t switchIntConfig = {
+        .priority=3,
+        .touchTask=NULL,
+        .releaseTask=SwitchPressed,
+        .pinStatus=RAISED
+    };
+    GPIOIntInit(switchConfig, switchIntConfig);
+
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_0A,
+        .period=freqToPeriod(10, MAX_FREQ),
+        .timerTask=Tick,
+        .isPeriodic=true,
+        .priority=5
+    };
+    Timer_t timer = TimerInit(timerConfig);
+    TimerStart(timer);
+
+    EnableInterrupts();
+    while (1) {
+        LogFlush(uart, 4);
+        WaitForInterrupt();
+    }
+}
+#endif
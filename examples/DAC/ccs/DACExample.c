@@ -5,7 +5,15 @@
  * @version 0.1
  * @date 2021-09-24
  * @copyright Copyright (c) 2021
+ * @note
+ * Modify __MAIN__ on L16 to determine which main method is executed.
+ * __MAIN__ = 0 - Initialization and single sample output of a DAC.
+ *          = 1 - Streaming a 4 bit triangle wave buffer to a DAC spread across
+ *                two ports.
+ *          = 2 - Streaming a 4 bit sawtooth with the uDMA, refilling each half
+ *                of a ping-pong buffer as it completes.
  */
+#define __MAIN__ 0
 
 /** General imports. */
 #include <stdint.h>
@@ -15,8 +23,15 @@
 #include <lib/PLL/PLL.h>
 #include <lib/DAC/DAC.h>
 #include <lib/GPIO/GPIO.h>
+#include <lib/Timer/Timer.h>
+#include <lib/DMA/DMA.h>
 
 
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+#if __MAIN__ == 0
 GPIOPin_t pins[2] = { PIN_B0, PIN_COUNT };
 DACConfig_t config = {
     .pins=pins,
@@ -43,3 +58,85 @@ int main(void) {
     
     while (1) {}
 }
+#elif __MAIN__ == 1
+GPIOPin_t pins[4] = { PIN_B0, PIN_B1, PIN_E4, PIN_E5 };
+uint8_t triangle[30] = {
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1
+};
+
+int main(void) {
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    DACConfig_t config = {
+        .pins=pins,
+        .numPins=4
+    };
+    DAC_t dac = DACInit(config);
+
+    /* Output the wave at 1 kHz; 30 kHz sample rate. Bits 0-1 are written to
+       port B and bits 2-3 to port E, one store each. */
+    DACBufferConfig_t bufferConfig = {
+        .samples=triangle,
+        .numSamples=30,
+        .timerID=TIMER_0A,
+        .period=freqToPeriod(30000, MAX_FREQ),
+        .isLooping=true
+    };
+    DACOutBuffer(dac, bufferConfig);
+
+    EnableInterrupts();
+    while (1) {
+        WaitForInterrupt();
+    }
+}
+#elif __MAIN__ == 2
+#define WAVE_WORDS 64
+
+GPIOPin_t pins[4] = { PIN_B0, PIN_B1, PIN_B2, PIN_B3 };
+DAC_t dac;
+uint8_t wordsA[WAVE_WORDS];
+uint8_t wordsB[WAVE_WORDS];
+uint8_t level = 0;
+
+/** Refills a half of the stream with the next segment of a sawtooth. */
+void refill(uint8_t * words, uint32_t * args) {
+    uint8_t samples[WAVE_WORDS];
+    uint16_t i;
+    for (i = 0; i < WAVE_WORDS; ++i) {
+        samples[i] = level;
+        level = (level + 1) & 0xF;
+    }
+    DACWaveformConvert(dac, samples, WAVE_WORDS, words);
+}
+
+int main(void) {
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    DACConfig_t config = {
+        .pins=pins,
+        .numPins=4
+    };
+    dac = DACInit(config);
+
+    /* 200 kHz sample rate. The CPU is only interrupted every 64 samples. */
+    DACWaveformConfig_t waveformConfig = {
+        .timerID=TIMER_1A,
+        .period=freqToPeriod(200000, MAX_FREQ),
+        .refillTask=refill,
+        .priority=1
+    };
+    DACWaveformInit(dac, waveformConfig);
+
+    refill(wordsA, NULL);
+    refill(wordsB, NULL);
+    DACWaveformStream(dac, wordsA, wordsB, WAVE_WORDS);
+
+    EnableInterrupts();
+    while (1) {
+        WaitForInterrupt();
+    }
+}
+#endif
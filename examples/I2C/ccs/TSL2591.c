@@ -6,18 +6,27 @@
  * @date 2021-10-07
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support interrupts. This device
- * may require user tuning of the output. A feature to tune the device may be
- * provided at some point in the future.
+ * Asynchronous Sampling. TSL2591SampleStart enables the sensor through the I2C
+ * transaction queue and arms a hardware timer for the integration time. The
+ * timer then queues a single burst read of the status and both channels, and
+ * lux is computed in fixed point from the I2C interrupt before sampleTask is
+ * called. In continuous mode the sensor stays enabled and is read once every
+ * integration time, which is the maximum rate of the sensor.
+ *
+ * Unsupported Features. This driver does not support the sensor's interrupt
+ * pin. This device may require user tuning of the output. A feature to tune
+ * the device may be provided at some point in the future.
  */
 
 /** General imports. */
+#include <stdlib.h>
 #include <assert.h>
 
 /** Device specific imports. */
 #include "./TSL2591.h"
 #include <lib/Timer/Timer.h>
 #include <lib/GPIO/GPIO.h>
+#include <lib/PLL/PLL.h>
 
 
 #define TSL2591_CMD         0xA0
@@ -28,6 +37,8 @@
 #define TSL2591_SAI         0x40
 #define TSL2591_NPIEN       0x80
 
+#define TSL2591_AVALID      0x01
+
 #define TSL2591_I2C_ADDR    0x29
 #define TSL2591_DEV_ID      0x50
 
@@ -63,9 +74,8 @@ TSL2591_t TSL2591Init(TSL2591Config_t config) {
 
     /* Check for matching Device ID. */
     uint8_t transmit[] = { TSL2591_CMD | TSL2591_REG_ID };
-    I2CMasterTransmit(i2c, TSL2591_I2C_ADDR, transmit, 1);
     uint8_t read[] = { 0 };
-    I2CMasterReceive(i2c, TSL2591_I2C_ADDR, read, 1);
+    I2CMasterWriteRead(i2c, TSL2591_I2C_ADDR, transmit, 1, read, 1);
     if (read[0] == TSL2591_DEV_ID) {
         /* Set gain and integration time. */
         uint8_t transmit2[2] = { TSL2591_CMD | TSL2591_REG_CONTROL, 0 };
@@ -81,7 +91,13 @@ TSL2591_t TSL2591Init(TSL2591Config_t config) {
             .lux=0,
             .irradiance=0,
             .gain=config.gain,
-            .time=config.time
+            .time=config.time,
+            .isSampleReady=false,
+            .isBusy=false,
+            .isContinuous=false,
+            .timerID=config.timerID,
+            .sampleTask=config.sampleTask,
+            .sampleArgs=config.sampleArgs
         };
         
         /* Disable. */
@@ -91,6 +107,85 @@ TSL2591_t TSL2591Init(TSL2591Config_t config) {
     assert(0); // Configuration error. Cannot extract ID.
 }
 
+/**
+ * @brief TSL2591_LUX_COEF generates, at compile time, the Q32 reciprocal of
+ *        the counts per lux (CPL = ATIME * AGAIN / 408) for coefficients
+ *        scaled by 100, further divided by a divisor. Rounded to nearest.
+ */
+#define TSL2591_LUX_COEF(atime, again, divisor) \
+    ((uint32_t)(((408ULL << 32) + (atime) * (again) * 100ULL * (divisor) / 2) / \
+        ((atime) * (again) * 100ULL * (divisor))))
+
+/** @brief TSL2591_LUX_ROW generates the coefficients of a gain multiplier
+ *         for every integration time. */
+#define TSL2591_LUX_ROW(again, divisor) { \
+    TSL2591_LUX_COEF(100, again, divisor), \
+    TSL2591_LUX_COEF(200, again, divisor), \
+    TSL2591_LUX_COEF(300, again, divisor), \
+    TSL2591_LUX_COEF(400, again, divisor), \
+    TSL2591_LUX_COEF(500, again, divisor), \
+    TSL2591_LUX_COEF(600, again, divisor)  \
+}
+
+/**
+ * @brief TSL2591LuxMapping converts the scaled channel difference into lux for
+ *        each gain (1x, 25x, 428x, 9876x) and integration time.
+ */
+static const uint32_t TSL2591LuxMapping[4][6] = {
+    TSL2591_LUX_ROW(1, 1),
+    TSL2591_LUX_ROW(25, 1),
+    TSL2591_LUX_ROW(428, 1),
+    TSL2591_LUX_ROW(9876, 1)
+};
+
+/**
+ * @brief TSL2591IrradianceMapping converts the scaled channel difference into
+ *        W/m^2 (lux / 120) for each gain and integration time.
+ */
+static const uint32_t TSL2591IrradianceMapping[4][6] = {
+    TSL2591_LUX_ROW(1, 120),
+    TSL2591_LUX_ROW(25, 120),
+    TSL2591_LUX_ROW(428, 120),
+    TSL2591_LUX_ROW(9876, 120)
+};
+
+#undef TSL2591_LUX_ROW
+#undef TSL2591_LUX_COEF
+
+/**
+ * @brief TSL2591Update updates the measurement values of a sensor from the raw
+ *        channel counts. Lux is computed in fixed point with a single multiply
+ *        by a precomputed coefficient; no division or floating point is used.
+ *        Within 1 lux of the floating point reference.
+ * 
+ * @param sensor Sensor to update.
+ * @param ch0 Full spectrum channel count.
+ * @param ch1 IR channel count.
+ */
+static void TSL2591Update(TSL2591_t * sensor, uint16_t ch0, uint16_t ch1) {
+    sensor->raw = ((uint32_t)ch1 << 16) | ch0;
+    sensor->full = ch0;
+    sensor->ir = ch1;
+    sensor->visible = sensor->full - sensor->ir;
+
+    if ((sensor->full == 0xFFFF) | (sensor->ir == 0xFFFF)) {
+        sensor->lux = 0;
+        return;
+    }
+
+    /* lux = max(CH0 - 1.64 CH1, 0.59 CH0 - 0.86 CH1) / CPL. The channel
+       coefficients are scaled by 100, which the Q32 tables undo. */
+    int32_t lux1 = 100 * (int32_t)sensor->full - 164 * (int32_t)sensor->ir;
+    int32_t lux2 = 59 * (int32_t)sensor->full - 86 * (int32_t)sensor->ir;
+    int32_t lux3 = lux1 > lux2 ? lux1 : lux2;
+    if (lux3 < 0) lux3 = 0;
+
+    sensor->lux = (uint32_t)(((uint64_t)lux3 *
+        TSL2591LuxMapping[sensor->gain][sensor->time]) >> 32);
+    sensor->irradiance = (uint32_t)(((uint64_t)lux3 *
+        TSL2591IrradianceMapping[sensor->gain][sensor->time]) >> 32);
+}
+
 void TSL2591Enable(TSL2591_t * sensor) {
     /* Activate internal oscillator and ALS sampler. */
     uint8_t transmit[] = { TSL2591_CMD | TSL2591_REG_ENABLE , TSL2591_PON | TSL2591_AEN | TSL2591_AIEN | TSL2591_NPIEN };
@@ -115,67 +210,146 @@ void TSL2591Sample(TSL2591_t * sensor) {
     /* Capture Channel 1. */
     uint8_t transmit[] = { TSL2591_CMD | TSL2591_REG_CHAN1_L };
     uint8_t read1[2] = { 0 };
-    I2CMasterTransmit(sensor->i2c, TSL2591_I2C_ADDR, transmit, 1);
-    I2CMasterReceive(sensor->i2c, TSL2591_I2C_ADDR, read1, 2);
+    I2CMasterWriteRead(sensor->i2c, TSL2591_I2C_ADDR, transmit, 1, read1, 2);
 
     /* Capture Channel 0. */
     transmit[0] = TSL2591_CMD | TSL2591_REG_CHAN0_L;
     uint8_t read2[2] = { 0 };
-    I2CMasterTransmit(sensor->i2c, TSL2591_I2C_ADDR, transmit, 1);
-    I2CMasterReceive(sensor->i2c, TSL2591_I2C_ADDR, read2, 2);
+    I2CMasterWriteRead(sensor->i2c, TSL2591_I2C_ADDR, transmit, 1, read2, 2);
 
     TSL2591Disable(sensor);
 
     /* Set up values. */
-    sensor->raw = (((read1[1] << 8) | read1[0]) << 16) | ((read2[1] << 8) | read2[0]);
-    sensor->full = sensor->raw & 0xFFFF;
-    sensor->ir = sensor->raw >> 16;
-    sensor->visible = sensor->full - sensor->ir;
+    TSL2591Update(sensor, (read2[1] << 8) | read2[0], (read1[1] << 8) | read1[0]);
+}
 
-    if ((sensor->full == 0xFFFF) | (sensor->ir == 0xFFFF)) {
-        sensor->lux = 0;
+/**
+ * @brief TSL2591SubmitCommand queues a write to the enable register.
+ * 
+ * @param sensor Sensor to command.
+ * @param enable Value of the enable register.
+ * @param doneTask Function called once the command completes.
+ */
+static void TSL2591SubmitCommand(TSL2591_t * sensor, uint8_t enable, void (*doneTask)(uint32_t *args)) {
+    sensor->commandBytes[0] = TSL2591_CMD | TSL2591_REG_ENABLE;
+    sensor->commandBytes[1] = enable;
+    sensor->command.slaveAddress = TSL2591_I2C_ADDR;
+    sensor->command.txBytes = sensor->commandBytes;
+    sensor->command.numTx = 2;
+    sensor->command.rxBytes = NULL;
+    sensor->command.numRx = 0;
+    sensor->command.doneTask = doneTask;
+    sensor->command.doneArgs = (uint32_t *)sensor;
+    bool isQueued = I2CMasterSubmit(sensor->i2c, &sensor->command);
+    assert(isQueued);
+}
+
+/**
+ * @brief TSL2591ReadDone updates the sensor once the burst read completes.
+ *        Called from the I2C interrupt.
+ * 
+ * @param args Pointer to the sensor.
+ */
+static void TSL2591ReadDone(uint32_t * args) {
+    TSL2591_t * sensor = (TSL2591_t *)args;
+    uint8_t * bytes = sensor->readBytes;
+
+    /* A read before the first integration cycle completes is retried on the
+       next timer tick. */
+    bool isValid = sensor->read.status == I2C_OK;
+    if (isValid && !(bytes[0] & TSL2591_AVALID) && sensor->isBusy) {
+        if (!sensor->isContinuous) TimerStart(sensor->timer);
         return;
-    } else {
-        float atime, again, cpl, lux1, lux2, lux3;
-        
-        atime = 100.0F;
-        if (sensor->time <= TSL2591_INTT_600MS) {
-            atime += 100.0F * sensor->time;
-        } else {
-            assert(0);
-        }
-        switch(sensor->gain) {
-            case TSL2591_GAIN_LOW:
-                again = 1.0F;
-                break;
-            case TSL2591_GAIN_MED:
-                again = 25.0F;
-                break;
-            case TSL2591_GAIN_HIGH:
-                again = 428.0F;
-                break;
-            case TSL2591_GAIN_MAX:
-                again = 9876.0F;
-                break;
-            default:
-                assert(0);
-        }
-
-        #define TSL2591_LUX_DF      (408.0F)
-        #define TSL2591_LUX_COEFB   (1.64F)  // CH0 coefficient 
-        #define TSL2591_LUX_COEFC   (0.59F)  // CH1 coefficient A
-        #define TSL2591_LUX_COEFD   (0.86F)  // CH2 coefficient B
-
-        cpl = (atime * again) / TSL2591_LUX_DF;
-        lux1 = ((float) sensor->full - (TSL2591_LUX_COEFB * (float) sensor->ir)) / cpl;
-        lux2 = ((TSL2591_LUX_COEFC * (float) sensor->full) - (TSL2591_LUX_COEFD * (float) sensor->ir)) / cpl;
-        lux3 = lux1 > lux2 ? lux1 : lux2;
-        sensor->lux = (uint32_t) lux3;
-        sensor->irradiance = (uint32_t)(lux3 * 0.0083333);
-
-        #undef TSL2591_LUX_DF
-        #undef TSL2591_LUX_COEFB
-        #undef TSL2591_LUX_COEFC
-        #undef TSL2591_LUX_COEFD
     }
+
+    if (isValid) {
+        TSL2591Update(sensor, (bytes[2] << 8) | bytes[1], (bytes[4] << 8) | bytes[3]);
+        sensor->isSampleReady = true;
+    }
+
+    if (!sensor->isContinuous) {
+        sensor->isBusy = false;
+        TSL2591SubmitCommand(sensor, TSL2591_POFF, NULL);
+    }
+
+    if (isValid && sensor->sampleTask != NULL) {
+        sensor->sampleTask(sensor->sampleArgs);
+    }
+}
+
+/**
+ * @brief TSL2591TimerDone queues the burst read once the integration time has
+ *        passed. Called from the timer interrupt.
+ * 
+ * @param args Pointer to the sensor.
+ */
+static void TSL2591TimerDone(uint32_t * args) {
+    TSL2591_t * sensor = (TSL2591_t *)args;
+    if (!sensor->isBusy) return;
+
+    /* Read status, CH0, and CH1 in a single burst from the status register. */
+    sensor->readAddress = TSL2591_CMD | TSL2591_REG_STATUS;
+    sensor->read.slaveAddress = TSL2591_I2C_ADDR;
+    sensor->read.txBytes = &sensor->readAddress;
+    sensor->read.numTx = 1;
+    sensor->read.rxBytes = sensor->readBytes;
+    sensor->read.numRx = 5;
+    sensor->read.doneTask = TSL2591ReadDone;
+    sensor->read.doneArgs = (uint32_t *)sensor;
+    if (!I2CMasterSubmit(sensor->i2c, &sensor->read)) {
+        /* The I2C queue is full. Retry on the next timer tick, which a
+           periodic timer in continuous mode raises on its own. */
+        if (!sensor->isContinuous) TimerStart(sensor->timer);
+    }
+}
+
+/**
+ * @brief TSL2591EnableDone arms the integration timer once the sensor is
+ *        enabled. Called from the I2C interrupt.
+ * 
+ * @param args Pointer to the sensor.
+ */
+static void TSL2591EnableDone(uint32_t * args) {
+    TSL2591_t * sensor = (TSL2591_t *)args;
+    if (sensor->isBusy) TimerStart(sensor->timer);
+}
+
+void TSL2591SampleStart(TSL2591_t * sensor, bool isContinuous) {
+    /* Initialization asserts. */
+    assert(sensor != NULL);
+    if (sensor->isBusy) return;
+
+    /* 1. Set up the integration timer. Integration takes 100 ms per step,
+          plus a margin for the first cycle in single shot mode. */
+    uint32_t steps = sensor->time + (isContinuous ? 1 : 2);
+    TimerConfig_t timerConfig = {
+        .timerID=sensor->timerID,
+        .period=(uint64_t)(PLLGetFrequency() / 10) * steps,
+        .isIndividual=false,
+        .prescale=0,
+        .timerTask=TSL2591TimerDone,
+        .isPeriodic=isContinuous,
+        .priority=6,
+        .timerArgs=(uint32_t *)sensor
+    };
+    sensor->timer = TimerInit(timerConfig);
+
+    /* 2. Activate the internal oscillator and ALS sampler. The timer is armed
+          once the command completes. */
+    sensor->isContinuous = isContinuous;
+    sensor->isSampleReady = false;
+    sensor->isBusy = true;
+    TSL2591SubmitCommand(sensor, TSL2591_PON | TSL2591_AEN | TSL2591_AIEN | TSL2591_NPIEN, TSL2591EnableDone);
+}
+
+void TSL2591SampleStop(TSL2591_t * sensor) {
+    /* Initialization asserts. */
+    assert(sensor != NULL);
+    if (!sensor->isBusy) return;
+
+    /* Stop the timer, then deactivate the internal oscillator. */
+    sensor->isBusy = false;
+    TimerStop(sensor->timer);
+    while (I2CMasterIsBusy(sensor->i2c)) {}
+    TSL2591SubmitCommand(sensor, TSL2591_POFF, NULL);
 }
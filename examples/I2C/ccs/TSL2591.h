@@ -6,13 +6,21 @@
  * @date 2021-10-07
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support interrupts. This device
- * may require user tuning of the output. A feature to tune the device may be
- * provided at some point in the future.
+ * Asynchronous Sampling. TSL2591SampleStart enables the sensor through the I2C
+ * transaction queue and arms a hardware timer for the integration time. The
+ * timer then queues a single burst read of the status and both channels, and
+ * lux is computed in fixed point from the I2C interrupt before sampleTask is
+ * called. In continuous mode the sensor stays enabled and is read once every
+ * integration time, which is the maximum rate of the sensor.
+ *
+ * Unsupported Features. This driver does not support the sensor's interrupt
+ * pin. This device may require user tuning of the output. A feature to tune
+ * the device may be provided at some point in the future.
  */
 #pragma once
 
 #include <lib/I2C/I2C.h>
+#include <lib/Timer/Timer.h>
 
 
 /**
@@ -56,6 +64,32 @@ typedef struct TSL2591Config {
      * Default TSL2591_INTT_100MS. (100 ms)
      */
     enum TSL2591IntegrationTime time;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief The timer used to wait out the integration time of asynchronous
+     *        samples. Must not be used elsewhere.
+     * 
+     * Default TIMER_0A.
+     */
+    TimerID_t timerID;
+
+    /**
+     * @brief Pointer to function called from the I2C interrupt when an
+     *        asynchronous sample is ready.
+     * 
+     * Default is NULL (No function defined).
+     */
+    void (*sampleTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        sampleTask upon being called.
+     * 
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * sampleArgs;
 } TSL2591Config_t;
 
 /** @brief TSL2591_t is a struct containing user relevant data for a TSL2591
@@ -88,6 +122,43 @@ typedef struct TSL2591 {
     /** @brief The integration time of the sensor. */
     enum TSL2591IntegrationTime time;
 
+    /** @brief Set when an asynchronous sample updates the measurements. */
+    volatile bool isSampleReady;
+
+    /** @brief Whether an asynchronous sample is in progress. */
+    volatile bool isBusy;
+
+    /** ------------- Internal Fields. ------------- */
+
+    /** @brief Whether asynchronous samples repeat until stopped. */
+    bool isContinuous;
+
+    /** @brief The timer waiting out the integration time. */
+    TimerID_t timerID;
+
+    /** @brief The timer initialized on the first asynchronous sample. */
+    Timer_t timer;
+
+    /** @brief User function called when an asynchronous sample is ready. */
+    void (*sampleTask)(uint32_t *args);
+
+    /** @brief User args associated with the sample function. */
+    uint32_t * sampleArgs;
+
+    /** @brief Queued enable and disable command. */
+    I2CTransaction_t command;
+
+    /** @brief Queued burst read of the status and channel registers. */
+    I2CTransaction_t read;
+
+    /** @brief Bytes written by the queued command. */
+    uint8_t commandBytes[2];
+
+    /** @brief Register address written by the queued read. */
+    uint8_t readAddress;
+
+    /** @brief Status, CH0 and CH1 bytes read by the queued read. */
+    uint8_t readBytes[5];
 } TSL2591_t;
 
 /**
@@ -120,3 +191,23 @@ void TSL2591Enable(TSL2591_t * sensor);
  * @param sensor Sensor to sample.
  */
 void TSL2591Sample(TSL2591_t * sensor);
+
+/**
+ * @brief TSL2591SampleStart starts an asynchronous sample of a given TSL2591
+ *        sensor and returns immediately. The measurement values are updated
+ *        from interrupts; isSampleReady is then set and sampleTask is called.
+ * 
+ * @param sensor Sensor to sample. Must remain valid while sampling.
+ * @param isContinuous Whether to keep sampling once every integration time
+ *                     until TSL2591SampleStop is called.
+ * @note Do not mix asynchronous and blocking calls while sampling.
+ */
+void TSL2591SampleStart(TSL2591_t * sensor, bool isContinuous);
+
+/**
+ * @brief TSL2591SampleStop stops asynchronous sampling of a given TSL2591
+ *        sensor and disables it.
+ * 
+ * @param sensor Sensor to stop.
+ */
+void TSL2591SampleStop(TSL2591_t * sensor);
@@ -0,0 +1,83 @@
+/**
+ * @file I2CTimingHost.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Checks I2CGetTimerPeriod at every PLL system clock on a Linux host.
+ * @version 0.1
+ * @date 2022-03-13
+ * @copyright Copyright (c) 2022
+ * @note
+ * Build and run from the repository root with `make test`.
+ *
+ * The system clock is set to each of BUS_80_MHZ to BUS_3_125_MHZ through the
+ * register simulator, and the timer period of each I2CSpeed is computed at
+ * the frequency PLLGetFrequency reports. The resulting SCL frequency must not
+ * exceed the rate of the speed. It must also be the fastest that does not:
+ * one period less would exceed it, unless the period is 0 or saturated.
+ */
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/RegSim/RegSim.h>
+#include <lib/PLL/PLL.h>
+#include <lib/I2C/I2C.h>
+
+
+/** @brief The highest SCL frequency of each I2CSpeed, in Hz. High speed mode
+ *         is specified up to 3.4 MHz. */
+static const uint32_t speeds[4] = { 100000, 400000, 1000000, 3400000 };
+
+/** Returns the SCL frequency of a timer period, rounded down. */
+static uint32_t getSCLFrequency(uint32_t systemClock, enum I2CSpeed speed, uint32_t tpr) {
+    uint32_t sclClocks = (speed == I2C_SPEED_3_33_MBPS) ? 3 : 10;
+    return systemClock / (2 * (tpr + 1) * sclClocks);
+}
+
+/** Returns whether the SCL frequency of a timer period exceeds a rate. Exact,
+ *  unlike comparing the rounded frequency. */
+static bool isTooFast(uint32_t systemClock, enum I2CSpeed speed, uint32_t tpr) {
+    uint64_t sclClocks = (speed == I2C_SPEED_3_33_MBPS) ? 3 : 10;
+    return systemClock > (uint64_t)speeds[speed] * 2 * (tpr + 1) * sclClocks;
+}
+
+int main(void) {
+    unsigned numFailures = 0;
+
+    RegSimReset();
+    uint32_t divisor;
+    for (divisor = BUS_80_MHZ; divisor <= BUS_3_125_MHZ; ++divisor) {
+        uint32_t systemClock = PLLSetClock(PLL_SOURCE_PLL, divisor);
+        if (systemClock != PLLGetFrequency()) {
+            fprintf(stderr, "divisor %u: PLLGetFrequency does not match.\n", divisor);
+            ++numFailures;
+        }
+
+        uint8_t speed;
+        for (speed = I2C_SPEED_100_KBPS; speed <= I2C_SPEED_3_33_MBPS; ++speed) {
+            uint8_t tpr = I2CGetTimerPeriod(systemClock, speed);
+            if (isTooFast(systemClock, speed, tpr)) {
+                fprintf(
+                    stderr, "%u Hz, %u Hz: TPR %u gives %u Hz.\n",
+                    systemClock, speeds[speed], tpr,
+                    getSCLFrequency(systemClock, speed, tpr)
+                );
+                ++numFailures;
+            } else if (tpr > 0 && tpr < 0x7F && !isTooFast(systemClock, speed, tpr - 1)) {
+                fprintf(
+                    stderr, "%u Hz, %u Hz: TPR %u is slower than needed.\n",
+                    systemClock, speeds[speed], tpr
+                );
+                ++numFailures;
+            }
+        }
+    }
+
+    if (numFailures > 0) {
+        fprintf(stderr, "I2CTimingHost: %u failed.\n", numFailures);
+        return EXIT_FAILURE;
+    }
+    printf("I2CTimingHost: passed.\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file TSL2591Host.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Checks the fixed point TSL2591 lux conversion against the original
+ *        floating point formula on a Linux host, and times both.
+ * @version 0.1
+ * @date 2022-03-13
+ * @copyright Copyright (c) 2022
+ * @note
+ * Build and run from the repository root with `make sweep`. Each setting is
+ * checked in its own process; expect a few minutes per core.
+ *
+ * TSL2591Update is static, so the driver source is included here. The ccs and
+ * keil copies of TSL2591.c are identical; the ccs copy is checked.
+ *
+ * Every CH0/CH1 pair (the full 16 bit space) is converted with each of the 24
+ * gain and integration time settings. Both lux and irradiance must be within
+ * TSL2591_MAX_ERROR of the floating point reference. Then both conversions are
+ * timed over the full space of one setting.
+ */
+#define _DEFAULT_SOURCE
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/** Device specific imports. */
+#include "../ccs/TSL2591.c"
+
+
+/** @brief TSL2591_MAX_ERROR is the largest difference allowed from the
+ *         floating point reference, in lux or W/m^2. */
+#define TSL2591_MAX_ERROR 1
+
+/**
+ * @brief TSL2591UpdateFloat is the floating point conversion TSL2591Update
+ *        replaced. The original cast a negative lux to uint32_t, which is
+ *        undefined; it is clamped to 0 here, as TSL2591Update does.
+ *
+ * @param sensor Sensor to update.
+ * @param ch0 Full spectrum channel count.
+ * @param ch1 IR channel count.
+ */
+static void TSL2591UpdateFloat(TSL2591_t * sensor, uint16_t ch0, uint16_t ch1) {
+    sensor->raw = ((uint32_t)ch1 << 16) | ch0;
+    sensor->full = ch0;
+    sensor->ir = ch1;
+    sensor->visible = sensor->full - sensor->ir;
+
+    if ((sensor->full == 0xFFFF) | (sensor->ir == 0xFFFF)) {
+        sensor->lux = 0;
+        return;
+    }
+
+    static const float again[4] = { 1.0F, 25.0F, 428.0F, 9876.0F };
+    float atime = 100.0F + 100.0F * sensor->time;
+    float cpl = (atime * again[sensor->gain]) / 408.0F;
+    float lux1 = ((float) sensor->full - (1.64F * (float) sensor->ir)) / cpl;
+    float lux2 = ((0.59F * (float) sensor->full) - (0.86F * (float) sensor->ir)) / cpl;
+    float lux3 = lux1 > lux2 ? lux1 : lux2;
+    if (lux3 < 0.0F) lux3 = 0.0F;
+    sensor->lux = (uint32_t) lux3;
+    sensor->irradiance = (uint32_t)(lux3 * 0.0083333);
+}
+
+/** @brief Error_t is the worst difference found for one setting. */
+typedef struct Error {
+    uint32_t lux;
+    uint32_t irradiance;
+    uint16_t ch0;
+    uint16_t ch1;
+} Error_t;
+
+/** Returns the absolute difference of two unsigned values. */
+static uint32_t difference(uint32_t a, uint32_t b) {
+    return a > b ? a - b : b - a;
+}
+
+/** Returns the largest differences between both conversions over one row of
+ *  CH0/CH1 pairs, and stops at the first pair reaching them if asked. */
+static Error_t compareRow(const TSL2591_t * setting, uint16_t ch0, const Error_t * stop) {
+    TSL2591_t fixed = *setting;
+    TSL2591_t reference = *setting;
+    Error_t row = { .ch0=ch0 };
+
+    uint32_t ch1;
+    for (ch1 = 0; ch1 <= 0xFFFF; ++ch1) {
+        TSL2591Update(&fixed, ch0, ch1);
+        TSL2591UpdateFloat(&reference, ch0, ch1);
+
+        uint32_t lux = difference(fixed.lux, reference.lux);
+        uint32_t irradiance = difference(fixed.irradiance, reference.irradiance);
+        if (lux > row.lux) row.lux = lux;
+        if (irradiance > row.irradiance) row.irradiance = irradiance;
+        if (stop != NULL && (lux >= stop->lux || irradiance >= stop->irradiance)) {
+            row.ch1 = ch1;
+            break;
+        }
+    }
+    return row;
+}
+
+/** Compares both conversions over every CH0/CH1 pair of one setting. */
+static Error_t compareSetting(enum TSL2591Gain gain, enum TSL2591IntegrationTime time) {
+    TSL2591_t setting = { .gain=gain, .time=time };
+    Error_t worst = { 0 };
+
+    /* Rows are scanned for their largest differences only. The few rows that
+       raise the worst so far are scanned again for the pair. */
+    uint32_t ch0;
+    for (ch0 = 0; ch0 <= 0xFFFF; ++ch0) {
+        Error_t row = compareRow(&setting, ch0, NULL);
+        if (row.lux > worst.lux || row.irradiance > worst.irradiance) {
+            Error_t stop = {
+                .lux=row.lux > worst.lux ? row.lux : UINT32_MAX,
+                .irradiance=row.irradiance > worst.irradiance ? row.irradiance : UINT32_MAX
+            };
+            worst.ch1 = compareRow(&setting, ch0, &stop).ch1;
+            worst.ch0 = ch0;
+            if (row.lux > worst.lux) worst.lux = row.lux;
+            if (row.irradiance > worst.irradiance) worst.irradiance = row.irradiance;
+        }
+    }
+    return worst;
+}
+
+/** Returns the monotonic time in seconds. */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/** Returns the mean nanoseconds per call of a conversion over every CH0/CH1
+ *  pair of one setting. */
+static double timeConversion(void (*update)(TSL2591_t *, uint16_t, uint16_t)) {
+    TSL2591_t sensor = { .gain=TSL2591_GAIN_MED, .time=TSL2591_INTT_200MS };
+    volatile uint32_t sink = 0;
+
+    double start = now();
+    uint32_t ch0, ch1;
+    for (ch0 = 0; ch0 <= 0xFFFF; ++ch0) {
+        for (ch1 = 0; ch1 <= 0xFFFF; ++ch1) {
+            update(&sensor, ch0, ch1);
+            sink += sensor.lux;
+        }
+    }
+    (void)sink;
+    return (now() - start) * 1e9 / (65536.0 * 65536.0);
+}
+
+int main(void) {
+    static const char * gains[4] = { "1x", "25x", "428x", "9876x" };
+    bool isPassing = true;
+
+    /* 1. Compare each setting in a child process, which writes back its worst
+          difference through a pipe. */
+    int results[4][6];
+    uint8_t gain, time;
+    for (gain = TSL2591_GAIN_LOW; gain <= TSL2591_GAIN_MAX; ++gain) {
+        for (time = TSL2591_INTT_100MS; time <= TSL2591_INTT_600MS; ++time) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                perror("pipe");
+                return EXIT_FAILURE;
+            }
+            if (fork() == 0) {
+                close(fds[0]);
+                Error_t worst = compareSetting(gain, time);
+                ssize_t size = write(fds[1], &worst, sizeof(worst));
+                _exit(size == sizeof(worst) ? EXIT_SUCCESS : EXIT_FAILURE);
+            }
+            close(fds[1]);
+            results[gain][time] = fds[0];
+        }
+    }
+
+    /* 2. Report them in order. */
+    printf("gain,time_ms,max_lux_error,max_irradiance_error,ch0,ch1\n");
+    for (gain = TSL2591_GAIN_LOW; gain <= TSL2591_GAIN_MAX; ++gain) {
+        for (time = TSL2591_INTT_100MS; time <= TSL2591_INTT_600MS; ++time) {
+            Error_t worst;
+            if (read(results[gain][time], &worst, sizeof(worst)) != sizeof(worst)) {
+                fprintf(stderr, "%s, %u ms: no result.\n", gains[gain], 100 * (time + 1));
+                isPassing = false;
+                continue;
+            }
+            close(results[gain][time]);
+            printf(
+                "%s,%u,%u,%u,%u,%u\n",
+                gains[gain], 100 * (time + 1), worst.lux, worst.irradiance,
+                worst.ch0, worst.ch1
+            );
+            if (worst.lux > TSL2591_MAX_ERROR || worst.irradiance > TSL2591_MAX_ERROR) {
+                isPassing = false;
+            }
+        }
+    }
+    while (wait(NULL) > 0) {}
+
+    /* 3. Time both conversions. */
+    printf("fixed point: %.2f ns per conversion\n", timeConversion(TSL2591Update));
+    printf("float: %.2f ns per conversion\n", timeConversion(TSL2591UpdateFloat));
+
+    if (!isPassing) {
+        fprintf(stderr, "TSL2591Host: error above %d.\n", TSL2591_MAX_ERROR);
+        return EXIT_FAILURE;
+    }
+    printf("TSL2591Host: passed.\n");
+    return EXIT_SUCCESS;
+}
@@ -6,7 +6,12 @@
  * @version 0.1
  * @date 2021-10-07
  * @copyright Copyright (c) 2021
+ * @note
+ * Modify __MAIN__ on L14 to determine which main method is executed.
+ * __MAIN__ = 0 - Blocking sampling of a TSL2591 every half second.
+ *          = 1 - Asynchronous continuous sampling of a TSL2591.
  */
+#define __MAIN__ 0
 
 /** General imports. */
 #include <stdio.h>
@@ -22,6 +27,7 @@ void EnableInterrupts(void);    // Defined in startup.s
 void DisableInterrupts(void);   // Defined in startup.s
 void WaitForInterrupt(void);    // Defined in startup.s
 
+#if __MAIN__ == 0
 int main(void) {
     /**
      * This program demonstrates initializing a TSL2591 and polling it
@@ -55,3 +61,51 @@ int main(void) {
         DelayMillisec(500);
     };
 }
+#elif __MAIN__ == 1
+volatile uint32_t numSamples = 0;
+volatile uint32_t lux = 0;
+void sampleReady(uint32_t * args) {
+    TSL2591_t * sensor = (TSL2591_t *)args;
+    lux = sensor->lux;
+    ++numSamples;
+}
+
+TSL2591_t sensor;
+int main(void) {
+    /**
+     * This program demonstrates sampling a TSL2591 at its maximum rate
+     * without blocking. The sensor is read from interrupts once every
+     * integration time, and the main loop sleeps in between.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    /* Initialize SysTick for delay calls. */
+    DelayInit();
+
+    /* Initialize an I2C device. */
+    I2CConfig_t i2cConfig = {
+        .module=I2C_MODULE_0, // This uses pins PB2 (SCL) and PB3 (SDA).
+        .speed=I2C_SPEED_400_KBPS
+    };
+
+    /* Initialize a TSL2591 sensor. */
+    TSL2591Config_t sensorConfig = {
+        .i2cConfig=i2cConfig,
+        .gain=TSL2591_GAIN_LOW,
+        .time=TSL2591_INTT_100MS,
+        .timerID=TIMER_0A,
+        .sampleTask=sampleReady,
+        .sampleArgs=(uint32_t *)&sensor
+    };
+
+    sensor = TSL2591Init(sensorConfig);
+
+    EnableInterrupts();
+    TSL2591SampleStart(&sensor, true);
+    while (1) {
+        /* Put a breakpoint on lux or numSamples to view new samples. */
+        WaitForInterrupt();
+    };
+}
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file LogExample.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief An example project showing how to use the deferred logging driver.
+ * @version 0.1
+ * @date 2022-03-08
+ * @copyright Copyright (c) 2022
+ * @note
+ * Modify __MAIN__ on L13 to determine which main method is executed.
+ * __MAIN__ = 0 - Logging from a timer interrupt, drained over UART_MODULE_0.
+ */
+#define __MAIN__ 0
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/Timer/Timer.h>
+#include <lib/UART/UART.h>
+#include <lib/Log/Log.h>
+
+
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+
+#if __MAIN__ == 0
+/**
+ * @brief LogTick logs a counter from the timer interrupt. Only the format
+ *        pointer and arguments are stored, so this is a few dozen cycles.
+ *
+ * @param args Unused.
+ */
+void LogTick(uint32_t * args) {
+    static uint32_t count = 0;
+    ++count;
+    LOG("tick %u, 0x%08x", count, count * 0x10001);
+    if (count % 10 == 0) LOG("%u seconds", count / 10);
+}
+
+int main(void) {
+    /**
+     * @brief This program demonstrates logging from an interrupt at 10 Hz.
+     *        The idle loop formats the records and sends them to the user PC
+     *        at 115200 baud. Note that only UART0 on the TM4C is connected
+     *        through USB. No other hardware configuration outside of the TM4C
+     *        Tiva C Launchpad is required for this example. A serial monitor
+     *        application like PuTTy should be open.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_0,
+        .baudrate=115200
+    };
+    UART_t uart = UARTInit(uartConfig);
+
+    LogInit();
+    LOG("log example started at %u Hz", PLLGetFrequency());
+
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_0A,
+        .period=freqToPeriod(10, MAX_FREQ),
+        .timerTask=LogTick,
+        .isPeriodic=true,
+        .priority=5
+    };
+    Timer_t timer = TimerInit(timerConfig);
+    TimerStart(timer);
+
+    EnableInterrupts();
+    while (1) {
+        /* Format a few records at a time, then sleep until the next tick. */
+        LogFlush(uart, 4);
+        WaitForInterrupt();
+    }
+}
+#endif
@@ -14,6 +14,8 @@
  * Modify __MAIN__ on L18 to determine which main method is executed.
  * __MAIN__ = 0 - Initialization and management of a timer acting as a PWM for low freq.
  *          = 1 - Initialization and management of a PWM module for high freq.
+ *          = 2 - Initialization and management of a uDMA fed timer PWM driving
+ *                a WS2812 LED strip.
  */
 #define __MAIN__ 0
 
@@ -137,4 +139,64 @@ int main(void) {
         dutyCycle = (dutyCycle + 1)%100;
     }
 }
+#elif __MAIN__ == 2
+/** @brief Number of LEDs on the strip. */
+#define NUM_LEDS 8
+
+/** @brief Color of each LED, in G, R, B order. */
+static uint8_t colors[NUM_LEDS * 3];
+
+/** @brief Match values for each bit of colors. */
+static uint32_t matches[NUM_LEDS * 3 * 8];
+
+int main(void) {
+    /**
+     * This program demonstrates streaming WS2812 data out of PB6 with a
+     * timer PWM fed by the uDMA. The CPU only encodes the next frame; every
+     * bit is timed by hardware. Connect PB6 to the data line of a WS2812
+     * strip.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    /* Initialize SysTick for delay calls.*/
+    DelayInit();
+
+    /* 800 kHz bit rate. */
+    uint16_t period = freqToPeriod(800000, MAX_FREQ);
+    PWMConfig_t pwmConfigPB6 = {
+        .source=PWM_SOURCE_WAVEFORM,
+        .sourceInfo={
+            .waveformSelect={
+                .pin=PIN_B6,
+                .timerID=TIMER_0A,
+                .period=period,
+                .isLooping=false,
+                .doneTask=NULL,
+                .doneArgs=NULL
+            }
+        }
+    };
+
+    PWM_t pwm = PWMInit(pwmConfigPB6);
+    PWMStart(pwm);
+
+    EnableInterrupts();
+
+    uint8_t head = 0;
+    while (1) {
+        /* A single green LED should chase down the strip. */
+        uint8_t i;
+        for (i = 0; i < NUM_LEDS * 3; ++i) colors[i] = 0;
+        colors[head * 3] = 0x20;
+        head = (head + 1) % NUM_LEDS;
+
+        /* Wait for the previous frame to finish streaming. */
+        while (PWMWaveformIsBusy(pwm)) {}
+        PWMWaveformEncodeWS2812(period, colors, NUM_LEDS * 3, matches);
+        PWMWaveformWrite(pwm, matches, NUM_LEDS * 3 * 8);
+
+        DelayMillisec(100);
+    }
+}
 #endif
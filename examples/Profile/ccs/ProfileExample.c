@@ -0,0 +1,116 @@
+/**
+ * @file ProfileExample.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief An example project showing how to use the interrupt profiler.
+ * @version 0.1
+ * @date 2022-03-10
+ * @copyright Copyright (c) 2022
+ * @note
+ * Modify __MAIN__ on L16 to determine which main method is executed.
+ * __MAIN__ = 0 - Profiling a timer, SysTick and a switch, reported over
+ *                UART_MODULE_0.
+ *
+ * The project defines `-D__PROFILE__` in the C/C++ Misc Options (keil) or the
+ * predefined symbols (ccs). Remove it to compile the profiler out.
+ */
+#define __MAIN__ 0
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/GPIO/GPIO.h>
+#include <lib/Timer/Timer.h>
+#include <lib/UART/UART.h>
+#include <lib/Profile/Profile.h>
+
+
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+
+#if __MAIN__ == 0
+/** @brief Keeps the busy work from being optimized out. */
+static volatile uint32_t sink;
+
+/**
+ * @brief ControlTick stands in for a control loop whose work varies from tick
+ *        to tick, so the histogram has more than one bin.
+ *
+ * @param args Unused.
+ */
+void ControlTick(uint32_t * args) {
+    static uint32_t count = 0;
+    uint32_t work = (++count % 16) * 64;
+    uint32_t i;
+    for (i = 0; i < work; ++i) sink += i;
+}
+
+/**
+ * @brief SwitchPressed toggles the red LED on PF1.
+ *
+ * @param args Unused.
+ */
+void SwitchPressed(uint32_t * args) {
+    GPIOSetBit(PIN_F1, !GPIOGetBit(PIN_F1));
+}
+
+int main(void) {
+    /**
+     * @brief This program profiles a 1 kHz timer task, the SysTick used for
+     *        delays, and SW1 (PF4). Once a second the statistics table is sent
+     *        to the user PC at 115200 baud as CSV; see Profile.h for the
+     *        columns. Note that only UART0 on the TM4C is connected through
+     *        USB. No other hardware configuration outside of the TM4C Tiva C
+     *        Launchpad is required for this example. A serial monitor
+     *        application like PuTTy should be open.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+    DelayInit();
+    ProfileInit();
+
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_0,
+        .baudrate=115200
+    };
+    UART_t uart = UARTInit(uartConfig);
+
+    GPIOConfig_t ledConfig = {
+        .pin=PIN_F1,
+        .pull=GPIO_PULL_DOWN,
+        .isOutput=true
+    };
+    GPIOInit(ledConfig);
+
+    GPIOConfig_t switchConfig = {
+        .pin=PIN_F4,
+        .pull=GPIO_PULL_UP
+    };
+    GPIOInterruptConfig_t switchIntConfig = {
+        .priority=3,
+        .touchTask=NULL,
+        .releaseTask=SwitchPressed,
+        .pinStatus=RAISED
+    };
+    GPIOIntInit(switchConfig, switchIntConfig);
+
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_0A,
+        .period=freqToPeriod(1000, MAX_FREQ),
+        .timerTask=ControlTick,
+        .isPeriodic=true,
+        .priority=5
+    };
+    Timer_t timer = TimerInit(timerConfig);
+    TimerStart(timer);
+
+    EnableInterrupts();
+    while (1) {
+        ProfileReport(uart);
+        DelayMillisec(1000);
+    }
+}
+#endif
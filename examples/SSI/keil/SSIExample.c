@@ -5,7 +5,12 @@
  * @version 0.1
  * @date 2021-09-23
  * @copyright Copyright (c) 2021
+ * @note
+ * Modify __MAIN__ on L13 to determine which main method is executed.
+ * __MAIN__ = 0 - Initialization and management of a single SPI device.
+ *          = 1 - Benchmark of switching between devices on a shared SPI bus.
  */
+#define __MAIN__ 0
 
 /** General imports. */
 #include <stdlib.h>
@@ -20,6 +25,7 @@ void EnableInterrupts(void);    // Defined in startup.s
 void DisableInterrupts(void);   // Defined in startup.s
 void WaitForInterrupt(void);    // Defined in startup.s
 
+#if __MAIN__ == 0
 #define BUFFER_SIZE 16
 uint16_t receiveBuffer[BUFFER_SIZE] = { 0 };
 void sendSSI(uint32_t * args) {
@@ -91,3 +97,112 @@ int main(void) {
         WaitForInterrupt();
     };
 }
+
+#elif __MAIN__ == 1
+/** @brief Cycle counts for each benchmark, viewable in the watch window. */
+uint32_t selectSameCycles = 0;
+uint32_t selectSwitchCycles = 0;
+uint32_t transferSameCycles = 0;
+uint32_t transferSwitchCycles = 0;
+
+#define ITERATIONS 100
+
+int main(void) {
+    /**
+     * This program measures the cost of switching between two devices on a
+     * shared SPI bus. The display runs 8 bit frames at 10 MHz and the sensor
+     * runs 16 bit frames at 1 MHz, so every switch between them rewrites CR0
+     * and CPSR. Switching to the same device only toggles its chip select.
+     *
+     * This is in loopback mode so no external device is needed. Run the
+     * program, pause it once it reaches WaitForInterrupt, and view the cycle
+     * counts (average per iteration) in the watch window.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    SSIConfig_t ssiConfig = {
+        .ssi=SSI2_PB,
+        .dataSize=SSI_SIZE_8,
+        .ssiPrescaler=8,
+        .ssiClockModifier=0,
+        .isReceiving=false,
+        .frameFormat=FREESCALE_SPI,
+        .isSecondary=false,
+        .isClockLow=false,
+        .polarity=SSI_FIRST_EDGE,
+        .isLoopback=true, /* Set this to false for your own devices! */
+        .isManualChipSelect=true,
+        .priority=2
+    };
+    SSIInit(ssiConfig);
+
+    SPIDeviceConfig_t displayConfig = {
+        .ssi=SSI2_PB,
+        .chipSelect=PIN_B5,
+        .dataSize=SSI_SIZE_8,
+        .ssiPrescaler=8
+    };
+    SPIDevice_t display = SPIDeviceInit(displayConfig);
+
+    SPIDeviceConfig_t sensorConfig = {
+        .ssi=SSI2_PB,
+        .chipSelect=PIN_B2,
+        .dataSize=SSI_SIZE_16,
+        .ssiPrescaler=80
+    };
+    SPIDevice_t sensor = SPIDeviceInit(sensorConfig);
+
+    /* A free running 32 bit timer counting down at the bus clock. */
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_0A,
+        .period=0xFFFFFFFF,
+        .isPeriodic=true,
+        .priority=7
+    };
+    Timer_t timer = TimerInit(timerConfig);
+    TimerStart(timer);
+
+    EnableInterrupts();
+
+    uint16_t frame = 0xA5;
+    uint32_t start;
+    uint8_t i;
+
+    /* 1. Select and deselect the same device. */
+    start = (uint32_t)TimerGetValue(timer);
+    for (i = 0; i < ITERATIONS; ++i) {
+        SPIDeviceSelect(&display);
+        SPIDeviceDeselect(&display);
+    }
+    selectSameCycles = (start - (uint32_t)TimerGetValue(timer)) / ITERATIONS;
+
+    /* 2. Alternate between devices. */
+    start = (uint32_t)TimerGetValue(timer);
+    for (i = 0; i < ITERATIONS; ++i) {
+        SPIDevice_t * device = (i % 2) ? &sensor : &display;
+        SPIDeviceSelect(device);
+        SPIDeviceDeselect(device);
+    }
+    selectSwitchCycles = (start - (uint32_t)TimerGetValue(timer)) / ITERATIONS;
+
+    /* 3. Queued single frame transactions with the same device. Includes the
+          frame time on the wire. */
+    start = (uint32_t)TimerGetValue(timer);
+    for (i = 0; i < ITERATIONS; ++i) {
+        SPIDeviceTransfer(&display, &frame, NULL, 1);
+    }
+    transferSameCycles = (start - (uint32_t)TimerGetValue(timer)) / ITERATIONS;
+
+    /* 4. Queued single frame transactions alternating between devices. */
+    start = (uint32_t)TimerGetValue(timer);
+    for (i = 0; i < ITERATIONS; ++i) {
+        SPIDeviceTransfer((i % 2) ? &sensor : &display, &frame, NULL, 1);
+    }
+    transferSwitchCycles = (start - (uint32_t)TimerGetValue(timer)) / ITERATIONS;
+
+    while (1) {
+        WaitForInterrupt();
+    }
+}
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file TelemetryExample.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief An example project showing how to use the binary telemetry driver.
+ * @version 0.1
+ * @date 2022-03-09
+ * @copyright Copyright (c) 2022
+ * @note
+ * Modify __MAIN__ on L12 to determine which main method is executed.
+ * __MAIN__ = 0 - Streaming samples from a timer interrupt over UART_MODULE_0.
+ */
+#define __MAIN__ 0
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
+#include <lib/Timer/Timer.h>
+#include <lib/UART/UART.h>
+#include <lib/Telemetry/Telemetry.h>
+
+
+void EnableInterrupts(void);    // Defined in startup.s
+void DisableInterrupts(void);   // Defined in startup.s
+void WaitForInterrupt(void);    // Defined in startup.s
+
+
+#if __MAIN__ == 0
+/** @brief The channel IDs of this example. */
+enum TelemetryChannel {
+    CHANNEL_TICK,
+    CHANNEL_TRIANGLE,
+    CHANNEL_DROPPED
+};
+
+/**
+ * @brief TelemetryTick records a counter, a triangle wave and the drop count
+ *        from the timer interrupt.
+ *
+ * @param args Unused.
+ */
+void TelemetryTick(uint32_t * args) {
+    static int32_t count = 0;
+    ++count;
+    TelemetryRecord(CHANNEL_TICK, count);
+    TelemetryRecord(CHANNEL_TRIANGLE, abs((count % 2000) - 1000));
+    TelemetryRecord(CHANNEL_DROPPED, TelemetryGetDropped());
+}
+
+int main(void) {
+    /**
+     * @brief This program demonstrates streaming 3 channels at 1 kHz to the
+     *        user PC at 921600 baud. Frames of 32 samples are sent by the
+     *        uDMA while the CPU sleeps. Note that only UART0 on the TM4C is
+     *        connected through USB. No other hardware configuration outside of
+     *        the TM4C Tiva C Launchpad is required for this example. Run the
+     *        decoder in examples/Telemetry/host on the user PC to receive the
+     *        samples as CSV.
+     */
+    PLLInit(BUS_80_MHZ);
+    DisableInterrupts();
+
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_0,
+        .baudrate=921600,
+        .isDMA=true
+    };
+    UART_t uart = UARTInit(uartConfig);
+
+    TelemetryInit(uart);
+
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_0A,
+        .period=freqToPeriod(1000, MAX_FREQ),
+        .timerTask=TelemetryTick,
+        .isPeriodic=true,
+        .priority=5
+    };
+    Timer_t timer = TimerInit(timerConfig);
+    TimerStart(timer);
+
+    EnableInterrupts();
+    while (1) {
+        /* Hand a full batch to the uDMA, then sleep until the next tick. */
+        TelemetryService();
+        WaitForInterrupt();
+    }
+}
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file TelemetryDecoder.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Decodes a telemetry stream from a serial port, file or pty into CSV.
+ * @version 0.1
+ * @date 2022-03-09
+ * @copyright Copyright (c) 2022
+ * @note
+ * Build and run from the repository root:
+ *
+ *      gcc -std=c99 -O2 -o telemetry examples/Telemetry/host/TelemetryDecoder.c
+ *      ./telemetry /dev/ttyACM0 921600 samples.csv
+ *
+ * The baud rate only applies to serial ports, and defaults to 921600. Samples
+ * are written to the CSV file given or to stdout, one row per sample:
+ *
+ *      sequence,channel,timestamp,seconds,value
+ *
+ * Timestamps are unwrapped into a 64 bit cycle count. Seconds are accumulated
+ * from the cycle deltas and the clock in each frame header, so they stay
+ * correct across PLLSetClock. Bad CRCs, malformed frames and sequence gaps
+ * are reported on stderr, along with totals at the end of the stream. The
+ * frame format is described in lib/Telemetry/Telemetry.h.
+ */
+
+#define _DEFAULT_SOURCE
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+
+/** @brief The frame format this decoder understands. */
+#define TELEMETRY_VERSION 1
+
+/** @brief Sizes of the frame fields, as in Telemetry.h. */
+#define TELEMETRY_HEADER_SIZE 8
+#define TELEMETRY_SAMPLE_SIZE 9
+#define TELEMETRY_CRC_SIZE 2
+
+/** @brief The largest encoded frame accepted. Longer runs are discarded. */
+#define TELEMETRY_MAX_ENCODED 1024
+
+/** @brief The decoder state carried across frames. */
+static struct DecoderState {
+    FILE * csv;
+    bool isStarted;
+    uint16_t nextSequence;
+    uint32_t lastTimestamp;
+    uint64_t cycles;
+    double seconds;
+    unsigned long frames;
+    unsigned long samples;
+    unsigned long crcErrors;
+    unsigned long malformed;
+    unsigned long lostFrames;
+} state;
+
+/** Computes the CRC-16/CCITT-FALSE of a buffer, bitwise. */
+static uint16_t crc16(const uint8_t * bytes, size_t numBytes) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < numBytes; ++i) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/** Reads a little endian value. */
+static uint32_t get(const uint8_t * bytes, int numBytes) {
+    uint32_t value = 0;
+    while (numBytes-- > 0) value = (value << 8) | bytes[numBytes];
+    return value;
+}
+
+/** COBS decodes a frame without its delimiter. Returns the decoded length, or
+    -1 if the encoding is invalid. */
+static long cobsDecode(const uint8_t * encoded, size_t length, uint8_t * decoded) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < length) {
+        uint8_t code = encoded[in++];
+        if (code == 0 || in + code - 1 > length) return -1;
+        for (uint8_t i = 1; i < code; ++i) decoded[out++] = encoded[in++];
+        if (code != 0xFF && in < length) decoded[out++] = 0;
+    }
+    return (long)out;
+}
+
+/** Checks and writes out one frame. The first frame of a stream may be the
+    tail of one sent before we started listening, so it is dropped quietly
+    when it does not check out. */
+static void decodeFrame(const uint8_t * encoded, size_t length, bool isFirst) {
+    uint8_t frame[TELEMETRY_MAX_ENCODED];
+    long frameLength = cobsDecode(encoded, length, frame);
+    if (frameLength < TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE) {
+        if (isFirst) return;
+        ++state.malformed;
+        fprintf(stderr, "telemetry: malformed frame of %zu bytes\n", length);
+        return;
+    }
+
+    /* 1. Check the CRC before trusting any field. */
+    long payload = frameLength - TELEMETRY_CRC_SIZE;
+    if (crc16(frame, payload) != get(frame + payload, TELEMETRY_CRC_SIZE)) {
+        if (isFirst) return;
+        ++state.crcErrors;
+        fprintf(stderr, "telemetry: bad CRC\n");
+        return;
+    }
+
+    uint8_t version = frame[0];
+    uint8_t count = frame[1];
+    uint16_t sequence = get(frame + 2, 2);
+    uint32_t clock = get(frame + 4, 4);
+    if (version != TELEMETRY_VERSION ||
+        payload != TELEMETRY_HEADER_SIZE + count * TELEMETRY_SAMPLE_SIZE ||
+        clock == 0) {
+        ++state.malformed;
+        fprintf(stderr, "telemetry: unsupported frame (version %u)\n", version);
+        return;
+    }
+
+    /* 2. Count frames lost in between. */
+    if (state.isStarted && sequence != state.nextSequence) {
+        uint16_t lost = sequence - state.nextSequence;
+        state.lostFrames += lost;
+        fprintf(stderr, "telemetry: %u frames lost before %u\n", lost, sequence);
+    }
+    state.nextSequence = sequence + 1;
+    ++state.frames;
+
+    /* 3. Emit samples, unwrapping the 32 bit cycle counter. */
+    const uint8_t * sample = frame + TELEMETRY_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; ++i, sample += TELEMETRY_SAMPLE_SIZE) {
+        uint8_t channel = sample[0];
+        uint32_t timestamp = get(sample + 1, 4);
+        int32_t value = (int32_t)get(sample + 5, 4);
+
+        if (state.isStarted) {
+            uint32_t delta = timestamp - state.lastTimestamp;
+            state.cycles += delta;
+            state.seconds += (double)delta / clock;
+        } else {
+            state.cycles = timestamp;
+            state.seconds = (double)timestamp / clock;
+            state.isStarted = true;
+        }
+        state.lastTimestamp = timestamp;
+
+        fprintf(state.csv, "%u,%u,%llu,%.9f,%d\n", sequence, channel,
+                (unsigned long long)state.cycles, state.seconds, value);
+        ++state.samples;
+    }
+}
+
+/** Puts a serial port into raw mode at a baud rate. */
+static bool configureSerial(int fd, unsigned long baudrate) {
+    static const struct { unsigned long rate; speed_t speed; } speeds[] = {
+        { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 },
+        { 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 },
+        { 460800, B460800 }, { 921600, B921600 }, { 1000000, B1000000 },
+        { 2000000, B2000000 }, { 3000000, B3000000 }
+    };
+
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0) return false;
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+        if (speeds[i].rate == baudrate) {
+            cfsetispeed(&tty, speeds[i].speed);
+            cfsetospeed(&tty, speeds[i].speed);
+            return tcsetattr(fd, TCSANOW, &tty) == 0;
+        }
+    }
+    fprintf(stderr, "telemetry: unsupported baud rate %lu\n", baudrate);
+    return false;
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <device or file> [baudrate] [output.csv]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = open(argv[1], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    unsigned long baudrate = (argc > 2) ? strtoul(argv[2], NULL, 10) : 921600;
+    if (isatty(fd) && !configureSerial(fd, baudrate)) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    state.csv = stdout;
+    if (argc > 3) {
+        state.csv = fopen(argv[3], "w");
+        if (state.csv == NULL) {
+            perror(argv[3]);
+            return EXIT_FAILURE;
+        }
+    }
+    fputs("sequence,channel,timestamp,seconds,value\n", state.csv);
+
+    /* Split the stream on delimiters. */
+    uint8_t encoded[TELEMETRY_MAX_ENCODED];
+    size_t length = 0;
+    bool isFirst = true;
+    bool isOverlong = false;
+    uint8_t buffer[4096];
+    ssize_t numRead;
+    while ((numRead = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < numRead; ++i) {
+            if (buffer[i] != 0) {
+                if (length < sizeof(encoded)) encoded[length++] = buffer[i];
+                else isOverlong = true;
+                continue;
+            }
+
+            if (isOverlong) {
+                ++state.malformed;
+                fprintf(stderr, "telemetry: overlong frame discarded\n");
+            } else if (length > 0) {
+                decodeFrame(encoded, length, isFirst);
+            }
+            isFirst = false;
+            isOverlong = false;
+            length = 0;
+        }
+        fflush(state.csv);
+    }
+
+    fprintf(stderr, "telemetry: %lu frames, %lu samples, %lu CRC errors, "
+            "%lu malformed, %lu frames lost\n", state.frames, state.samples,
+            state.crcErrors, state.malformed, state.lostFrames);
+
+    if (state.csv != stdout) fclose(state.csv);
+    close(fd);
+    return EXIT_SUCCESS;
+}
@@ -49,7 +49,7 @@ int main(void) {
     /* Configure a UART device for communication. */
     UARTConfig_t config = {
         .module=UART_MODULE_1,
-        .baudrate=UART_BAUD_9600,
+        .baudrate=9600,
         .dataLength=UART_BITS_8,
         .isFIFODisabled=false,
         .isTwoStopBits=false,
@@ -94,7 +94,7 @@ int main(void) {
 
     UARTConfig_t config = {
         .module=UART_MODULE_0,
-        .baudrate=UART_BAUD_9600,
+        .baudrate=9600,
         .dataLength=UART_BITS_8,
         .isFIFODisabled=false,
         .isTwoStopBits=false,
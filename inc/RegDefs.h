@@ -10,9 +10,15 @@
 
 /** 
  * Function for generating code for getting a register. Left hand side of
- * assignment only. 
+ * assignment only. Host builds (`-D__HOST__`) go through the simulated
+ * register file in lib/RegSim instead.
  */
+#ifdef __HOST__
+#include <lib/RegSim/RegSim.h>
+#define GET_REG(addr) (*RegSimAccess((uint32_t)(addr)))
+#else
 #define GET_REG(addr) (*((volatile int32_t *)(addr)))
+#endif
 
 /** Used for acknowledging Timer A and Timer B interrupt flag. */
 #define TIMERXA_ICR_TATOCINT 0x00000001
@@ -66,7 +72,22 @@
 #define SYSTICK_CTRL_OFFSET 0x010
 #define SYSTICK_LOAD_OFFSET 0x014
 #define SYSTICK_CURR_OFFSET 0x018
+#define SYS_INTCTRL_OFFSET  0xD04
+#define SYS_APINT_OFFSET    0xD0C
 #define SYS_PRI3_OFFSET     0xD20
+#define SYS_CFSR_OFFSET     0xD28
+#define SYS_HFSR_OFFSET     0xD2C
+#define SYS_MMFAR_OFFSET    0xD34
+#define SYS_BFAR_OFFSET     0xD38
+#define DEMCR_OFFSET        0xDFC
+
+/**
+ * Data Watchpoint and Trace unit. See the ARM Cortex-M4 Technical Reference
+ * Manual for more details. Used for cycle counting.
+ */
+#define DWT_BASE            0xE0001000
+#define DWT_CTRL_OFFSET     0x000
+#define DWT_CYCCNT_OFFSET   0x004
 
 /**
  * See Table 5-8. System Control Register Map on p. 232 of the TM4C Datasheet
@@ -74,10 +95,12 @@
  */
 #define SYSCTL_BASE                 0x400FE000
 #define SYSCTL_RIS_OFFSET           0x050
+#define SYSCTL_MISC_OFFSET          0x058
 #define SYSCTL_RCC_OFFSET           0x060
 #define SYSCTL_RCC2_OFFSET          0x070
 #define SYSCTL_RCGCTIMER_OFFSET     0x604
 #define SYSCTL_RCGCGPIO_OFFSET      0x608
+#define SYSCTL_RCGCDMA_OFFSET       0x60C
 #define SYSCTL_RCGCUART_OFFSET      0x618
 #define SYSCTL_RCGCSSI_OFFSET       0x61C
 #define SYSCTL_RCGCI2C_OFFSET       0x620
@@ -88,6 +111,7 @@
 
 #define SYSCTL_PRTIMER_OFFSET       0xA04
 #define SYSCTL_PRGPIO_OFFSET        0xA08
+#define SYSCTL_PRDMA_OFFSET         0xA0C
 #define SYSCTL_PRUART_OFFSET        0xA18
 #define SYSCTL_PRSSI_OFFSET         0xA1C
 #define SYSCTL_PRI2C_OFFSET         0xA20
@@ -96,6 +120,35 @@
 #define SYSCTL_PRPWM_OFFSET         0xA40
 #define SYSCTL_PRWTIMER_OFFSET      0xA5C
 
+/**
+ * See Table 9-3. uDMA Register Map on p. 613 of the TM4C Datasheet for more
+ * details.
+ */
+#define UDMA_BASE               0x400FF000
+#define UDMA_STAT_OFFSET        0x000
+#define UDMA_CFG_OFFSET         0x004
+#define UDMA_CTLBASE_OFFSET     0x008
+#define UDMA_ALTBASE_OFFSET     0x00C
+#define UDMA_WAITSTAT_OFFSET    0x010
+#define UDMA_SWREQ_OFFSET       0x014
+#define UDMA_USEBURSTSET_OFFSET 0x018
+#define UDMA_USEBURSTCLR_OFFSET 0x01C
+#define UDMA_REQMASKSET_OFFSET  0x020
+#define UDMA_REQMASKCLR_OFFSET  0x024
+#define UDMA_ENASET_OFFSET      0x028
+#define UDMA_ENACLR_OFFSET      0x02C
+#define UDMA_ALTSET_OFFSET      0x030
+#define UDMA_ALTCLR_OFFSET      0x034
+#define UDMA_PRIOSET_OFFSET     0x038
+#define UDMA_PRIOCLR_OFFSET     0x03C
+#define UDMA_ERRCLR_OFFSET      0x04C
+#define UDMA_CHASGN_OFFSET      0x500
+#define UDMA_CHIS_OFFSET        0x504
+#define UDMA_CHMAP0_OFFSET      0x510
+#define UDMA_CHMAP1_OFFSET      0x514
+#define UDMA_CHMAP2_OFFSET      0x518
+#define UDMA_CHMAP3_OFFSET      0x51C
+
 /** 
  * See Table 10-6. GPIO Register Map on p. 660 of the TM4C Datasheet for more
  * details. 
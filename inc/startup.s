@@ -60,6 +60,19 @@ HeapMem
         SPACE   Heap
 __heap_limit
 
+;******************************************************************************
+;
+; Allocate space for the crash dump (see lib/CrashDump). The area is NOINIT, so
+; a dump written by _ReportHardFault survives the reset into the next boot.
+; Must be at least sizeof(CrashDump_t).
+;
+;******************************************************************************
+CrashDump   EQU     0x00000240
+        AREA    CRASHDUMP, NOINIT, READWRITE, ALIGN=3
+        EXPORT  CrashDumpRecord
+CrashDumpRecord
+        SPACE   CrashDump
+
 ;******************************************************************************
 ;
 ; Indicate that the code in this file preserves 8-byte alignment of the stack.
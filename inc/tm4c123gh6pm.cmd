@@ -40,6 +40,7 @@ SECTIONS
     .bss    :   > SRAM
     .sysmem :   > SRAM
     .stack  :   > SRAM
+    .TI.noinit : > SRAM
 }
 
 __STACK_TOP = __stack + 512;
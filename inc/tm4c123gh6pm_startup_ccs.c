@@ -33,8 +33,9 @@
 //*****************************************************************************
 void ResetISR(void);
 static void NMI_Handler(void);
-static void HardFault_Handler(void);
+void HardFault_Handler(void);
 static void IntDefaultHandler(void);
+void _ReportHardFault(uint32_t *stackFrame, uint32_t excReturn);
 
 //*****************************************************************************
 //
@@ -71,6 +72,24 @@ void WaitForInterrupt(void) {
     __asm("    WFI");
 }
 
+uint32_t StartCritical(void) {
+    __asm("    MRS R0, PRIMASK\n"
+          "    CPSID i\n"
+          "    BX LR");
+
+    //
+    // The following keeps the compiler happy, because it wants to see a
+    // return value from this function. The real return is the BX LR above,
+    // so the return(0) is never executed and the function returns with
+    // PRIMASK in R0.
+    //
+    return(0);
+}
+
+void EndCritical(uint32_t primask) {
+    __asm("    MSR PRIMASK, R0");
+}
+
 /**
  * Interrupt handlers references. Until defined by a STRONG handler in another file,
  * the default action is to go into the default interrupt handler. This simply enters
@@ -456,11 +475,35 @@ static void NMI_Handler(void) {
 //*****************************************************************************
 //
 // This is the code that gets called when the processor receives a fault
-// interrupt.  This simply enters an infinite loop, preserving the system state
-// for examination by a debugger.
+// interrupt.  It passes the stack pointer at the fault and EXC_RETURN to
+// _ReportHardFault, like HardFault_Handler in startup.s.  It is written in
+// assembly so that no compiler prologue can push to the stack or clobber LR
+// before EXC_RETURN is read.  Weak, so that it can be overridden.
+//
+//*****************************************************************************
+__asm("    .sect   \".text:HardFault_Handler\"\n"
+      "    .clink\n"
+      "    .thumbfunc HardFault_Handler\n"
+      "    .thumb\n"
+      "    .weak   HardFault_Handler\n"
+      "    .global _ReportHardFault\n"
+      "HardFault_Handler:\n"
+      "    tst     lr, #4\n"
+      "    ite     eq\n"
+      "    mrseq   r0, msp\n"
+      "    mrsne   r0, psp\n"
+      "    mov     r1, lr\n"
+      "    b.w     _ReportHardFault\n");
+
+//*****************************************************************************
+//
+// The default fault reporter.  This simply enters an infinite loop, preserving
+// the system state for examination by a debugger.  FaultHandler.c overrides it
+// to capture a crash dump.
 //
 //*****************************************************************************
-static void HardFault_Handler(void) {
+#pragma WEAK(_ReportHardFault)
+void _ReportHardFault(uint32_t *stackFrame, uint32_t excReturn) {
     //
     // Enter an infinite loop.
     //
@@ -34,7 +34,7 @@ enum ADCPin {
     AIN8, // PE5
     AIN9, // PE4
     AIN10,// PB4
-    AIN11 // PB5
+    AIN11,// PB5
     AIN_COUNT
 };
 
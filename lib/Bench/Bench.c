@@ -0,0 +1,106 @@
+/**
+ * @file Bench.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Cycle counting benchmark harness.
+ * @version 0.1
+ * @date 2022-03-06
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <assert.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/Common/Common.h>
+#include <lib/Bench/Bench.h>
+
+
+uint32_t StartCritical(void);       // Defined in startup.s
+void EndCritical(uint32_t sr);      // Defined in startup.s
+
+/** @brief The cycles BenchRun measures for an empty task. */
+static uint32_t BenchOverhead = 0;
+
+/**
+ * @brief BenchEmpty is the task used to measure the harness overhead.
+ *
+ * @param args Unused.
+ */
+static void BenchEmpty(uint32_t * args) {}
+
+void BenchInit(void) {
+    /* 1. Enable the cycle counter, then count from 0. */
+    CommonEnableCycleCounter();
+    GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET) = 0;
+
+    /* 2. Calibrate. The fastest empty run is the fixed cost of a sample. */
+    BenchOverhead = 0;
+    BenchOverhead = BenchRun("overhead", BenchEmpty, NULL, 64).min;
+}
+
+uint32_t BenchGetCycles(void) {
+    return GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+}
+
+BenchResult_t BenchRun(const char * name, void (*task)(uint32_t *args), uint32_t * args, uint32_t iterations) {
+    /* Initialization asserts. */
+    assert(task != NULL);
+    assert(iterations > 0);
+
+    BenchResult_t result = {
+        .name=name,
+        .iterations=iterations,
+        .min=0xFFFFFFFF,
+        .mean=0,
+        .max=0
+    };
+
+    uint64_t total = 0;
+    uint32_t i;
+    for (i = 0; i < iterations; ++i) {
+        /* 1. Time one run without interrupts. */
+        uint32_t sr = StartCritical();
+        uint32_t start = BenchGetCycles();
+        task(args);
+        uint32_t cycles = BenchGetCycles() - start;
+        EndCritical(sr);
+
+        /* 2. Remove the harness cost. */
+        cycles = (cycles > BenchOverhead) ? cycles - BenchOverhead : 0;
+
+        if (cycles < result.min) result.min = cycles;
+        if (cycles > result.max) result.max = cycles;
+        total += cycles;
+    }
+    result.mean = total / iterations;
+
+    return result;
+}
+
+uint8_t BenchFormat(BenchResult_t result, char * line) {
+    /* Initialization asserts. */
+    assert(line != NULL);
+
+    /* 1. Name, leaving room for four numbers, separators, and the ending. */
+    uint8_t length = 0;
+    const char * name = (result.name != NULL) ? result.name : "";
+    while (name[length] != '\0' && length < BENCH_LINE_SIZE - 4 * 11 - 3) {
+        line[length] = name[length];
+        ++length;
+    }
+
+    /* 2. Statistics. */
+    uint32_t values[4] = { result.iterations, result.min, result.mean, result.max };
+    uint8_t i;
+    for (i = 0; i < 4; ++i) {
+        line[length++] = ',';
+        length = CommonFormatNumber(line, length, BENCH_LINE_SIZE - 3, values[i], 10, false, 0, ' ');
+    }
+
+    line[length++] = '\r';
+    line[length++] = '\n';
+    line[length] = '\0';
+    return length;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file Bench.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Cycle counting benchmark harness.
+ * @version 0.1
+ * @date 2022-03-06
+ * @copyright Copyright (c) 2022
+ * @note
+ * Usage. BenchInit enables the DWT cycle counter and measures the harness
+ * overhead, which BenchRun then subtracts from every sample. Each sample runs
+ * the task once with interrupts disabled. Results are reported as one CSV line
+ * per task with BenchFormat:
+ *
+ *      name,iterations,min,mean,max
+ *
+ * Host Builds. With `-D__HOST__`, the cycle counter is simulated by
+ * lib/RegSim from host time, so host results include the simulator cost and
+ * are only meaningful relative to each other.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+
+
+/** @brief BENCH_LINE_SIZE is the maximum length of a formatted result. */
+#define BENCH_LINE_SIZE 80
+
+/** @brief BENCH_HEADER is the CSV header matching BenchFormat. */
+#define BENCH_HEADER "name,iterations,min,mean,max\r\n"
+
+/** @brief BenchResult_t contains the cycle statistics of a benchmarked task. */
+typedef struct BenchResult {
+    /** @brief The name of the task. */
+    const char * name;
+
+    /** @brief The number of times the task was run. */
+    uint32_t iterations;
+
+    /** @brief The fewest cycles a run took. */
+    uint32_t min;
+
+    /** @brief The mean cycles a run took, rounded down. */
+    uint32_t mean;
+
+    /** @brief The most cycles a run took. */
+    uint32_t max;
+} BenchResult_t;
+
+/**
+ * @brief BenchInit enables the DWT cycle counter and calibrates the harness
+ *        overhead. Call after PLLInit.
+ */
+void BenchInit(void);
+
+/**
+ * @brief BenchGetCycles returns the current value of the cycle counter.
+ *
+ * @return CYCCNT. Wraps around every 2^32 cycles.
+ */
+uint32_t BenchGetCycles(void);
+
+/**
+ * @brief BenchRun times a task.
+ *
+ * @param name The name reported for the task. Must remain valid while the
+ *             result is used.
+ * @param task The function to time.
+ * @param args The arguments passed to task.
+ * @param iterations The number of runs. Must be greater than zero.
+ * @return The cycle statistics of the task, less the harness overhead.
+ */
+BenchResult_t BenchRun(const char * name, void (*task)(uint32_t *args), uint32_t * args, uint32_t iterations);
+
+/**
+ * @brief BenchFormat formats a result as a CSV line ending in "\r\n".
+ *
+ * @param result The result to format.
+ * @param line Output buffer of at least BENCH_LINE_SIZE bytes. Long names are
+ *             truncated.
+ * @return The length of the line, excluding the null terminator.
+ */
+uint8_t BenchFormat(BenchResult_t result, char * line);
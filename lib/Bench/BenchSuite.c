@@ -0,0 +1,193 @@
+/**
+ * @file BenchSuite.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Benchmarks of the public driver APIs.
+ * @version 0.1
+ * @date 2022-03-06
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <assert.h>
+
+/** Device specific imports. */
+#include <lib/Bench/BenchSuite.h>
+#include <lib/GPIO/GPIO.h>
+#include <lib/Timer/Timer.h>
+#include <lib/ADC/ADC.h>
+#include <lib/UART/UART.h>
+#include <lib/SSI/SSI.h>
+#include <lib/I2C/I2C.h>
+#include <lib/DAC/DAC.h>
+#include <lib/PLL/PLL.h>
+
+#ifdef __FAST__
+#define BENCH_GPIO_MODE "/fast"
+#else
+#define BENCH_GPIO_MODE "/default"
+#endif
+
+
+/** @brief The peripherals used by the benchmarks. */
+static struct BenchPeripherals {
+    Timer_t timer;
+    ADC_t adc;
+    UART_t uart;
+    SSIModule_t ssi;
+    I2C_t i2c;
+    DAC_t dac;
+} bench;
+
+/** @brief The DAC pins, which must outlive the DAC. */
+static GPIOPin_t benchDACPins[4] = { PIN_D0, PIN_D1, PIN_D2, PIN_D3 };
+
+/** @brief Keeps read results from being optimized out. */
+static volatile uint32_t benchSink;
+
+/** ------------- Tasks. ------------- */
+
+static void BenchGPIOSetBit(uint32_t * args) { GPIOSetBit(PIN_F2, args[0]); }
+
+static void BenchGPIOGetBit(uint32_t * args) { benchSink = GPIOGetBit(PIN_F4); }
+
+static void BenchTimerGetValue(uint32_t * args) { benchSink = TimerGetValue(bench.timer); }
+
+static void BenchADCSampleSingle(uint32_t * args) { benchSink = ADCSampleSingle(bench.adc); }
+
+static void BenchADCSampleSequencer(uint32_t * args) {
+    uint16_t samples[8];
+    ADCSampleSequencer(bench.adc.module, bench.adc.sequencer, samples);
+    benchSink = samples[0];
+}
+
+static void BenchUARTSend(uint32_t * args) {
+    uint8_t byte = 0x55;
+    UARTSend(bench.uart, &byte, 1);
+}
+
+static void BenchSPIWrite(uint32_t * args) { SPIWrite(bench.ssi, 0xA5); }
+
+static void BenchI2CTransmitByte(uint32_t * args) {
+    benchSink = I2CMasterTransmitByte(bench.i2c, BENCH_I2C_ADDRESS, 0xA0);
+}
+
+static void BenchI2CWriteRead(uint32_t * args) {
+    uint8_t command = 0xA0;
+    uint8_t bytes[2];
+    benchSink = I2CMasterWriteRead(bench.i2c, BENCH_I2C_ADDRESS, &command, 1, bytes, 2);
+}
+
+static void BenchDACOut(uint32_t * args) { DACOut(bench.dac, args[0]); }
+
+static void BenchPLLSetClock(uint32_t * args) {
+    PLLSetClock(PLL_SOURCE_PIOSC, 0);
+    PLLSetClock(PLL_SOURCE_PLL, args[0]);
+}
+
+/** ------------- Setup. ------------- */
+
+/**
+ * @brief BenchSuiteInit initializes the benchmarked peripherals.
+ */
+static void BenchSuiteInit(void) {
+    /* 1. GPIO. */
+    GPIOConfig_t outputConfig = {
+        .pin=PIN_F2,
+        .pull=GPIO_PULL_DOWN,
+        .isOutput=true,
+        .alternateFunction=0,
+        .isAnalog=false,
+        .drive=GPIO_DRIVE_2MA,
+        .enableSlew=false
+    };
+    GPIOInit(outputConfig);
+    GPIOConfig_t inputConfig = {
+        .pin=PIN_F4,
+        .pull=GPIO_PULL_UP,
+        .isOutput=false,
+        .alternateFunction=0,
+        .isAnalog=false,
+        .drive=GPIO_DRIVE_2MA,
+        .enableSlew=false
+    };
+    GPIOInit(inputConfig);
+
+    /* 2. Free running timer. */
+    TimerConfig_t timerConfig = {
+        .timerID=TIMER_1A,
+        .period=0xFFFFFFFF,
+        .isIndividual=false,
+        .prescale=0,
+        .timerTask=NULL,
+        .isPeriodic=true,
+        .priority=7,
+        .timerArgs=NULL
+    };
+    bench.timer = TimerInit(timerConfig);
+    TimerStart(bench.timer);
+
+    /* 3. ADC. */
+    ADCConfig_t adcConfig = {
+        .pin=AIN0,
+        .module=ADC_MODULE_0,
+        .sequencer=ADC_SS_0,
+        .position=ADC_SEQPOS_0
+    };
+    bench.adc = ADCInit(adcConfig);
+
+    /* 4. UART. */
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_1,
+        .baudrate=115200
+    };
+    bench.uart = UARTInit(uartConfig);
+
+    /* 5. SSI. */
+    SSIConfig_t ssiConfig = {
+        .ssi=SSI0_PA,
+        .dataSize=SSI_SIZE_8,
+        .ssiPrescaler=2,
+        .ssiClockModifier=0,
+        .isReceiving=false
+    };
+    bench.ssi = SSIInit(ssiConfig);
+
+    /* 6. I2C. */
+    I2CConfig_t i2cConfig = {
+        .module=I2C_MODULE_0,
+        .speed=I2C_SPEED_400_KBPS
+    };
+    bench.i2c = I2CInit(i2cConfig);
+
+    /* 7. DAC. */
+    DACConfig_t dacConfig = {
+        .pins=benchDACPins,
+        .numPins=4
+    };
+    bench.dac = DACInit(dacConfig);
+}
+
+void BenchSuiteRun(void (*reportTask)(BenchResult_t result)) {
+    /* Initialization asserts. */
+    assert(reportTask != NULL);
+
+    BenchInit();
+    BenchSuiteInit();
+
+    uint32_t high[1] = { 1 };
+    uint32_t value[1] = { 0xA };
+    uint32_t pll[1] = { BUS_80_MHZ };
+
+    reportTask(BenchRun("GPIOSetBit" BENCH_GPIO_MODE, BenchGPIOSetBit, high, BENCH_ITERATIONS));
+    reportTask(BenchRun("GPIOGetBit" BENCH_GPIO_MODE, BenchGPIOGetBit, NULL, BENCH_ITERATIONS));
+    reportTask(BenchRun("TimerGetValue", BenchTimerGetValue, NULL, BENCH_ITERATIONS));
+    reportTask(BenchRun("ADCSampleSingle", BenchADCSampleSingle, NULL, BENCH_ITERATIONS));
+    reportTask(BenchRun("ADCSampleSequencer", BenchADCSampleSequencer, NULL, BENCH_ITERATIONS));
+    reportTask(BenchRun("UARTSend/byte", BenchUARTSend, NULL, BENCH_ITERATIONS));
+    reportTask(BenchRun("SPIWrite", BenchSPIWrite, NULL, BENCH_ITERATIONS));
+    reportTask(BenchRun("I2CMasterTransmitByte", BenchI2CTransmitByte, NULL, BENCH_I2C_ITERATIONS));
+    reportTask(BenchRun("I2CMasterWriteRead", BenchI2CWriteRead, NULL, BENCH_I2C_ITERATIONS));
+    reportTask(BenchRun("DACOut", BenchDACOut, value, BENCH_ITERATIONS));
+    reportTask(BenchRun("PLLSetClock/PLL-PIOSC-PLL", BenchPLLSetClock, pll, BENCH_PLL_ITERATIONS));
+}
@@ -0,0 +1,52 @@
+/**
+ * @file BenchSuite.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Benchmarks of the public driver APIs.
+ * @version 0.1
+ * @date 2022-03-06
+ * @copyright Copyright (c) 2022
+ * @note
+ * Peripherals. The suite initializes the following peripherals, which should
+ * be left unconnected or connected to a harmless load:
+ *      - PF2 (output) and PF4 (input) for GPIOSetBit and GPIOGetBit.
+ *      - TIMER_1A, free running, for TimerGetValue.
+ *      - ADC module 0 on AIN0 (PE3).
+ *      - UART_MODULE_1 (PB0, PB1) at 115200 baud for UARTSend.
+ *      - SSI0_PA (PA2 - PA5) for SPIWrite.
+ *      - I2C_MODULE_0 (PB2, PB3) at 400 kbps for I2C transactions. Without a
+ *        device at BENCH_I2C_ADDRESS, this times the address NACK path.
+ *      - PD0 - PD3 as a 4 bit DAC.
+ *      - The system clock, which is switched to PIOSC and back to the PLL at
+ *        80 MHz. The UART, SSI and I2C modules above are retimed on each
+ *        switch, so the latency includes their clock tasks. Cycles are
+ *        counted at whichever clock is running.
+ *
+ * Modes. GPIOSetBit and GPIOGetBit are reported with a "/fast" suffix when the
+ * suite (and GPIO.c) are compiled with __FAST__, and "/default" otherwise.
+ * Build and run the suite once in each mode to compare them.
+ */
+#pragma once
+
+/** Device specific imports. */
+#include <lib/Bench/Bench.h>
+
+
+/** @brief BENCH_ITERATIONS is the number of runs of each fast API. */
+#define BENCH_ITERATIONS 256
+
+/** @brief BENCH_I2C_ITERATIONS is the number of runs of each I2C API. */
+#define BENCH_I2C_ITERATIONS 16
+
+/** @brief BENCH_PLL_ITERATIONS is the number of clock switch round trips. */
+#define BENCH_PLL_ITERATIONS 16
+
+/** @brief BENCH_I2C_ADDRESS is the slave address used for I2C transactions. */
+#define BENCH_I2C_ADDRESS 0x29
+
+/**
+ * @brief BenchSuiteRun initializes the benchmarked peripherals and times each
+ *        driver API. Call after PLLInit(BUS_80_MHZ).
+ *
+ * @param reportTask Function called with each result, in order.
+ */
+void BenchSuiteRun(void (*reportTask)(BenchResult_t result));
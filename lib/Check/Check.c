@@ -0,0 +1,114 @@
+/**
+ * @file Check.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Tiered runtime checks with a per module fault policy.
+ * @version 0.1
+ * @date 2022-03-12
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/Check/Check.h>
+#include <lib/Log/Log.h>
+#include <lib/CrashDump/CrashDump.h>
+
+
+uint32_t StartCritical(void);       // Defined in startup.s
+void EndCritical(uint32_t sr);      // Defined in startup.s
+void DisableInterrupts(void);       // Defined in startup.s
+void WaitForInterrupt(void);        // Defined in startup.s
+
+/** @brief CheckPolicies is the policy of each module. One entry per
+ *         CheckModule_t. */
+static CheckPolicy_t CheckPolicies[CHECK_MODULE_COUNT] = {
+    CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY,
+    CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY,
+    CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY,
+    CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY, CHECK_DEFAULT_POLICY
+};
+
+/** @brief CheckTable is the failures of each module. */
+static CheckStats_t CheckTable[CHECK_MODULE_COUNT];
+
+bool CheckFail(CheckModule_t module, const char * expr, const char * file, uint32_t line) {
+    /* A bad module would index out of the tables. Count it as the caller's. */
+    if (module >= CHECK_MODULE_COUNT) module = CHECK_USER;
+
+    /* 1. Count the failure. Checks can fail from any interrupt. */
+    uint32_t sr = StartCritical();
+    CheckStats_t * stats = &CheckTable[module];
+    ++stats->count;
+    stats->expr = expr;
+    stats->file = file;
+    stats->line = line;
+    EndCritical(sr);
+
+    /* 2. Leave a record for LogFlush, or for the crash dump trace. The strings
+          are literals, so only their addresses are stored. */
+    LOG("check failed: %s, %s:%u", expr, file, line);
+
+    /* 3. Apply the policy. */
+    switch (CheckPolicies[module]) {
+        case CHECK_LOG:
+            return false;
+        case CHECK_RESET:
+            DisableInterrupts();
+            /* There is no exception frame; the dump only holds the fault
+               status registers, the stack pointer and the trace. */
+            CrashDumpCapture(NULL, 0);
+            GET_REG(PERIPHERALS_BASE + SYS_APINT_OFFSET) = 0x05FA0004;
+            while (1) {}
+        case CHECK_HALT:
+        default:
+            DisableInterrupts();
+            while (1) {
+                WaitForInterrupt();
+            }
+    }
+}
+
+void CheckSetPolicy(CheckModule_t module, CheckPolicy_t policy) {
+    /* Arguments are tested without CHECK or assert, which would recurse into
+       this module. */
+    if (module >= CHECK_MODULE_COUNT || policy > CHECK_RESET) return;
+
+    CheckPolicies[module] = policy;
+}
+
+CheckPolicy_t CheckGetPolicy(CheckModule_t module) {
+    if (module >= CHECK_MODULE_COUNT) return CHECK_DEFAULT_POLICY;
+    return CheckPolicies[module];
+}
+
+void CheckGet(CheckModule_t module, CheckStats_t * stats) {
+    if (stats == NULL) return;
+    if (module >= CHECK_MODULE_COUNT) module = CHECK_USER;
+
+    /* The copy is not atomic, so mask the interrupts that may write it. */
+    uint32_t sr = StartCritical();
+    *stats = CheckTable[module];
+    EndCritical(sr);
+}
+
+uint32_t CheckGetTotal(void) {
+    uint32_t total = 0;
+    uint8_t module;
+    for (module = 0; module < CHECK_MODULE_COUNT; ++module) {
+        total += CheckTable[module].count;
+    }
+    return total;
+}
+
+void CheckReset(void) {
+    uint32_t sr = StartCritical();
+    uint8_t module;
+    for (module = 0; module < CHECK_MODULE_COUNT; ++module) {
+        CheckStats_t empty = { 0 };
+        CheckTable[module] = empty;
+    }
+    EndCritical(sr);
+}
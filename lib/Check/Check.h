@@ -0,0 +1,154 @@
+/**
+ * @file Check.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Tiered runtime checks with a per module fault policy.
+ * @version 0.1
+ * @date 2022-03-12
+ * @copyright Copyright (c) 2022
+ * @note
+ * Tiers. Two macros replace assert in the drivers:
+ *      - CHECK_DEBUG is for hot paths (GPIOSetBit, the interrupt handlers).
+ *        Like assert, it compiles to nothing when NDEBUG is defined.
+ *      - CHECK is always compiled in. A passing check costs a compare and a
+ *        branch. A failing check is counted in a table and handled by the
+ *        policy of its module.
+ * Both evaluate to whether the check passed, so a driver can bail out instead
+ * of touching the wrong register:
+ *
+ *      if (!CHECK(CHECK_TIMER, timer.timerID < TIMER_COUNT)) return;
+ *
+ * Policies. Each module has a policy, CHECK_DEFAULT_POLICY unless changed with
+ * CheckSetPolicy. Every failure is first counted and written to the Log ring,
+ * then:
+ *      - CHECK_HALT disables interrupts and stops, for a debugger to inspect.
+ *      - CHECK_LOG returns false to the caller, which carries on.
+ *      - CHECK_RESET captures a crash dump (see CrashDump.h) and resets the
+ *        TM4C. The last trace record of the dump names the failed check.
+ *
+ * Asserts. __aeabi_assert in FaultHandler.c reports through the CHECK_ASSERT
+ * module. assert cannot return, so CHECK_LOG halts there instead.
+ *
+ * Nothing here blocks on a peripheral: failures are sent to the PC by
+ * LogFlush from the idle loop, or by CrashDumpReport after the reset.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/** @brief CheckPolicy_t is what happens after a check fails. */
+typedef enum CheckPolicy {
+    CHECK_HALT,
+    CHECK_LOG,
+    CHECK_RESET
+} CheckPolicy_t;
+
+/** @brief CHECK_DEFAULT_POLICY is the policy of every module at boot. Halting
+ *         matches the previous assert behavior. */
+#ifndef CHECK_DEFAULT_POLICY
+#define CHECK_DEFAULT_POLICY CHECK_HALT
+#endif
+
+/** @brief CheckModule_t is a module with its own policy and counter. */
+typedef enum CheckModule {
+    CHECK_ASSERT,
+    CHECK_ADC,
+    CHECK_DAC,
+    CHECK_DMA,
+    CHECK_GPIO,
+    CHECK_I2C,
+    CHECK_PLL,
+    CHECK_PWM,
+    CHECK_SSI,
+    CHECK_TIMER,
+    CHECK_UART,
+    CHECK_USER,
+    CHECK_MODULE_COUNT
+} CheckModule_t;
+
+/** @brief CheckStats_t is the failures of one module. */
+typedef struct CheckStats {
+    /** @brief The number of failed checks. */
+    uint32_t count;
+
+    /** @brief The expression, file and line of the last failed check. NULL
+     *         and 0 if none failed. */
+    const char * expr;
+    const char * file;
+    uint32_t line;
+} CheckStats_t;
+
+/**
+ * @brief CHECK tests an expression in every build.
+ *
+ * @param module The CheckModule_t of the caller.
+ * @param expr The expression that should be true.
+ * @return Whether expr is true. Only returns false under CHECK_LOG.
+ */
+#define CHECK(module, expr) \
+    ((expr) ? true : CheckFail((module), #expr, __FILE__, __LINE__))
+
+/**
+ * @brief CHECK_DEBUG tests an expression unless NDEBUG is defined, in which
+ *        case the expression is not evaluated and the check passes.
+ *
+ * @param module The CheckModule_t of the caller.
+ * @param expr The expression that should be true.
+ * @return Whether expr is true. Only returns false under CHECK_LOG.
+ */
+#ifdef NDEBUG
+#define CHECK_DEBUG(module, expr) (true)
+#else
+#define CHECK_DEBUG(module, expr) CHECK(module, expr)
+#endif
+
+/**
+ * @brief CheckFail records a failed check and applies the policy of its
+ *        module. Use CHECK or CHECK_DEBUG instead. Safe to call from
+ *        interrupts.
+ *
+ * @param module The module of the check.
+ * @param expr The expression that failed.
+ * @param file The file of the check.
+ * @param line The line of the check.
+ * @return False. Does not return under CHECK_HALT or CHECK_RESET.
+ */
+bool CheckFail(CheckModule_t module, const char * expr, const char * file, uint32_t line);
+
+/**
+ * @brief CheckSetPolicy sets the policy of a module.
+ *
+ * @param module The module.
+ * @param policy The policy applied to its next failures.
+ */
+void CheckSetPolicy(CheckModule_t module, CheckPolicy_t policy);
+
+/**
+ * @brief CheckGetPolicy returns the policy of a module.
+ *
+ * @param module The module.
+ * @return The policy.
+ */
+CheckPolicy_t CheckGetPolicy(CheckModule_t module);
+
+/**
+ * @brief CheckGet copies the failures of a module.
+ *
+ * @param module The module.
+ * @param stats Output for the failures.
+ */
+void CheckGet(CheckModule_t module, CheckStats_t * stats);
+
+/**
+ * @brief CheckGetTotal returns the number of failed checks across modules.
+ *
+ * @return The number of failed checks since boot or CheckReset.
+ */
+uint32_t CheckGetTotal(void);
+
+/**
+ * @brief CheckReset clears the failures of every module. Policies are kept.
+ */
+void CheckReset(void);
@@ -0,0 +1,40 @@
+/**
+ * @file Common.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Helpers shared by the Bench, Log, Telemetry, Profile and I2C drivers.
+ * @version 0.1
+ * @date 2022-03-13
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/Common/Common.h>
+
+
+void CommonEnableCycleCounter(void) {
+    GET_REG(PERIPHERALS_BASE + DEMCR_OFFSET) |= 0x01000000;
+    GET_REG(DWT_BASE + DWT_CTRL_OFFSET) |= 0x00000001;
+}
+
+uint8_t CommonFormatNumber(char * line, uint8_t length, uint8_t maxLength, uintptr_t value, uint8_t base, bool isUpper, uint8_t width, char pad) {
+    const char * digitMap = isUpper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char digits[3 * sizeof(uintptr_t)];
+    uint8_t numDigits = 0;
+    do {
+        digits[numDigits++] = digitMap[value % base];
+        value /= base;
+    } while (value > 0);
+
+    while (width > numDigits && length < maxLength) {
+        line[length++] = pad;
+        --width;
+    }
+    while (numDigits > 0 && length < maxLength) {
+        line[length++] = digits[--numDigits];
+    }
+    return length;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file Common.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Helpers shared by the Bench, Log, Telemetry, Profile and I2C drivers.
+ * @version 0.1
+ * @date 2022-03-13
+ * @copyright Copyright (c) 2022
+ * @note
+ * Cycle counter. CommonEnableCycleCounter turns on the DWT cycle counter that
+ * the drivers timestamp and time with. It is idempotent, so each driver enables
+ * it from its own init and none depends on another being initialized first.
+ *
+ * Number formatting. CommonFormatNumber appends a number to a line being
+ * built, as the CSV and log lines of the drivers are.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/**
+ * @brief CommonEnableCycleCounter enables tracing, then the DWT cycle counter.
+ *        The count is left running from its current value.
+ */
+void CommonEnableCycleCounter(void);
+
+/**
+ * @brief CommonFormatNumber appends a number to a line.
+ *
+ * @param line The line to append to.
+ * @param length The current length of the line.
+ * @param maxLength The length the line may not exceed.
+ * @param value The number to append.
+ * @param base 10 or 16.
+ * @param isUpper Whether hex digits are uppercase.
+ * @param width The minimum number of characters, padded on the left.
+ * @param pad The padding character, ' ' or '0'.
+ * @return The new length of the line.
+ */
+uint8_t CommonFormatNumber(char * line, uint8_t length, uint8_t maxLength, uintptr_t value, uint8_t base, bool isUpper, uint8_t width, char pad);
@@ -0,0 +1,142 @@
+/**
+ * @file CrashDump.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Crash dump capture to RAM that survives a warm reset.
+ * @version 0.1
+ * @date 2022-03-11
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <stddef.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/CrashDump/CrashDump.h>
+
+
+/** @brief The SRAM range. Stack pointers outside of it are not followed. */
+#define SRAM_BASE 0x20000000
+#define SRAM_END  0x20008000
+
+/** @brief CrashDumpRecord is the dump. It must not be zeroed by the C startup
+ *         code, so it is placed in a toolchain specific uninitialized area. */
+#if defined(__TI_COMPILER_VERSION__)
+#pragma NOINIT(CrashDumpRecord)
+static CrashDump_t CrashDumpRecord;
+#elif defined(__ARMCC_VERSION)
+/* Reserved by the CRASHDUMP NOINIT area in startup.s. Fails to compile if
+   the area is too small. */
+extern CrashDump_t CrashDumpRecord;
+typedef char CrashDumpFits[(sizeof(CrashDump_t) <= 0x240) ? 1 : -1];
+#else
+static CrashDump_t CrashDumpRecord __attribute__((section(".noinit")));
+#endif
+
+/**
+ * @brief CrashDumpCRC computes the CRC-32 (polynomial 0xEDB88320 reflected,
+ *        initial value and final XOR 0xFFFFFFFF) of a buffer. Bitwise, since it
+ *        only runs once per fault and once per boot.
+ *
+ * @param bytes The buffer.
+ * @param numBytes The length of the buffer.
+ * @return The CRC.
+ */
+static uint32_t CrashDumpCRC(const uint8_t * bytes, uint32_t numBytes) {
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t i;
+    for (i = 0; i < numBytes; ++i) {
+        crc ^= bytes[i];
+        uint8_t bit;
+        for (bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+void CrashDumpCapture(uint32_t * stackFrame, uint32_t excReturn) {
+    CrashDump_t * dump = &CrashDumpRecord;
+    uint32_t sp = (uint32_t)(uintptr_t)stackFrame;
+
+    /* 1. Header and fault status registers. */
+    dump->magic = CRASHDUMP_MAGIC;
+    dump->version = CRASHDUMP_VERSION;
+    dump->size = sizeof(CrashDump_t);
+    dump->timestamp = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+    dump->cfsr = GET_REG(PERIPHERALS_BASE + SYS_CFSR_OFFSET);
+    dump->hfsr = GET_REG(PERIPHERALS_BASE + SYS_HFSR_OFFSET);
+    dump->mmfar = GET_REG(PERIPHERALS_BASE + SYS_MMFAR_OFFSET);
+    dump->bfar = GET_REG(PERIPHERALS_BASE + SYS_BFAR_OFFSET);
+    dump->excReturn = excReturn;
+    dump->sp = sp;
+
+    /* 2. Exception frame. A stack overflow can leave sp outside of SRAM, and
+          reading it would fault again inside the fault handler. */
+    uint8_t i;
+    bool isFrameValid = (SRAM_BASE <= sp) && (sp + 8 * 4 <= SRAM_END) && ((sp & 0x3) == 0);
+    for (i = 0; i < 8; ++i) dump->frame[i] = isFrameValid ? stackFrame[i] : 0;
+
+    /* 3. Stack above the frame. Bit 4 of EXC_RETURN is clear when the
+          floating point registers were stacked too, making the frame 26 words
+          instead of 8. */
+    dump->numStack = 0;
+    if (isFrameValid) {
+        uint32_t frameWords = (excReturn & 0x10) ? 8 : 26;
+        uint32_t address = sp + frameWords * 4;
+        while (dump->numStack < CRASHDUMP_STACK_WORDS && address + 4 <= SRAM_END) {
+            dump->stack[dump->numStack++] = *(volatile uint32_t *)(uintptr_t)address;
+            address += 4;
+        }
+    }
+    for (i = dump->numStack; i < CRASHDUMP_STACK_WORDS; ++i) dump->stack[i] = 0;
+
+    /* 4. Recent Log records. */
+    LogRecord_t records[CRASHDUMP_TRACE_RECORDS];
+    dump->numTrace = LogSnapshot(records, CRASHDUMP_TRACE_RECORDS);
+    for (i = 0; i < CRASHDUMP_TRACE_RECORDS; ++i) {
+        CrashDumpTrace_t trace = { 0 };
+        if (i < dump->numTrace) {
+            trace.timestamp = records[i].timestamp;
+            trace.format = (uint32_t)(uintptr_t)records[i].format;
+            trace.numArgs = records[i].numArgs;
+            uint8_t j;
+            for (j = 0; j < LOG_MAX_ARGS; ++j) trace.args[j] = (uint32_t)records[i].args[j];
+        }
+        dump->trace[i] = trace;
+    }
+
+    /* 5. Seal. */
+    dump->crc = CrashDumpCRC((const uint8_t *)dump, offsetof(CrashDump_t, crc));
+}
+
+const CrashDump_t * CrashDumpGet(void) {
+    const CrashDump_t * dump = &CrashDumpRecord;
+    if (dump->magic != CRASHDUMP_MAGIC) return NULL;
+    if (dump->version != CRASHDUMP_VERSION || dump->size != sizeof(CrashDump_t)) return NULL;
+    if (dump->crc != CrashDumpCRC((const uint8_t *)dump, offsetof(CrashDump_t, crc))) return NULL;
+    return dump;
+}
+
+void CrashDumpClear(void) {
+    CrashDumpRecord.magic = 0;
+}
+
+bool CrashDumpReport(UART_t uart) {
+    const CrashDump_t * dump = CrashDumpGet();
+    if (dump == NULL) return false;
+
+    /* UARTSend takes at most 255 bytes at a time. */
+    const uint8_t * bytes = (const uint8_t *)dump;
+    uint32_t sent = 0;
+    while (sent < sizeof(CrashDump_t)) {
+        uint32_t chunk = sizeof(CrashDump_t) - sent;
+        if (chunk > 255) chunk = 255;
+        UARTSend(uart, (uint8_t *)(bytes + sent), chunk);
+        sent += chunk;
+    }
+
+    CrashDumpClear();
+    return true;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file CrashDump.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Crash dump capture to RAM that survives a warm reset.
+ * @version 0.1
+ * @date 2022-03-11
+ * @copyright Copyright (c) 2022
+ * @note
+ * Usage. _ReportHardFault in FaultHandler.c calls CrashDumpCapture, which
+ * writes a CrashDump_t into RAM that the C startup code does not zero, then
+ * resets the TM4C. On the next boot, send the dump to the user PC and clear
+ * it, before anything else uses the UART:
+ *
+ *      UART_t uart = UARTInit(uartConfig);
+ *      CrashDumpReport(uart);
+ *
+ * examples/CrashDump/host/CrashDumpDecoder.c finds the dump in the serial
+ * stream and decodes it against the ELF image (.axf or .out) of the firmware.
+ *
+ * Contents. The dump holds the fault status registers, the stacked exception
+ * frame, the CRASHDUMP_STACK_WORDS words above it, and the last
+ * CRASHDUMP_TRACE_RECORDS records of the Log ring (format string addresses and
+ * raw arguments). All fields are little endian 32 bit words, except version
+ * and size. The record is self-delimiting: it starts with CRASHDUMP_MAGIC and
+ * ends with a CRC-32 of the preceding bytes.
+ *
+ * Placement. The dump lives in the CRASHDUMP NOINIT area of startup.s (Keil),
+ * in .TI.noinit (CCS), or in .noinit (GCC). Contents after a power on reset
+ * are garbage, so the magic and CRC decide whether a dump is valid.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Device specific imports. */
+#include <lib/UART/UART.h>
+#include <lib/Log/Log.h>
+
+
+/** @brief CRASHDUMP_MAGIC is the first word of a valid dump, "CRSH". */
+#define CRASHDUMP_MAGIC 0x48535243
+
+/** @brief CRASHDUMP_VERSION is the dump format version. */
+#define CRASHDUMP_VERSION 1
+
+/** @brief CRASHDUMP_STACK_WORDS is the number of stack words saved above the
+ *         exception frame. */
+#define CRASHDUMP_STACK_WORDS 64
+
+/** @brief CRASHDUMP_TRACE_RECORDS is the number of Log records saved. */
+#define CRASHDUMP_TRACE_RECORDS 8
+
+/** @brief CrashDumpTrace_t is a Log record with fixed width fields. */
+typedef struct CrashDumpTrace {
+    /** @brief The cycle counter when the record was written. */
+    uint32_t timestamp;
+
+    /** @brief The address of the format string. */
+    uint32_t format;
+
+    /** @brief The number of arguments used. */
+    uint32_t numArgs;
+
+    /** @brief The raw arguments. */
+    uint32_t args[LOG_MAX_ARGS];
+} CrashDumpTrace_t;
+
+/** @brief CrashDump_t is the record written at a fault. */
+typedef struct CrashDump {
+    /** @brief CRASHDUMP_MAGIC. */
+    uint32_t magic;
+
+    /** @brief CRASHDUMP_VERSION. */
+    uint16_t version;
+
+    /** @brief sizeof(CrashDump_t). */
+    uint16_t size;
+
+    /** @brief The cycle counter at the fault. */
+    uint32_t timestamp;
+
+    /** @brief Configurable, hard fault, memory management fault address and
+     *         bus fault address registers. See p. 177 - 184 of the TM4C
+     *         Datasheet (FAULTSTAT, HFAULTSTAT, MMADDR, FAULTADDR). */
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+
+    /** @brief The EXC_RETURN value in LR at the fault. */
+    uint32_t excReturn;
+
+    /** @brief The stack pointer at the fault, pointing to the frame. */
+    uint32_t sp;
+
+    /** @brief The stacked r0, r1, r2, r3, r12, lr, pc and xpsr. Zero if sp was
+     *         outside of SRAM. */
+    uint32_t frame[8];
+
+    /** @brief The number of valid words in stack. */
+    uint32_t numStack;
+
+    /** @brief The stack above the exception frame, from low to high address. */
+    uint32_t stack[CRASHDUMP_STACK_WORDS];
+
+    /** @brief The number of valid records in trace. */
+    uint32_t numTrace;
+
+    /** @brief The most recent Log records, oldest first. */
+    CrashDumpTrace_t trace[CRASHDUMP_TRACE_RECORDS];
+
+    /** @brief CRC-32 (IEEE 802.3) of the preceding bytes. */
+    uint32_t crc;
+} CrashDump_t;
+
+/**
+ * @brief CrashDumpCapture writes a dump of the current fault. Called from
+ *        _ReportHardFault with interrupts disabled, or from CheckFail without
+ *        an exception frame.
+ *
+ * @param stackFrame The stack pointer at the fault, or NULL if there is no
+ *                   exception frame.
+ * @param excReturn The EXC_RETURN value in LR at the fault, or 0 if there is
+ *                  no exception frame.
+ */
+void CrashDumpCapture(uint32_t * stackFrame, uint32_t excReturn);
+
+/**
+ * @brief CrashDumpGet returns the dump left by the last fault.
+ *
+ * @return The dump, or NULL if there is no valid dump.
+ */
+const CrashDump_t * CrashDumpGet(void);
+
+/**
+ * @brief CrashDumpClear invalidates the dump.
+ */
+void CrashDumpClear(void);
+
+/**
+ * @brief CrashDumpReport transmits the dump left by the last fault, if any,
+ *        as raw bytes over a UART, then clears it. Call once at boot.
+ *
+ * @param uart The UART to transmit across.
+ * @return Whether a dump was sent.
+ */
+bool CrashDumpReport(UART_t uart);
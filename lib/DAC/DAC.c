@@ -6,8 +6,15 @@
  * @date 2021-09-24
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support WTimers, multiple clock
- * modes, nor count up vs count down. B-side timers are currently broken.
+ * Bulk Output. DACInit groups the DAC pins by GPIO port and precomputes, for
+ * every sample value, the bits to write to each port. DACOut then writes each
+ * port once through its masked GPIODATA address, so all bits of a sample on
+ * the same port change together. DACOutBuffer streams a sample array from a
+ * timer interrupt.
+ *
+ * Waveforms. DACWaveformWrite and DACWaveformStream hand the output to the
+ * uDMA, paced by a timer's timeout request. The timer's timeout interrupt is
+ * disabled; the timer vector only fires on uDMA completion.
  */
 
 /** General Imports. */
@@ -17,7 +24,7 @@
 #include <math.h>
 
 /** Device specific imports. */
-#include <inc/regDefs.h>
+#include <inc/RegDefs.h>
 #include <lib/DAC/DAC.h>
 
 
@@ -25,21 +32,125 @@
 static struct DACMap {
     uint32_t address;
 } dacMap[PORT_COUNT] = {
-    0x40004000, // PA
-    0x40005000, // PB
-    0x40006000, // PC
-    0x40007000, // PD
-    0x40024000, // PE
-    0x40025000, // PF
+    {0x40004000}, // PA
+    {0x40005000}, // PB
+    {0x40006000}, // PC
+    {0x40007000}, // PD
+    {0x40024000}, // PE
+    {0x40025000}, // PF
 };
 
+/** @brief DACSettings is the precomputed output data of each DAC. */
+static struct DACSettings {
+    /** @brief The pins array the DAC was initialized with. */
+    GPIOPin_t * pins;
+
+    /** @brief The number of GPIO ports the DAC pins are spread across. */
+    uint8_t numPorts;
+
+    /** @brief The masked GPIODATA address of each port. Only the DAC pins of
+     *         the port are affected by a store to this address. */
+    volatile uint32_t * portData[DAC_MAX_BITS];
+
+    /** @brief The value to store to each port for each sample value. */
+    uint8_t scatter[DAC_MAX_BITS][1 << DAC_MAX_BITS];
+
+    /** @brief Mask of the sample bits driven by the DAC. */
+    uint8_t sampleMask;
+
+    /** @brief The buffer being streamed. */
+    const uint8_t * samples;
+
+    /** @brief The number of samples in the buffer. */
+    uint32_t numSamples;
+
+    /** @brief Index of the next sample. */
+    uint32_t index;
+
+    /** @brief Whether the buffer is replayed once it completes. */
+    bool isLooping;
+
+    /** @brief Whether a buffer is being streamed. */
+    volatile bool isBusy;
+
+    /** @brief The timer pacing the buffer. */
+    Timer_t timer;
+
+    /** @brief User function associated with buffer completion. */
+    void (*doneTask)(uint32_t *args);
+
+    /** @brief User args associated with the completion function. */
+    uint32_t * doneArgs;
+
+    /** @brief The waveform configuration set by DACWaveformInit. */
+    DACWaveformConfig_t waveform;
+
+    /** @brief uDMA channel feeding the port, if DACWaveformInit was called. */
+    DMA_t dma;
+
+    /** @brief Whether the uDMA is feeding the port. */
+    bool isWaveform;
+
+    /** @brief Whether the waveform alternates between two buffers. */
+    bool isPingPong;
+
+    /** @brief The waveform buffer being output, or the first of two. */
+    uint8_t * wordsA;
+
+    /** @brief The second waveform buffer, for ping-pong streams. */
+    uint8_t * wordsB;
+
+    /** @brief The number of words in each waveform buffer. */
+    uint16_t numWords;
+} DACSettings[DAC_MAX_COUNT];
+
+/** @brief The number of DACSettings in use. */
+static uint8_t DACCount = 0;
+
+/**
+ * @brief DACHalt stops any buffer or waveform in progress on a DAC.
+ *
+ * @param settings The DAC settings.
+ */
+static void DACHalt(struct DACSettings * settings) {
+    if (!settings->isBusy) return;
+
+    if (settings->isWaveform) {
+        DMAStop(settings->dma);
+        DMAAcknowledge(settings->dma);
+        settings->isWaveform = false;
+    }
+    TimerStop(settings->timer);
+    settings->isBusy = false;
+}
+
 DAC_t DACInit(DACConfig_t config) {
+    /* Initialization asserts. */
+    assert(config.pins != NULL);
+    assert(0 < config.numPins && config.numPins <= DAC_MAX_BITS);
+
+    /* 1. Find the settings slot, reusing the slot of the same pins array. */
+    uint8_t id;
+    for (id = 0; id < DACCount && DACSettings[id].pins != config.pins; ++id) {}
+    if (id == DACCount) {
+        assert(DACCount < DAC_MAX_COUNT);
+        ++DACCount;
+    }
+    struct DACSettings * settings = &DACSettings[id];
+    settings->pins = config.pins;
+    settings->numPorts = 0;
+    settings->sampleMask = (1 << config.numPins) - 1;
+    DACHalt(settings);
+
     /** For each specified pin. */
     uint8_t i;
+    uint8_t portMasks[DAC_MAX_BITS] = { 0 };
+    uint8_t portIDs[DAC_MAX_BITS];
+    uint8_t pinPorts[DAC_MAX_BITS];
     for (i = 0; i < config.numPins; ++i) {
-        assert(config.pins[i] != NULL);
+        assert(config.pins[i] < PIN_COUNT);
 
-        /* Initialize pin. */
+        /* 2. Initialize pin. */
         GPIOConfig_t pinConfig = {
             .pin=config.pins[i],
             .pull=GPIO_PULL_DOWN,
@@ -50,23 +161,306 @@ DAC_t DACInit(DACConfig_t config) {
             .enableSlew=false
         };
         GPIOInit(pinConfig);
+
+        /* 3. Group the pin with the other pins of its port. */
+        uint8_t port = config.pins[i] / PINS_PER_PORT;
+        uint8_t j;
+        for (j = 0; j < settings->numPorts && portIDs[j] != port; ++j) {}
+        if (j == settings->numPorts) {
+            portIDs[j] = port;
+            ++settings->numPorts;
+        }
+        portMasks[j] |= 1 << (config.pins[i] % PINS_PER_PORT);
+        pinPorts[i] = j;
+    }
+
+    /* 4. Precompute the masked data address of each port. Address bits [9:2]
+          mask which pins a store affects. */
+    for (i = 0; i < settings->numPorts; ++i) {
+        settings->portData[i] = (volatile uint32_t *)(uintptr_t)(dacMap[portIDs[i]].address + (portMasks[i] << 2));
+    }
+
+    /* 5. Precompute the port values of every sample value. */
+    uint8_t value;
+    for (value = 0; value <= settings->sampleMask; ++value) {
+        for (i = 0; i < settings->numPorts; ++i) {
+            settings->scatter[i][value] = 0;
+        }
+        for (i = 0; i < config.numPins; ++i) {
+            if ((value >> i) & 0x1) {
+                settings->scatter[pinPorts[i]][value] |= 1 << (config.pins[i] % PINS_PER_PORT);
+            }
+        }
     }
 
     DAC_t dac = {
         .pins=config.pins,
-        .numPins=config.numPins
+        .numPins=config.numPins,
+        .id=id
     };
 
     return dac;
 }
 
 void DACOut(DAC_t dac, uint8_t data) {
+    struct DACSettings * settings = &DACSettings[dac.id];
+    uint8_t value = data & settings->sampleMask;
+
+    /* One masked store per port. */
     uint8_t i;
-    for (i = 0; i < dac.numPins; ++i) {
-		uint32_t addr = 
-			dacMap[(uint8_t)(dac.pins[i] / PINS_PER_PORT)].address + 
-			(0x4 << (dac.pins[i] % PINS_PER_PORT));
-		uint32_t value = ((data >> i) & 0x1) << (dac.pins[i] % PINS_PER_PORT);
-        GET_REG(addr) = value;
+    for (i = 0; i < settings->numPorts; ++i) {
+        *settings->portData[i] = settings->scatter[i][value];
     }
 }
+
+/**
+ * @brief DACBufferHandler outputs the next sample of a buffer. Called from the
+ *        timer interrupt.
+ *
+ * @param args Pointer to the DAC settings.
+ */
+static void DACBufferHandler(uint32_t * args) {
+    struct DACSettings * settings = (struct DACSettings *)args;
+    if (!settings->isBusy) return;
+
+    /* 1. Output the next sample. */
+    uint8_t value = settings->samples[settings->index] & settings->sampleMask;
+    uint8_t i;
+    for (i = 0; i < settings->numPorts; ++i) {
+        *settings->portData[i] = settings->scatter[i][value];
+    }
+
+    /* 2. Advance, replaying or stopping at the end of the buffer. */
+    if (++settings->index < settings->numSamples) return;
+    settings->index = 0;
+    if (settings->isLooping) return;
+
+    TimerStop(settings->timer);
+    settings->isBusy = false;
+    if (settings->doneTask != NULL) {
+        settings->doneTask(settings->doneArgs);
+    }
+}
+
+void DACOutBuffer(DAC_t dac, DACBufferConfig_t config) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+    assert(config.samples != NULL);
+    assert(config.numSamples > 0);
+    assert(config.period > 0);
+    assert(config.priority <= 7);
+
+    struct DACSettings * settings = &DACSettings[dac.id];
+
+    /* 1. Stop any buffer in progress. */
+    DACHalt(settings);
+
+    /* 2. Load the buffer. */
+    settings->samples = config.samples;
+    settings->numSamples = config.numSamples;
+    settings->index = 0;
+    settings->isLooping = config.isLooping;
+    settings->doneTask = config.doneTask;
+    settings->doneArgs = config.doneArgs;
+
+    /* 3. Pace the buffer with a periodic timer. */
+    TimerConfig_t timerConfig = {
+        .timerID=config.timerID,
+        .period=config.period,
+        .isIndividual=false,
+        .prescale=0,
+        .timerTask=DACBufferHandler,
+        .isPeriodic=true,
+        .priority=config.priority,
+        .timerArgs=(uint32_t *)settings
+    };
+    settings->timer = TimerInit(timerConfig);
+    settings->isBusy = true;
+    TimerStart(settings->timer);
+}
+
+/**
+ * @brief DACWaveformLoad arms a uDMA control structure with a waveform buffer.
+ *
+ * @param settings The DAC settings.
+ * @param words The buffer to output.
+ * @param isAlternate Whether to load the alternate control structure.
+ */
+static void DACWaveformLoad(struct DACSettings * settings, uint8_t * words, bool isAlternate) {
+    DMATransfer_t transfer = {
+        .source=words,
+        .destination=settings->portData[0],
+        .count=settings->numWords,
+        .size=DMA_SIZE_8,
+        .isSourceIncrementing=true,
+        .isDestinationIncrementing=false,
+        .arbitration=DMA_ARB_1,
+        .mode=settings->isPingPong ? DMA_MODE_PINGPONG : DMA_MODE_BASIC
+    };
+    DMASetTransfer(settings->dma, transfer, isAlternate);
+}
+
+/**
+ * @brief DACWaveformHandler is the handler passed to the Timer interrupt
+ *        functions for waveforms. The timer interrupt only fires when the
+ *        uDMA completes a buffer.
+ *
+ * @param args Pointer to the DAC settings.
+ */
+static void DACWaveformHandler(uint32_t * args) {
+    struct DACSettings * settings = (struct DACSettings *)args;
+
+    if (!DMAAcknowledge(settings->dma)) return;
+    if (!settings->isWaveform) return;
+
+    if (settings->isPingPong) {
+        /* The controller has moved on to the other buffer. Refill and rearm
+           the buffer that completed. */
+        bool isPrimaryDone = DMAIsAlternate(settings->dma);
+        uint8_t * words = isPrimaryDone ? settings->wordsA : settings->wordsB;
+        if (settings->waveform.refillTask != NULL) {
+            settings->waveform.refillTask(words, settings->waveform.refillArgs);
+        }
+        DACWaveformLoad(settings, words, !isPrimaryDone);
+    } else if (settings->waveform.isLooping) {
+        DACWaveformLoad(settings, settings->wordsA, false);
+        DMAStart(settings->dma);
+    } else {
+        /* The port holds the last word written. */
+        TimerStop(settings->timer);
+        settings->isWaveform = false;
+        settings->isBusy = false;
+        if (settings->waveform.doneTask != NULL) {
+            settings->waveform.doneTask(settings->waveform.doneArgs);
+        }
+    }
+}
+
+/**
+ * @brief DACWaveformStart sets up the waveform timer and starts the uDMA. The
+ *        buffers must already be loaded.
+ *
+ * @param settings The DAC settings.
+ */
+static void DACWaveformStart(struct DACSettings * settings) {
+    TimerID_t timerID = settings->waveform.timerID;
+    uint32_t timerOffset = 0x1000 * (uint32_t)(timerID >> 1);
+
+    /* 1. Set up the timer. It is reconfigured on every start since
+          DACOutBuffer may have reused it. */
+    TimerConfig_t timerConfig = {
+        .timerID=timerID,
+        .period=settings->waveform.period,
+        .isIndividual=true,
+        .prescale=0,
+        .timerTask=DACWaveformHandler,
+        .isPeriodic=true,
+        .priority=settings->waveform.priority,
+        .timerArgs=(uint32_t *)settings
+    };
+    settings->timer = TimerInit(timerConfig);
+
+    /* 2. Disarm the timeout interrupt. The timeout still requests a uDMA
+          transfer every period. */
+    GET_REG(GPTM_BASE + timerOffset + GPTMIMR_OFFSET) &=
+        ((timerID % 2) == 0) ? ~0x00000001 : ~0x00000100;
+
+    /* 3. Start the stream. */
+    settings->isWaveform = true;
+    settings->isBusy = true;
+    DMAStart(settings->dma);
+    TimerStart(settings->timer);
+}
+
+void DACWaveformInit(DAC_t dac, DACWaveformConfig_t config) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+    assert(config.timerID <= TIMER_5B);
+    assert(1 < config.period && config.period <= 0x10000);
+    assert(config.priority <= 7);
+
+    struct DACSettings * settings = &DACSettings[dac.id];
+
+    /* The uDMA writes a single address, so all pins must share a port. */
+    assert(settings->numPorts == 1);
+
+    /* 1. Stop anything in progress. */
+    DACHalt(settings);
+
+    /* 2. Connect the timer to its uDMA channel. */
+    settings->waveform = config;
+    settings->dma = DMAInit(DMAGetTimerConfig(config.timerID));
+}
+
+void DACWaveformConvert(DAC_t dac, const uint8_t * samples, uint16_t numSamples, uint8_t * words) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+    assert(samples != NULL);
+    assert(words != NULL);
+
+    struct DACSettings * settings = &DACSettings[dac.id];
+    uint16_t i;
+    for (i = 0; i < numSamples; ++i) {
+        words[i] = settings->scatter[0][samples[i] & settings->sampleMask];
+    }
+}
+
+void DACWaveformWrite(DAC_t dac, const uint8_t * words, uint16_t numWords) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+    assert(words != NULL);
+    assert(0 < numWords && numWords <= 1024);
+
+    struct DACSettings * settings = &DACSettings[dac.id];
+
+    /* 1. Cancel anything in progress. */
+    DACHalt(settings);
+
+    /* 2. Arm the channel. The words are only read by the uDMA. */
+    settings->isPingPong = false;
+    settings->wordsA = (uint8_t *)words;
+    settings->wordsB = NULL;
+    settings->numWords = numWords;
+    DACWaveformLoad(settings, settings->wordsA, false);
+
+    /* 3. The next timeout outputs the first word. */
+    DACWaveformStart(settings);
+}
+
+void DACWaveformStream(DAC_t dac, uint8_t * wordsA, uint8_t * wordsB, uint16_t numWords) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+    assert(wordsA != NULL);
+    assert(wordsB != NULL);
+    assert(0 < numWords && numWords <= 1024);
+
+    struct DACSettings * settings = &DACSettings[dac.id];
+
+    /* 1. Cancel anything in progress. */
+    DACHalt(settings);
+
+    /* 2. Arm both control structures. */
+    settings->isPingPong = true;
+    settings->wordsA = wordsA;
+    settings->wordsB = wordsB;
+    settings->numWords = numWords;
+    DACWaveformLoad(settings, wordsA, false);
+    DACWaveformLoad(settings, wordsB, true);
+
+    /* 3. The next timeout outputs the first word of wordsA. */
+    DACWaveformStart(settings);
+}
+
+void DACStop(DAC_t dac) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+
+    DACHalt(&DACSettings[dac.id]);
+}
+
+bool DACIsBusy(DAC_t dac) {
+    /* Initialization asserts. */
+    assert(dac.id < DACCount);
+
+    return DACSettings[dac.id].isBusy;
+}
@@ -3,17 +3,39 @@
  * Devices: LM4F120; TM4C123
  * Description: Low level drivers to configure a resistor ladder DAC output.
  * Authors: Matthew Yu.
- * Last Modified: 04/17/21
+ * Last Modified: 03/04/22
+ * @note
+ * Bulk Output. DACInit groups the DAC pins by GPIO port and precomputes, for
+ * every sample value, the bits to write to each port. DACOut then writes each
+ * port once through its masked GPIODATA address, so all bits of a sample on
+ * the same port change together. DACOutBuffer streams a sample array from a
+ * timer interrupt.
+ *
+ * Waveforms. For jitter free output at high sample rates, DACWaveformInit
+ * connects a timer's timeout request to the uDMA, which copies one
+ * preconverted port word per period into the masked GPIODATA address of the
+ * DAC. The CPU is only interrupted when a buffer completes. Waveforms require
+ * all DAC pins to be on the same port, since a uDMA channel writes a single
+ * address.
  */
 #pragma once
 
 /** General imports. */
 #include <stdint.h>
+#include <stdbool.h>
 
 /** Device specific imports. */
 #include <lib/GPIO/GPIO.h>
+#include <lib/Timer/Timer.h>
+#include <lib/DMA/DMA.h>
 
 
+/** @brief DAC_MAX_BITS is the maximum resolution of a DAC. */
+#define DAC_MAX_BITS 6
+
+/** @brief DAC_MAX_COUNT is the maximum number of DACs configured at once. */
+#define DAC_MAX_COUNT 4
+
 /** @brief DACConfig_t is a user defined struct that specifies an up to 6 bit
  *         DAC configuration. */
 typedef struct DACConfig {
@@ -35,24 +57,236 @@ typedef struct DAC {
 
     /** @brief numPins is the number of pins specified for the DAC. */
     uint8_t numPins;
+
+    /** @brief Index of the precomputed port masks and scatter table. */
+    uint8_t id;
 } DAC_t;
 
+/** @brief DACBufferConfig_t is a user defined struct that specifies a sample
+ *         array streamed to a DAC at a fixed rate. */
+typedef struct DACBufferConfig {
+    /**
+     * @brief The samples to output, in order. Must remain valid until the
+     *        buffer completes (or indefinitely, when looping).
+     *
+     * Default is NULL. This must be set.
+     */
+    const uint8_t * samples;
+
+    /**
+     * @brief The number of samples.
+     *
+     * Default is 0. This must be set.
+     */
+    uint32_t numSamples;
+
+    /**
+     * @brief The timer that paces the samples. Must not be used elsewhere.
+     *
+     * Default is TIMER_0A.
+     */
+    TimerID_t timerID;
+
+    /**
+     * @brief The sample period, in cycles. Use freqToPeriod() to convert a
+     *        sample rate.
+     *
+     * This value must be specified and be greater than zero.
+     */
+    uint32_t period;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Whether the buffer is replayed from the start once it completes.
+     *
+     * Default is false (The last sample is held after the buffer completes).
+     */
+    bool isLooping;
+
+    /**
+     * @brief Pointer to function called from the timer interrupt when a
+     *        non-looping buffer completes.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+
+    /**
+     * @brief Timer interrupt priority. From 0 - 7. Lower value is higher
+     *        priority.
+     *
+     * Default is 0 (Highest priority).
+     */
+    uint8_t priority;
+} DACBufferConfig_t;
+
+/** @brief DACWaveformConfig_t is a user defined struct that specifies a uDMA
+ *         fed DAC waveform. */
+typedef struct DACWaveformConfig {
+    /**
+     * @brief The timer whose timeout requests each uDMA transfer. From
+     *        TIMER_0A to TIMER_5B. The timer runs as an individual 16 bit
+     *        timer and must not be used elsewhere.
+     *
+     * Default is TIMER_0A.
+     */
+    TimerID_t timerID;
+
+    /**
+     * @brief The sample period, in cycles. From 2 - 65536. Use freqToPeriod()
+     *        to convert a sample rate.
+     *
+     * This value must be specified. Failing this condition will trigger an
+     * internal assert in debug mode.
+     */
+    uint32_t period;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Whether a buffer written with DACWaveformWrite is replayed from
+     *        the start once it completes.
+     *
+     * Default is false (The last sample is held after the buffer completes).
+     */
+    bool isLooping;
+
+    /**
+     * @brief Pointer to function called from the timer interrupt when a
+     *        non-looping buffer completes.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+
+    /**
+     * @brief Pointer to function called from the timer interrupt when one
+     *        half of a DACWaveformStream buffer has been output. The half is
+     *        passed in and should be refilled with DACWaveformConvert before
+     *        the other half completes.
+     *
+     * Default is NULL (The halves are replayed as is).
+     */
+    void (*refillTask)(uint8_t *words, uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        refillTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * refillArgs;
+
+    /**
+     * @brief Timer interrupt priority. From 0 - 7. Lower value is higher
+     *        priority.
+     *
+     * Default is 0 (Highest priority).
+     */
+    uint8_t priority;
+} DACWaveformConfig_t;
+
 /**
- * DACInit initializes an N-bit DAC on Port B.
+ * DACInit initializes an N-bit DAC.
  * @param pins A list of pins to initialize, in order of LSB to MSB.
  * @note Assumes that the first pin that is invalid (PIN_COUNT) means all
  *       following pins are invalid. 
  *       Goes up to 6 bits of resolution. 
- *       Multiple DACs can be configured, but the user retains responsibility
- *       for managing the pins data structures.
+ *       Up to DAC_MAX_COUNT DACs can be configured. Reinitializing a DAC with
+ *       the same pins array reuses its slot.
  */
 DAC_t DACInit(DACConfig_t config);
 
 /**
  * DACOut outputs data to the relevant DAC pins set by DACInit.
- * @param pins The list of pins to write data to, in order of LSB to MSB.
- * @param data A value from 0 - 255. Scaled based on how many bits are part of the DAC.
- * @note Assumes that the first pin that is invalid (PIN_COUNT) means all
- *       following pins are invalid. 
+ * @param dac The DAC to write data to.
+ * @param data A value from 0 - 2^numPins - 1. Bit N drives pin N. Higher bits
+ *             are ignored.
+ * @note Each GPIO port used by the DAC is written with a single store.
  */
 void DACOut(DAC_t dac, uint8_t data);
+
+/**
+ * DACOutBuffer starts streaming a sample array to a DAC, one sample per timer
+ * period, and returns immediately.
+ * @param dac The DAC to write data to.
+ * @param config The samples and the rate to output them at.
+ * @note Requires calling EnableInterrupts() for samples to be output. A new
+ *       buffer replaces any buffer in progress.
+ */
+void DACOutBuffer(DAC_t dac, DACBufferConfig_t config);
+
+/**
+ * DACWaveformInit connects a DAC to a timer paced uDMA channel. Does not
+ * output anything until a buffer is written.
+ * @param dac The DAC to drive. All of its pins must be on the same port.
+ * @param config The timer and callbacks of the waveform.
+ * @note Requires calling EnableInterrupts() for doneTask, refillTask, and
+ *       looping to work.
+ */
+void DACWaveformInit(DAC_t dac, DACWaveformConfig_t config);
+
+/**
+ * DACWaveformConvert converts samples into the port words the uDMA copies
+ * into GPIODATA.
+ * @param dac The DAC the words are for.
+ * @param samples The samples to convert. Bit N drives pin N.
+ * @param numSamples The number of samples to convert.
+ * @param words Output array of at least numSamples length. May be the same
+ *              array as samples.
+ */
+void DACWaveformConvert(DAC_t dac, const uint8_t * samples, uint16_t numSamples, uint8_t * words);
+
+/**
+ * DACWaveformWrite starts outputting a buffer of port words, one per timer
+ * period, and returns immediately. A new buffer replaces any buffer in
+ * progress.
+ * @param dac The DAC to write to. Must be initialized with DACWaveformInit.
+ * @param words Port words built with DACWaveformConvert. Must remain valid
+ *              until the buffer completes (or indefinitely, when looping).
+ * @param numWords The number of words. From 1 - 1024.
+ */
+void DACWaveformWrite(DAC_t dac, const uint8_t * words, uint16_t numWords);
+
+/**
+ * DACWaveformStream continuously outputs two buffers of port words in turn
+ * using a ping-pong uDMA transfer. refillTask is called with each buffer as
+ * soon as it has been output, so it can be refilled while the other plays.
+ * Runs until DACStop is called.
+ * @param dac The DAC to write to. Must be initialized with DACWaveformInit.
+ * @param wordsA The first buffer to output.
+ * @param wordsB The second buffer to output.
+ * @param numWords The number of words in each buffer. From 1 - 1024.
+ */
+void DACWaveformStream(DAC_t dac, uint8_t * wordsA, uint8_t * wordsB, uint16_t numWords);
+
+/**
+ * DACStop stops any buffer or waveform streaming to a DAC. The last sample is
+ * held.
+ * @param dac The DAC to stop.
+ */
+void DACStop(DAC_t dac);
+
+/**
+ * DACIsBusy returns whether a DAC is still streaming a buffer or waveform.
+ * @param dac The DAC to check.
+ * @return True if the buffer has not yet completed.
+ */
+bool DACIsBusy(DAC_t dac);
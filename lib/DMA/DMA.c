@@ -0,0 +1,290 @@
+/**
+ * @file DMA.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Micro Direct Memory Access (uDMA) peripheral driver.
+ * @version 0.1
+ * @date 2022-03-01
+ * @copyright Copyright (c) 2022
+ * @note
+ * Modes. This driver supports the basic, auto, ping-pong, and memory and
+ * peripheral scatter-gather transfer modes.
+ *
+ * Unsupported Features. This driver does not support the uDMA error interrupt
+ * beyond clearing it.
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <assert.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/DMA/DMA.h>
+
+
+/**
+ * @brief DMAControlTable is the channel control table. The first 32 entries
+ *        are the primary control structures and the next 32 entries are the
+ *        alternate control structures. The table must be 1024 byte aligned.
+ */
+static DMAControl_t DMAControlTable[DMA_COUNT * 2] __attribute__((aligned(1024)));
+
+/** @brief DMAChannelSettings is a set of channel completion callbacks. */
+static struct DMAChannelSettings {
+    /** @brief User function associated with transfer completion. */
+    void (*doneTask)(uint32_t *args);
+
+    /** @brief User args associated with the completion function. */
+    uint32_t * doneArgs;
+} DMAChannelSettings[DMA_COUNT];
+
+/**
+ * @brief DMATimerMapping is the channel and encoding of each 16/32 bit timer.
+ *        See Table 9-1. uDMA Channel Assignments on p. 587 of the TM4C
+ *        Datasheet.
+ */
+static struct DMATimerMapping {
+    enum DMAChannel channel;
+    uint8_t assignment;
+} DMATimerMapping[TIMER_5B + 1] = {
+    {DMA18, 0}, /* Timer 0A. */
+    {DMA19, 0}, /* Timer 0B. */
+    {DMA20, 0}, /* Timer 1A. */
+    {DMA21, 0}, /* Timer 1B. */
+    {DMA4,  1}, /* Timer 2A. */
+    {DMA5,  1}, /* Timer 2B. */
+    {DMA2,  1}, /* Timer 3A. */
+    {DMA3,  1}, /* Timer 3B. */
+    {DMA0,  3}, /* Timer 4A. */
+    {DMA1,  3}, /* Timer 4B. */
+    {DMA8,  3}, /* Timer 5A. */
+    {DMA9,  3}, /* Timer 5B. */
+};
+
+DMA_t DMAInit(DMAConfig_t config) {
+    /* Initialization asserts. */
+    assert(config.channel < DMA_COUNT);
+    assert(config.assignment <= 4);
+    assert(config.priority <= 7);
+
+    /* 1. Enable the uDMA clock and stall until ready. */
+    if ((GET_REG(SYSCTL_BASE + SYSCTL_PRDMA_OFFSET) & 0x1) == 0) {
+        GET_REG(SYSCTL_BASE + SYSCTL_RCGCDMA_OFFSET) |= 0x1;
+        while ((GET_REG(SYSCTL_BASE + SYSCTL_PRDMA_OFFSET) & 0x1) == 0) {}
+
+        /* 2. Enable the uDMA controller and point it at the control table. */
+        GET_REG(UDMA_BASE + UDMA_CFG_OFFSET) = 0x1;
+        GET_REG(UDMA_BASE + UDMA_CTLBASE_OFFSET) = (uint32_t)(uintptr_t)DMAControlTable;
+    }
+
+    uint32_t channelBit = 1 << config.channel;
+
+    /* 3. Disable the channel during setup. */
+    GET_REG(UDMA_BASE + UDMA_ENACLR_OFFSET) = channelBit;
+
+    /* 4. Select the peripheral assignment. Each map register holds eight
+          4-bit encodings. */
+    uint32_t mapOffset = UDMA_CHMAP0_OFFSET + 4 * (config.channel / 8);
+    uint32_t mapShift = 4 * (config.channel % 8);
+    GET_REG(UDMA_BASE + mapOffset) &= ~(0xF << mapShift);
+    GET_REG(UDMA_BASE + mapOffset) |= config.assignment << mapShift;
+
+    /* 5. Set priority. */
+    if (config.isHighPriority) {
+        GET_REG(UDMA_BASE + UDMA_PRIOSET_OFFSET) = channelBit;
+    } else {
+        GET_REG(UDMA_BASE + UDMA_PRIOCLR_OFFSET) = channelBit;
+    }
+
+    /* 6. Use the primary control structure first. */
+    GET_REG(UDMA_BASE + UDMA_ALTCLR_OFFSET) = channelBit;
+
+    /* 7. Respond to single and burst requests, or only burst requests. */
+    if (config.isOnlyBurst) {
+        GET_REG(UDMA_BASE + UDMA_USEBURSTSET_OFFSET) = channelBit;
+    } else {
+        GET_REG(UDMA_BASE + UDMA_USEBURSTCLR_OFFSET) = channelBit;
+    }
+
+    /* 8. Allow the controller to recognize requests for this channel. */
+    GET_REG(UDMA_BASE + UDMA_REQMASKCLR_OFFSET) = channelBit;
+
+    /* 9. Assign the completion task. Software transfers complete on IRQ 46. */
+    DMAChannelSettings[config.channel].doneTask = config.doneTask;
+    DMAChannelSettings[config.channel].doneArgs = config.doneArgs;
+    if (config.doneTask != NULL) {
+        GET_REG(PERIPHERALS_BASE + NVIC_PRI11_OFFSET) &= ~0x00FF0000;
+        GET_REG(PERIPHERALS_BASE + NVIC_PRI11_OFFSET) |= config.priority << 21;
+        GET_REG(PERIPHERALS_BASE + NVIC_EN1_OFFSET) = 1 << (46 - 32);
+    }
+
+    DMA_t dma = {
+        .channel=config.channel
+    };
+
+    return dma;
+}
+
+DMAConfig_t DMAGetTimerConfig(TimerID_t timerID) {
+    /* Initialization asserts. */
+    assert(timerID <= TIMER_5B);
+
+    DMAConfig_t config = {
+        .channel=DMATimerMapping[timerID].channel,
+        .assignment=DMATimerMapping[timerID].assignment,
+        .isHighPriority=false,
+        .isOnlyBurst=false,
+        .doneTask=NULL,
+        .doneArgs=NULL,
+        .priority=0
+    };
+
+    return config;
+}
+
+DMAControl_t DMABuildControl(DMATransfer_t transfer) {
+    /* Initialization asserts. */
+    assert(0 < transfer.count && transfer.count <= 1024);
+    assert(transfer.size <= DMA_SIZE_32);
+    assert(transfer.arbitration <= DMA_ARB_1024);
+    assert(transfer.mode <= DMA_MODE_PERIPH_SG_ALT);
+
+    /* The end pointers point to the last item, not one past it. A fixed
+       address (increment of 0x3) points at the item itself. */
+    uint32_t span = (uint32_t)(transfer.count - 1) << transfer.size;
+    uint32_t increment = transfer.size;
+
+    DMAControl_t control = {
+        .sourceEnd=(uint32_t)(uintptr_t)transfer.source +
+            (transfer.isSourceIncrementing ? span : 0),
+        .destinationEnd=(uint32_t)(uintptr_t)transfer.destination +
+            (transfer.isDestinationIncrementing ? span : 0),
+        .control=
+            ((transfer.isDestinationIncrementing ? increment : 0x3) << 30) |
+            (transfer.size << 28) |
+            ((transfer.isSourceIncrementing ? increment : 0x3) << 26) |
+            (transfer.size << 24) |
+            (transfer.arbitration << 14) |
+            ((uint32_t)(transfer.count - 1) << 4) |
+            transfer.mode,
+        .reserved=0
+    };
+
+    return control;
+}
+
+void DMASetTransfer(DMA_t dma, DMATransfer_t transfer, bool isAlternate) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    DMAControlTable[dma.channel + isAlternate * DMA_COUNT] = DMABuildControl(transfer);
+}
+
+void DMASetScatterGather(DMA_t dma, DMAControl_t * tasks, uint16_t numTasks, bool isPeripheral) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+    assert(tasks != NULL);
+    assert(0 < numTasks && numTasks <= 256);
+
+    /* 1. Every task but the last continues the chain using the alternate
+          scatter-gather mode. The last task is a plain transfer so the channel
+          completes (and interrupts) when it is done. */
+    uint16_t i;
+    for (i = 0; i < numTasks; ++i) {
+        tasks[i].control &= ~0x7;
+        if (i < numTasks - 1) {
+            tasks[i].control |= isPeripheral ? DMA_MODE_PERIPH_SG_ALT : DMA_MODE_MEM_SG_ALT;
+        } else {
+            tasks[i].control |= isPeripheral ? DMA_MODE_BASIC : DMA_MODE_AUTO;
+        }
+    }
+
+    /* 2. The primary control structure copies each task (four words) into the
+          alternate control structure. The arbitration size must be four. */
+    DMATransfer_t copy = {
+        .source=tasks,
+        .destination=&DMAControlTable[dma.channel + DMA_COUNT],
+        .count=numTasks * 4,
+        .size=DMA_SIZE_32,
+        .isSourceIncrementing=true,
+        .isDestinationIncrementing=true,
+        .arbitration=DMA_ARB_4,
+        .mode=isPeripheral ? DMA_MODE_PERIPH_SG : DMA_MODE_MEM_SG
+    };
+
+    /* The destination always ends at the last word of the alternate structure,
+       regardless of how many tasks are copied. */
+    DMAControl_t control = DMABuildControl(copy);
+    control.destinationEnd = (uint32_t)(uintptr_t)&DMAControlTable[dma.channel + DMA_COUNT].reserved;
+    DMAControlTable[dma.channel] = control;
+
+    /* 3. Start from the primary control structure. */
+    GET_REG(UDMA_BASE + UDMA_ALTCLR_OFFSET) = 1 << dma.channel;
+}
+
+void DMAStart(DMA_t dma) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    GET_REG(UDMA_BASE + UDMA_ENASET_OFFSET) = 1 << dma.channel;
+}
+
+void DMAStop(DMA_t dma) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    GET_REG(UDMA_BASE + UDMA_ENACLR_OFFSET) = 1 << dma.channel;
+}
+
+void DMARequest(DMA_t dma) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    GET_REG(UDMA_BASE + UDMA_SWREQ_OFFSET) = 1 << dma.channel;
+}
+
+bool DMAIsActive(DMA_t dma) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    return (GET_REG(UDMA_BASE + UDMA_ENASET_OFFSET) >> dma.channel) & 0x1;
+}
+
+bool DMAIsAlternate(DMA_t dma) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    return (GET_REG(UDMA_BASE + UDMA_ALTSET_OFFSET) >> dma.channel) & 0x1;
+}
+
+bool DMAAcknowledge(DMA_t dma) {
+    /* Initialization asserts. */
+    assert(dma.channel < DMA_COUNT);
+
+    uint32_t channelBit = 1 << dma.channel;
+    if (GET_REG(UDMA_BASE + UDMA_CHIS_OFFSET) & channelBit) {
+        /* Write one to clear. */
+        GET_REG(UDMA_BASE + UDMA_CHIS_OFFSET) = channelBit;
+        return true;
+    }
+    return false;
+}
+
+void uDMA_Handler(void) {
+    uint32_t status = GET_REG(UDMA_BASE + UDMA_CHIS_OFFSET);
+
+    /* Find which software channels completed. Could be multiple at once.
+       Peripheral channels are left for their peripheral handlers. */
+    uint8_t i;
+    for (i = 0; i < DMA_COUNT; ++i) {
+        if ((status & (0x1 << i)) && DMAChannelSettings[i].doneTask != NULL) {
+            GET_REG(UDMA_BASE + UDMA_CHIS_OFFSET) = 0x1 << i;
+            DMAChannelSettings[i].doneTask(DMAChannelSettings[i].doneArgs);
+        }
+    }
+}
+
+void uDMA_Error(void) {
+    /* Acknowledge the bus error. */
+    GET_REG(UDMA_BASE + UDMA_ERRCLR_OFFSET) = 0x1;
+}
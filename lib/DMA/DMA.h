@@ -1,19 +1,36 @@
 /**
  * @file DMA.h
- * @author your name (you@domain.com)
- * @brief 
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Micro Direct Memory Access (uDMA) peripheral driver.
  * @version 0.1
  * @date 2022-03-01
- * 
  * @copyright Copyright (c) 2022
- * 
+ * @note
+ * Modes. This driver supports the basic, auto, ping-pong, and memory and
+ * peripheral scatter-gather transfer modes.
+ *
+ * Usage. Each channel is initialized once with DMAInit, then armed with a
+ * control structure using DMASetTransfer (or DMASetScatterGather) and enabled
+ * with DMAStart. Peripheral channels signal completion on the peripheral's own
+ * interrupt vector; the peripheral handler should call DMAAcknowledge to check
+ * and clear the completion flag. Software channels signal completion on
+ * uDMA_Handler, which calls the channel's doneTask.
+ *
+ * Unsupported Features. This driver does not support the uDMA error interrupt
+ * beyond clearing it.
  */
 
 #pragma once
 
+/** General imports. */
 #include <stdint.h>
 #include <stdbool.h>
 
+/** Device specific imports. */
+#include <lib/Timer/Timer.h>
+
+
+/** @brief DMAChannel is an enumeration specifying one of 32 uDMA channels. */
 enum DMAChannel {
     DMA0,
     DMA1,
@@ -50,44 +67,294 @@ enum DMAChannel {
     DMA_COUNT
 };
 
+/** @brief DMAMode is an enumeration specifying the transfer mode of a control
+ *         structure. See Table 9-2 on p. 596 of the TM4C Datasheet. */
+enum DMAMode {
+    DMA_MODE_STOP,
+    DMA_MODE_BASIC,
+    DMA_MODE_AUTO,
+    DMA_MODE_PINGPONG,
+    DMA_MODE_MEM_SG,
+    DMA_MODE_MEM_SG_ALT,
+    DMA_MODE_PERIPH_SG,
+    DMA_MODE_PERIPH_SG_ALT
+};
+
+/** @brief DMASize is an enumeration specifying the size of a single item
+ *         transferred. Source and destination sizes are always equal. */
+enum DMASize {
+    DMA_SIZE_8,
+    DMA_SIZE_16,
+    DMA_SIZE_32
+};
+
+/** @brief DMAArbitration is an enumeration specifying the number of items
+ *         transferred before the controller rearbitrates between channels. */
+enum DMAArbitration {
+    DMA_ARB_1,
+    DMA_ARB_2,
+    DMA_ARB_4,
+    DMA_ARB_8,
+    DMA_ARB_16,
+    DMA_ARB_32,
+    DMA_ARB_64,
+    DMA_ARB_128,
+    DMA_ARB_256,
+    DMA_ARB_512,
+    DMA_ARB_1024
+};
+
+/** @brief DMAConfig_t is a user defined struct that specifies a uDMA channel
+ *         configuration. */
 typedef struct DMAConfig {
+    /**
+     * @brief The uDMA channel to configure.
+     *
+     * Default is DMA0.
+     */
     enum DMAChannel channel;
 
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief The channel encoding (0 - 4) that selects which peripheral drives
+     *        the channel. See Table 9-1. uDMA Channel Assignments on p. 587 of
+     *        the TM4C Datasheet for more details.
+     *
+     * Default is 0.
+     */
     uint8_t assignment;
 
+    /**
+     * @brief Whether the channel is arbitrated ahead of default priority
+     *        channels.
+     *
+     * Default is false (Default priority).
+     */
     bool isHighPriority;
 
+    /**
+     * @brief Whether the channel only responds to burst requests. Useful for
+     *        peripherals with FIFOs that should only be serviced when the
+     *        FIFO trigger level is reached.
+     *
+     * Default is false (Responds to both single and burst requests).
+     */
     bool isOnlyBurst;
 
+    /**
+     * @brief Pointer to function called when a software channel transfer
+     *        completes. Peripheral channels complete on the peripheral's
+     *        interrupt vector instead.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+
+    /**
+     * @brief uDMA software interrupt priority. From 0 - 7. Lower value is
+     *        higher priority. Only used when doneTask is defined.
+     *
+     * Default is 0 (Highest priority).
+     */
+    uint8_t priority;
 } DMAConfig_t;
 
+/** @brief DMATransfer_t is a user defined struct that specifies a single uDMA
+ *         control structure (one transfer, or one scatter-gather task). */
+typedef struct DMATransfer {
+    /** @brief Address of the first item to read. */
+    const volatile void * source;
+
+    /** @brief Address of the first item to write. */
+    volatile void * destination;
+
+    /**
+     * @brief The number of items to transfer. From 1 - 1024.
+     *
+     * This value must be specified. Failing this condition will trigger an
+     * internal assert in debug mode.
+     */
+    uint16_t count;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief The size of each item.
+     *
+     * Default is DMA_SIZE_8.
+     */
+    enum DMASize size;
+
+    /**
+     * @brief Whether the source address advances by one item every transfer.
+     *        Peripheral data registers should not increment.
+     *
+     * Default is false (Fixed source address).
+     */
+    bool isSourceIncrementing;
+
+    /**
+     * @brief Whether the destination address advances by one item every
+     *        transfer. Peripheral data registers should not increment.
+     *
+     * Default is false (Fixed destination address).
+     */
+    bool isDestinationIncrementing;
+
+    /**
+     * @brief The number of items moved per request before rearbitration. For
+     *        peripherals this should match the FIFO trigger level.
+     *
+     * Default is DMA_ARB_1.
+     */
+    enum DMAArbitration arbitration;
+
+    /**
+     * @brief The transfer mode.
+     *
+     * Default is DMA_MODE_STOP. This must be set for a transfer to occur.
+     */
+    enum DMAMode mode;
+} DMATransfer_t;
+
+/** @brief DMAControl_t is a single entry of the uDMA channel control table.
+ *         It is also used as a scatter-gather task. */
+typedef struct DMAControl {
+    /** @brief Address of the last item read. */
+    uint32_t sourceEnd;
+
+    /** @brief Address of the last item written. */
+    uint32_t destinationEnd;
+
+    /** @brief Control word. See DMACHCTL on p. 631 of the TM4C Datasheet. */
+    uint32_t control;
+
+    /** @brief Unused by the controller. */
+    uint32_t reserved;
+} DMAControl_t;
+
+/** @brief DMA_t is a struct containing user relevant data of a uDMA channel. */
 typedef struct DMA {
-    
+    /** @brief The uDMA channel configured. */
+    enum DMAChannel channel;
 } DMA_t;
 
-single request
-burst request
-modes
-    stop
-    basic
-    auto
-    ping pong
-    scatter gather
-
+/**
+ * @brief DMAInit enables the uDMA controller (if not already enabled) and
+ *        configures a channel's attributes. Does not start a transfer.
+ *
+ * @param config Configuration for the channel.
+ * @return A DMA_t struct containing relevant data.
+ */
 DMA_t DMAInit(DMAConfig_t config);
-// Overall uDMA configuration
-    // Enable uDMA clock in RCGCDMA
-    // Enable uDMA controller in DMACFG
-    // Program location of channel control table
-// Channel attribute configuration
-    // Set priority
-    // Set primary channel control structure
-    // Allow uDMA to respond to single/burst request
-    // Allow uDMA to recognize channel requests
-// Channel control structure configuration
-    // for software memory transfer
-    // set source end ptr
-    // set dest end ptr
-    // set control word
-// Enable channel
-// Issue transfer request
\ No newline at end of file
+
+/**
+ * @brief DMAGetTimerConfig returns a channel configuration that connects the
+ *        uDMA to the timeout request of a 16/32 bit timer. The returned config
+ *        can be modified before being passed into DMAInit.
+ *
+ * @param timerID Timer to request transfers. Must be TIMER_0A - TIMER_5B.
+ * @return A DMAConfig_t with the channel and assignment fields populated.
+ */
+DMAConfig_t DMAGetTimerConfig(TimerID_t timerID);
+
+/**
+ * @brief DMABuildControl converts a transfer description into a control
+ *        table entry. Used to build scatter-gather task lists.
+ *
+ * @param transfer The transfer to convert.
+ * @return The equivalent control structure.
+ */
+DMAControl_t DMABuildControl(DMATransfer_t transfer);
+
+/**
+ * @brief DMASetTransfer loads a transfer into the primary or alternate control
+ *        structure of a channel. Does not enable the channel.
+ *
+ * @param dma Channel to load.
+ * @param transfer The transfer to load.
+ * @param isAlternate Whether to load the alternate control structure. Used
+ *                    for ping-pong transfers.
+ */
+void DMASetTransfer(DMA_t dma, DMATransfer_t transfer, bool isAlternate);
+
+/**
+ * @brief DMASetScatterGather loads a list of tasks into a channel. The channel
+ *        copies each task into its alternate control structure and executes
+ *        it in order. Does not enable the channel.
+ *
+ * @param dma Channel to load.
+ * @param tasks Array of tasks, built with DMABuildControl. Must remain valid
+ *              until the transfer completes. The mode of each task is
+ *              overwritten.
+ * @param numTasks The number of tasks. From 1 - 256.
+ * @param isPeripheral Whether the tasks are driven by peripheral requests or
+ *                     run to completion on a single software request.
+ */
+void DMASetScatterGather(DMA_t dma, DMAControl_t * tasks, uint16_t numTasks, bool isPeripheral);
+
+/**
+ * @brief DMAStart enables a channel. The channel then services requests from
+ *        its assigned peripheral, or from DMARequest for software transfers.
+ *
+ * @param dma Channel to start.
+ */
+void DMAStart(DMA_t dma);
+
+/**
+ * @brief DMAStop disables a channel. Any remaining items in the active control
+ *        structure are not transferred.
+ *
+ * @param dma Channel to stop.
+ */
+void DMAStop(DMA_t dma);
+
+/**
+ * @brief DMARequest issues a software request on a channel.
+ *
+ * @param dma Channel to request.
+ */
+void DMARequest(DMA_t dma);
+
+/**
+ * @brief DMAIsActive returns whether a channel is still enabled. The
+ *        controller disables a channel once its transfer completes.
+ *
+ * @param dma Channel to check.
+ * @return True if the transfer has not yet completed.
+ */
+bool DMAIsActive(DMA_t dma);
+
+/**
+ * @brief DMAIsAlternate returns whether the alternate control structure is
+ *        the one currently in use by a channel.
+ *
+ * @param dma Channel to check.
+ * @return True if the alternate control structure is active.
+ */
+bool DMAIsAlternate(DMA_t dma);
+
+/**
+ * @brief DMAAcknowledge checks and clears the completion flag of a channel.
+ *        Peripheral interrupt handlers should call this to determine whether
+ *        a uDMA transfer caused the interrupt.
+ *
+ * @param dma Channel to check.
+ * @return True if the channel completed a transfer since the last call.
+ */
+bool DMAAcknowledge(DMA_t dma);
+
+/** @brief uDMA software transfer completion handler. */
+void uDMA_Handler(void);
+
+/** @brief uDMA bus error handler. */
+void uDMA_Error(void);
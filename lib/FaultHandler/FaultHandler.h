@@ -6,7 +6,7 @@
  * @version 0.1
  * @date 2022-02-20
  * @copyright Copyright (c) 2021
- * @note There is a dependency on GPIO, UART, and Timer, but FaultHandler
+ * @note There is a dependency on Check, CrashDump and Log, but FaultHandler
  * doesn't need need to be added to the project if you don't want those
  * dependencies.
  */
@@ -16,9 +16,9 @@
 
 /**
  * @brief __aeabi_assert is called by assert when it is violated by a bad debug
- *        conditions. It takes the assert debug capture at the assert failure,
- *        turns on PF1 (the red LED) and sends debug output to UART_MODULE_0. It
- *        then loops indefinitely with interrupts turned OFF.
+ *        conditions. It counts and logs the failure under CHECK_ASSERT (see
+ *        Check.h), then halts with interrupts turned OFF, or resets the TM4C
+ *        with a crash dump if the policy of CHECK_ASSERT is CHECK_RESET.
  * 
  * @param expr The expression that caused the assert to fail.
  * @param file The file in which the assert failed.
@@ -35,25 +35,25 @@ void __aeabi_assert(const char *expr __attribute__((unused)), const char *file,
  *        by some WEAKly defined handlers in startup.s (or
  *        tm4c123gh6pm_startup_ccs.c) if the user has not implemented strong
  *        versions of those handlers.
- *        This function implementation turns on PF1 (the red LED) on the TM4C
- *        and loops indefinitely.
+ *        This function implementation captures a crash dump and resets the
+ *        TM4C.
  * 
  * @note Users are encouraged to override the implementation of HardFault_Handler
  *       using this function definition.
  * @note The weak implementation of HardFault_Handler, however, provides basic 
- *       debug functionality, including catching the stack trace, turning on the
- *       red indicator LED, and printing the stack trace to PC via UART.
+ *       debug functionality, catching the stack pointer at the fault and
+ *       passing it to _ReportHardFault.
  */
 void HardFault_Handler(void) __attribute__((noreturn));
 
 /**
  * @brief _ReportHardFault is a function exposed to startup.s's weakly defined
- *        HardFault_Handler. It takes the stackframe at the time of faulting,
- *        turns on PF1 (the red LED), and sends debug output to UART_MODULE_0.
- *        It then loops indefinitely with interrupts turned OFF.
+ *        HardFault_Handler. It captures a crash dump of the fault (see
+ *        CrashDump.h) and resets the TM4C. Call CrashDumpReport at boot to
+ *        send the dump to the PC.
  * 
  * @param stackFrame Reference to registers that represent system state at time
  *                   of faulting.
- * @param _exc       Link register to the next point. Unused.
+ * @param _exc       EXC_RETURN value in the link register at the fault.
  */
 void _ReportHardFault(uint32_t *stackFrame, uint32_t _exc);
@@ -25,6 +25,8 @@
 /** Device imports. */
 #include <inc/RegDefs.h>
 #include <lib/FaultHandler/FaultHandler.h>
+#include <lib/Check/Check.h>
+#include <lib/Profile/Profile.h>
 #include <lib/GPIO/GPIO.h>
 
 
@@ -308,8 +310,11 @@ GPIOPin_t GPIOIntInit(GPIOConfig_t config, GPIOInterruptConfig_t intConfig) {
  * @param pin GPIOPin_t base to handle from.
  */
 static void GPIOGeneric_Handler(GPIOPin_t pin) {
-    /* Initialization asserts. */
-    assert(pin < PIN_COUNT);
+    /* Debug checks. Compiled out with NDEBUG; the pin is a constant here. */
+    if (!CHECK_DEBUG(CHECK_GPIO, pin < PIN_COUNT)) return;
+
+    /* GPIO has no reference count to measure latency against. */
+    PROFILE_BEGIN(sample, 0);
 
     /** 1. Generate the port offset to find the correct addresses.
      *    There are a couple components in this line:
@@ -378,6 +383,10 @@ static void GPIOGeneric_Handler(GPIOPin_t pin) {
             }
         }
     }
+
+    /* 3. An edge that arrived while the tasks ran is an overrun. */
+    PROFILE_END(sample, PROFILE_SLOT_GPIO(pin >> 3),
+        GET_REG(GPIO_PORT_BASE + portOffset + GPIO_MIS_OFFSET) != 0);
 }
 
 void GPIOPortA_Handler(void) { GPIOGeneric_Handler(PIN_A0); }
@@ -394,8 +403,8 @@ void GPIOPortF_Handler(void) { GPIOGeneric_Handler(PIN_F0); }
 
 #ifdef __FAST__
 void GPIOSetBit(GPIOPin_t pin, bool val) {
-    /* Initialization asserts. */
-    assert(pin < PIN_COUNT);
+    /* Debug checks. Compiled out with NDEBUG, as this is a hot path. */
+    if (!CHECK_DEBUG(CHECK_GPIO, pin < PIN_COUNT)) return;
 
     switch (pin) {
         case PIN_A0:
@@ -548,13 +557,13 @@ void GPIOSetBit(GPIOPin_t pin, bool val) {
             GET_REG(0x40025200) = val << 7;
             break;
         default:
-            assert(0); // Failure condition - this passed the initial assert.
+            CHECK(CHECK_GPIO, pin < PIN_COUNT); // Only reached by a bad pin.
     }
 }
 
 bool GPIOGetBit(GPIOPin_t pin) {
-    /* Initialization asserts. */
-    assert(pin < PIN_COUNT);
+    /* Debug checks. Compiled out with NDEBUG, as this is a hot path. */
+    if (!CHECK_DEBUG(CHECK_GPIO, pin < PIN_COUNT)) return false;
 
     switch (pin) {
         case PIN_A0:
@@ -659,7 +668,7 @@ bool GPIOGetBit(GPIOPin_t pin) {
         case PIN_F7:
             return GET_REG(0x40025200);
         default:
-            assert(0); // Failure condition - this passed the initial assert.
+            CHECK(CHECK_GPIO, pin < PIN_COUNT); // Only reached by a bad pin.
             return false;
     }
 }
@@ -667,8 +676,8 @@ bool GPIOGetBit(GPIOPin_t pin) {
 #else
 
 void GPIOSetBit(GPIOPin_t pin, bool value) {
-    /* Initialization asserts. */
-    assert(pin < PIN_COUNT);
+    /* Debug checks. Compiled out with NDEBUG, as this is a hot path. */
+    if (!CHECK_DEBUG(CHECK_GPIO, pin < PIN_COUNT)) return;
 
     /* 1. Generate the port offset to find the correct addresses.
           There are a couple components in this line:
@@ -707,8 +716,8 @@ void GPIOSetBit(GPIOPin_t pin, bool value) {
 }
 
 bool GPIOGetBit(GPIOPin_t pin) {
-    /* Initialization asserts. */
-    assert(pin < PIN_COUNT);
+    /* Debug checks. Compiled out with NDEBUG, as this is a hot path. */
+    if (!CHECK_DEBUG(CHECK_GPIO, pin < PIN_COUNT)) return false;
 
     /** 1. Generate the port offset to find the correct addresses.
      *    There are a couple components in this line:
@@ -6,10 +6,30 @@
  * @date 2021-10-07
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support the TM4C as a slave
- * device. This device does not support interrupts. This device does not support
- * loopback mode, glitch filters, high speed mode, or simultaneous master/slave
- * mode.
+ * Interrupts. I2CMasterSubmit queues transactions that are run by the I2C
+ * interrupt as a state machine, one byte per interrupt. Each transaction may
+ * write, read, or write then read after a repeated start. I2CMasterSubmitBatch
+ * queues a group of transactions (i.e. one sweep over every sensor on the bus)
+ * that run back to back and report once, with the cycles taken by the sweep.
+ *
+ * Timing. The SCL period is derived from the system clock reported by
+ * PLLGetFrequency, rounded so the bus never runs faster than requested. In high
+ * speed mode, each transaction is preceded by the master code handshake.
+ *
+ * Errors. Blocking functions return an I2CStatus. Every wait on the master is
+ * bounded by a cycle budget, and a slave stretching SCL is bounded by the
+ * clock low timeout. A master that never finishes is recovered by clocking SCL
+ * as a GPIO until the slave releases SDA, then generating a stop.
+ *
+ * Slave Mode. I2CSlaveInit exposes a RAM register file to an external master.
+ * The first byte written after the slave address selects a register; further
+ * bytes written are stored from that register onward, and bytes read are
+ * served from it, all from the I2C interrupt. A write task is notified of the
+ * registers changed once the master issues a stop.
+ *
+ * Unsupported Features. This device does not support loopback mode or
+ * simultaneous master/slave mode on a single module. The TM4C123 I2C modules
+ * have no uDMA channels, so the register file is served by interrupt.
  */
 
 /** General Imports. */
@@ -20,6 +40,8 @@
 #include <inc/RegDefs.h>
 #include <lib/I2C/I2C.h>
 #include <lib/GPIO/GPIO.h>
+#include <lib/PLL/PLL.h>
+#include <lib/Common/Common.h>
 
 
 static GPIOPin_t I2CPinMapping[4][2] = {
@@ -30,29 +52,132 @@ static GPIOPin_t I2CPinMapping[4][2] = {
     {PIN_D0, PIN_D1},
 };
 
+/**
+ * @brief I2CSpeedMapping is the highest SCL frequency of each speed. High speed
+ *        mode is specified up to 3.4 MHz; this gives 3.33 MHz at 80 MHz.
+ */
 static uint32_t I2CSpeedMapping[4] = {
     100000,
     400000,
     1000000,
-    3330000
+    3400000
 };
 
-I2C_t I2CInit(I2CConfig_t config) {
-    /* Initialization asserts. */
-    assert(config.module <= I2C_MODULE_3);
-    assert(config.speed <= I2C_SPEED_3_33_MBPS);
+uint32_t StartCritical(void);    // Defined in startup.s
+void EndCritical(uint32_t sr);   // Defined in startup.s
+
+/**
+ * @brief This field is either 0, 1, 2, 3, specifying the byte that the
+ *        interrupt of priority X should be set to.
+ */
+enum InterruptPriorityIdx {INTA, INTB, INTC, INTD};
+
+/** @brief I2CMasterState is the phase of the running transaction. */
+enum I2CMasterState {
+    I2C_STATE_IDLE,
+    I2C_STATE_MASTER_CODE,
+    I2C_STATE_WRITE,
+    I2C_STATE_READ,
+    I2C_STATE_STOP
+};
+
+/** @brief I2CInterruptSettings is a set of I2C configurations. */
+static struct I2CInterruptSettings {
+    /** @brief Priority index of the I2C. */
+    enum InterruptPriorityIdx priorityIdx;
+
+    /** @brief Address of the relevant priority register. */
+    volatile uint32_t * NVIC_PRI_ADDR;
+
+    /** @brief Address of the relevant set enable register. */
+    volatile uint32_t * NVIC_EN_ADDR;
+
+    /** @brief Relevant IRQ number of the interrupt. */
+    uint32_t IRQ;
+
+    /** @brief Transactions waiting for the bus. */
+    I2CTransaction_t * queue[I2C_QUEUE_SIZE];
+
+    /** @brief Index of the oldest waiting transaction. */
+    uint8_t queueHead;
+
+    /** @brief Number of waiting transactions. */
+    volatile uint8_t queueCount;
+
+    /** @brief The transaction that owns the bus. */
+    I2CTransaction_t * current;
+
+    /** @brief Phase of the running transaction. */
+    volatile enum I2CMasterState state;
+
+    /** @brief Index of the next byte of the current phase. */
+    uint8_t index;
 
+    /** @brief The failure reported once a stop issued after an error ends. */
+    enum I2CStatus error;
+
+    /** @brief The maximum number of cycles to wait on the master. */
+    uint32_t timeout;
+
+    /** @brief The maximum time to wait on the master, in microseconds. */
+    uint32_t timeoutMicrosec;
+
+    /** @brief Whether the module is an initialized master. */
+    bool isMaster;
+
+    /** @brief The bus speed of the master. */
+    enum I2CSpeed speed;
+
+    /** @brief Whether transactions start with the high speed handshake. */
+    bool isHighSpeed;
+
+    /** @brief The high speed master code, 0b00001XXX. */
+    uint8_t masterCode;
+
+    /** @brief Whether the module is a slave serving a register file. */
+    bool isSlave;
+
+    /** @brief The register file served as a slave. */
+    volatile uint8_t * registers;
+
+    /** @brief The number of registers in the register file. */
+    uint16_t numRegisters;
+
+    /** @brief The register accessed by the next byte. */
+    uint8_t pointer;
+
+    /** @brief The first register written by the current write. */
+    uint8_t writeStart;
+
+    /** @brief The number of registers written by the current write. */
+    uint16_t numWritten;
+
+    /** @brief User function associated with a completed write. */
+    void (*writeTask)(uint8_t firstRegister, uint16_t numRegisters);
+} I2CInterruptSettings[4] = {
+    {INTA, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI2_OFFSET),  (uint32_t *)(PERIPHERALS_BASE + NVIC_EN0_OFFSET), 8},     /* I2C0. */
+    {INTB, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI9_OFFSET),  (uint32_t *)(PERIPHERALS_BASE + NVIC_EN1_OFFSET), 37-32}, /* I2C1. */
+    {INTA, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI17_OFFSET), (uint32_t *)(PERIPHERALS_BASE + NVIC_EN2_OFFSET), 68-64}, /* I2C2. */
+    {INTB, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI17_OFFSET), (uint32_t *)(PERIPHERALS_BASE + NVIC_EN2_OFFSET), 69-64}, /* I2C3. */
+};
+
+/**
+ * @brief I2CEnableModule activates the clock and pins of an I2C module.
+ *
+ * @param module The I2C module to enable.
+ */
+static void I2CEnableModule(enum I2CModule module) {
     /* 1. Activate the clock for RCGCI2C. */
     GET_REG(SYSCTL_BASE + SYSCTL_RCGCI2C_OFFSET) |=
-        1 << config.module;
+        1 << module;
 
     /* 2. Stall until clock is ready. */
     while ((GET_REG(SYSCTL_BASE + SYSCTL_PRI2C_OFFSET) &
-        (1 << config.module)) == 0) {};
+        (1 << module)) == 0) {};
 
     /* 3. Enable SCL and SDA GPIO pins. */
     GPIOConfig_t sclPin = {
-        I2CPinMapping[config.module][0],
+        I2CPinMapping[module][0],
         GPIO_TRI_STATE, /* Do NOT configure SCL as open drain. */
         true,
         3,
@@ -62,7 +187,7 @@ I2C_t I2CInit(I2CConfig_t config) {
     };
     GPIOInit(sclPin);
     GPIOConfig_t sdaPin = {
-        I2CPinMapping[config.module][1],
+        I2CPinMapping[module][1],
         GPIO_OPEN_DRAIN,
         true,
         3,
@@ -71,49 +196,424 @@ I2C_t I2CInit(I2CConfig_t config) {
         false
     };
     GPIOInit(sdaPin);
+}
+
+/**
+ * @brief I2CEnableInterrupt sets the priority of and enables the interrupt of
+ *        an I2C module in the NVIC.
+ *
+ * @param module The I2C module to enable.
+ * @param priority Interrupt priority. From 0 - 7.
+ */
+static void I2CEnableInterrupt(enum I2CModule module, uint8_t priority) {
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+    uint32_t mask = 0xFFFFFFFF;
+    uint32_t intVal = priority << 5;
+    mask &= ~(0xFF << (settings->priorityIdx * 8));
+    intVal = intVal << (settings->priorityIdx * 8);
+    (*settings->NVIC_PRI_ADDR) = ((*settings->NVIC_PRI_ADDR)&mask)|intVal;
+    (*settings->NVIC_EN_ADDR) = 1 << settings->IRQ;
+}
+
+/**
+ * @brief I2CMasterWait waits for the master to finish its current operation.
+ *        The cycle counter is only read if the master is still busy on the
+ *        first check.
+ *
+ * @param moduleBase Base address of the I2C module.
+ * @param timeout The maximum number of cycles to wait.
+ * @return False if the master is still busy after the timeout.
+ */
+static inline bool I2CMasterWait(uint32_t moduleBase, uint32_t timeout) {
+    if (!(GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1)) return true;
+
+    uint32_t start = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {
+        if ((uint32_t)(GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET) - start) > timeout) return false;
+    }
+    return true;
+}
+
+/** @brief Whether the I2C clock tasks have been registered with the PLL. */
+static bool isI2CClockTaskAdded = false;
+
+/**
+ * @brief I2CSetClock sets the SCL timer period and wait timeout of a master
+ *        from the system clock.
+ *
+ * @param module The I2C module (0 - 3).
+ * @param frequency The system clock frequency, in Hz.
+ */
+static void I2CSetClock(uint8_t module, uint32_t frequency) {
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+
+    /* High speed mode uses the high speed timer period. */
+    uint32_t tpr = I2CGetTimerPeriod(frequency, settings->speed);
+    if (settings->isHighSpeed) tpr |= 0x80;
+    GET_REG(moduleBase + I2C_MTPR_OFFSET) = tpr;
+
+    settings->timeout = (frequency / 1000000) * settings->timeoutMicrosec;
+}
+
+/**
+ * @brief I2CPrepareClock lets the queued transactions of every initialized
+ *        master finish before the system clock changes.
+ *
+ * @param frequency The upcoming system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void I2CPrepareClock(uint32_t frequency, uint32_t * args) {
+    uint8_t module;
+    for (module = 0; module < 4; ++module) {
+        struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+        if (!settings->isMaster) continue;
+
+        while (settings->state != I2C_STATE_IDLE || settings->queueCount > 0) {}
+        I2CMasterWait(module * 0x1000 + I2C0_BASE, settings->timeout);
+    }
+}
+
+/**
+ * @brief I2CUpdateClock retimes every initialized master when the system
+ *        clock changes.
+ *
+ * @param frequency The new system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void I2CUpdateClock(uint32_t frequency, uint32_t * args) {
+    uint8_t module;
+    for (module = 0; module < 4; ++module) {
+        if (I2CInterruptSettings[module].isMaster) I2CSetClock(module, frequency);
+    }
+}
+
+I2C_t I2CInit(I2CConfig_t config) {
+    /* Initialization asserts. */
+    assert(config.module <= I2C_MODULE_3);
+    assert(config.speed <= I2C_SPEED_3_33_MBPS);
+    assert(config.priority <= 7);
+    assert(config.masterCode <= 7);
+    assert(config.glitchFilter <= I2C_GLITCH_FILTER_31_CLOCKS);
+
+    /* 1. - 3. Activate the clock and the SCL and SDA GPIO pins. */
+    I2CEnableModule(config.module);
 
     uint32_t moduleBase = config.module * 0x1000 + I2C0_BASE;
 
     /* 4. Set transmission mode. */
-    /* Glitch filter is disabled, master mode enabled, and loopback mode is on. */
-    GET_REG(moduleBase + I2C_MCR_OFFSET) = 0x10;
+    /* Master mode enabled and loopback mode is off. The glitch filter width is
+       set before the filter is enabled. */
+    GET_REG(moduleBase + I2C_MCR2_OFFSET) = config.glitchFilter << 4;
+    GET_REG(moduleBase + I2C_MCR_OFFSET) =
+        0x10 | ((config.glitchFilter != I2C_GLITCH_FILTER_OFF) ? 0x40 : 0x0);
 
     /* If in master mode. */
-    /* 5. Select clock speed. */
-    /* Default 80 MHz. */
-    uint32_t tpr = 0;
-    if (config.speed == I2C_SPEED_3_33_MBPS) {
-        #define SCL_LP 6
-        #define SCL_HP 4
-        tpr = 80000000 / (2 * (SCL_LP + SCL_HP) * I2CSpeedMapping[config.speed]) - 1;
-        #undef SCL_LP
-        #undef SCL_HP
-    } else {
-        #define SCL_LP 2
-        #define SCL_HP 1
-        tpr = 80000000 / (2 * (SCL_LP + SCL_HP) * I2CSpeedMapping[config.speed]) - 1;
-        #undef SCL_LP
-        #undef SCL_HP
+    /* 5. Select clock speed and timeout from the current system clock, and
+          keep them when the clock changes. */
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[config.module];
+    settings->speed = config.speed;
+    settings->isHighSpeed = config.speed == I2C_SPEED_3_33_MBPS;
+    settings->timeoutMicrosec = (config.timeout == 0) ? 10000 : config.timeout;
+    I2CSetClock(config.module, PLLGetFrequency());
+    if (!isI2CClockTaskAdded) {
+        isI2CClockTaskAdded = PLLAddClockPrepareTask(I2CPrepareClock, NULL) &&
+            PLLAddClockTask(I2CUpdateClock, NULL);
     }
-    GET_REG(moduleBase + I2C_MTPR_OFFSET) = tpr;
+
+    /* 6. Enable the cycle counter used to time batches. */
+    CommonEnableCycleCounter();
+
+    /* 7. Set the clock low timeout. A slave holding SCL low past the timeout
+          ends the transfer with I2C_ERR_CLOCK_TIMEOUT. */
+    GET_REG(moduleBase + I2C_MCLKOCNT_OFFSET) =
+        (config.clockTimeout == 0) ? 0xFF : config.clockTimeout;
+
+    /* 8. Set up the interrupt for queued transactions. The master interrupt
+          is only unmasked while a transaction runs. */
+    settings->queueHead = 0;
+    settings->queueCount = 0;
+    settings->current = NULL;
+    settings->state = I2C_STATE_IDLE;
+    settings->masterCode = 0x08 | config.masterCode;
+    settings->isSlave = false;
+    settings->isMaster = true;
+    GET_REG(moduleBase + I2C_MIMR_OFFSET) = 0x0;
+    I2CEnableInterrupt(config.module, config.priority);
 
     I2C_t i2c = {
         .module=config.module
     };
 
-    /* If in slave mode. */
-    // GET_REG(moduleBase + I2C_SOAR_OFFSET) = 0x3C;
-    // GET_REG(moduleBase + I2C_SCSR_OFFSET) = 1;
+    return i2c;
+}
+
+I2C_t I2CSlaveInit(I2CSlaveConfig_t config) {
+    /* Initialization asserts. */
+    assert(config.module <= I2C_MODULE_3);
+    assert(config.slaveAddress <= 0x7F);
+    assert(config.registers != NULL);
+    assert(0 < config.numRegisters && config.numRegisters <= 256);
+    assert(config.priority <= 7);
+    assert(config.glitchFilter <= I2C_GLITCH_FILTER_31_CLOCKS);
+
+    /* 1. - 3. Activate the clock and the SCL and SDA GPIO pins. */
+    I2CEnableModule(config.module);
+
+    uint32_t moduleBase = config.module * 0x1000 + I2C0_BASE;
+
+    /* 4. Set transmission mode. */
+    /* Slave mode enabled and loopback mode is off. */
+    GET_REG(moduleBase + I2C_MCR2_OFFSET) = config.glitchFilter << 4;
+    GET_REG(moduleBase + I2C_MCR_OFFSET) =
+        0x20 | ((config.glitchFilter != I2C_GLITCH_FILTER_OFF) ? 0x40 : 0x0);
+
+    /* 5. Set up the register file. */
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[config.module];
+    settings->isSlave = true;
+    settings->isMaster = false;
+    settings->registers = config.registers;
+    settings->numRegisters = config.numRegisters;
+    settings->pointer = 0;
+    settings->numWritten = 0;
+    settings->writeTask = config.writeTask;
+
+    /* 6. Write own slave address to I2CSOAR. */
+    GET_REG(moduleBase + I2C_SOAR_OFFSET) = config.slaveAddress;
+
+    /* 7. Interrupt on data and stop conditions. */
+    GET_REG(moduleBase + I2C_SICR_OFFSET) = 0x7;
+    GET_REG(moduleBase + I2C_SIMR_OFFSET) = 0x5;
+    I2CEnableInterrupt(config.module, config.priority);
+
+    /* 8. Write to device activate bit I2CSCSR. */
+    GET_REG(moduleBase + I2C_SCSR_OFFSET) = 0x1;
+
+    I2C_t i2c = {
+        .module=config.module
+    };
 
     return i2c;
 }
 
-/* Hidden test methods. Remove eventually. */
-bool I2CTx1(I2C_t i2c, uint8_t slaveAddress, uint8_t byte) {
+uint8_t I2CGetTimerPeriod(uint32_t systemClock, enum I2CSpeed speed) {
+    /* Initialization asserts. */
+    assert(speed <= I2C_SPEED_3_33_MBPS);
+
+    /* SCL_PERIOD = 2 * (1 + TPR) * (SCL_LP + SCL_HP) * CLK_PRD. SCL_LP and
+       SCL_HP are fixed at 6 and 4 in standard, fast, and fast plus mode, and
+       at 2 and 1 in high speed mode. See p. 1000 of the TM4C Datasheet. */
+    uint32_t sclClocks = (speed == I2C_SPEED_3_33_MBPS) ? 3 : 10;
+    uint32_t divisor = 2 * sclClocks * I2CSpeedMapping[speed];
+
+    /* Round the period up so the bus never runs faster than requested. */
+    uint32_t tpr = (systemClock + divisor - 1) / divisor;
+    if (tpr > 0) --tpr;
+    if (tpr > 0x7F) tpr = 0x7F;
+    return tpr;
+}
+
+/**
+ * @brief I2CDelayCycles busy waits for a number of system clock cycles.
+ *
+ * @param cycles The number of cycles to wait.
+ */
+static void I2CDelayCycles(uint32_t cycles) {
+    uint32_t start = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+    while ((uint32_t)(GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET) - start) < cycles) {}
+}
+
+/**
+ * @brief I2CMasterGetStatus decodes the result of the last master operation.
+ *
+ * @param mcs The value read from I2CMCS.
+ * @return The status of the operation.
+ */
+static enum I2CStatus I2CMasterGetStatus(uint32_t mcs) {
+    if (mcs & 0x80) return I2C_ERR_CLOCK_TIMEOUT;
+    if (!(mcs & 0x02)) return I2C_OK;
+    if (mcs & 0x10) return I2C_ERR_ARBITRATION_LOST;
+    if (mcs & 0x04) return I2C_ERR_ADDRESS_NACK;
+    return I2C_ERR_DATA_NACK;
+}
+
+/**
+ * @brief I2CMasterRecover frees a bus held by a slave stuck mid transfer. SCL
+ *        is clocked as a GPIO up to nine times until the slave releases SDA,
+ *        then a stop is generated and the pins are returned to the module.
+ *
+ * @param module The I2C module (0 - 3).
+ * @return I2C_OK if SDA was released, I2C_ERR_BUS_STUCK otherwise.
+ */
+static enum I2CStatus I2CMasterRecover(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    GPIOPin_t scl = I2CPinMapping[module][0];
+    GPIOPin_t sda = I2CPinMapping[module][1];
+
+    /* Clock at 100 kHz or slower, which every slave supports. */
+    uint32_t halfPeriod = PLLGetFrequency() / 200000 + 1;
+
+    /* 1. Disable the master and take SCL as an open drain output and SDA as an
+          input. Both idle high through the bus pull ups. */
+    uint32_t mcr = GET_REG(moduleBase + I2C_MCR_OFFSET);
+    GET_REG(moduleBase + I2C_MCR_OFFSET) = mcr & ~0x10;
+    GPIOConfig_t sclPin = {
+        scl,
+        GPIO_OPEN_DRAIN,
+        true,
+        0,
+        false,
+        GPIO_DRIVE_2MA,
+        false
+    };
+    GPIOConfig_t sdaPin = {
+        sda,
+        GPIO_TRI_STATE,
+        false,
+        0,
+        false,
+        GPIO_DRIVE_2MA,
+        false
+    };
+    GPIOSetBit(scl, true);
+    GPIOInit(sclPin);
+    GPIOInit(sdaPin);
+    I2CDelayCycles(halfPeriod);
+
+    /* 2. Clock SCL until the slave releases SDA, at most nine times. */
+    uint8_t i;
+    for (i = 0; i < 9 && !GPIOGetBit(sda); ++i) {
+        GPIOSetBit(scl, false);
+        I2CDelayCycles(halfPeriod);
+        GPIOSetBit(scl, true);
+        I2CDelayCycles(halfPeriod);
+    }
+    bool isReleased = GPIOGetBit(sda);
+
+    /* 3. Generate a stop: SDA rises while SCL is high. */
+    GPIOSetBit(scl, false);
+    I2CDelayCycles(halfPeriod);
+    sdaPin.pull = GPIO_OPEN_DRAIN;
+    sdaPin.isOutput = true;
+    GPIOSetBit(sda, false);
+    GPIOInit(sdaPin);
+    I2CDelayCycles(halfPeriod);
+    GPIOSetBit(scl, true);
+    I2CDelayCycles(halfPeriod);
+    GPIOSetBit(sda, true);
+    I2CDelayCycles(halfPeriod);
+
+    /* 4. Return the pins and the master to the module. */
+    I2CEnableModule(module);
+    GET_REG(moduleBase + I2C_MCR_OFFSET) = mcr;
+
+    return isReleased ? I2C_OK : I2C_ERR_BUS_STUCK;
+}
+
+enum I2CStatus I2CBusRecover(I2C_t i2c) {
+    /* Initialization asserts. */
+    assert(i2c.module <= I2C_MODULE_3);
+
+    return I2CMasterRecover(i2c.module);
+}
+
+/**
+ * @brief I2CMasterReady waits for the master to finish any previous operation.
+ *        A master that never finishes is recovered.
+ *
+ * @param module The I2C module (0 - 3).
+ * @return I2C_OK, or I2C_ERR_TIMEOUT if the bus had to be recovered.
+ */
+static inline enum I2CStatus I2CMasterReady(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    if (I2CMasterWait(moduleBase, I2CInterruptSettings[module].timeout)) return I2C_OK;
+
+    I2CMasterRecover(module);
+    return I2C_ERR_TIMEOUT;
+}
+
+/**
+ * @brief I2CMasterRun issues a master command and waits for it to complete.
+ *        Errors in the middle of a transfer release the bus with a stop.
+ *
+ * @param module The I2C module (0 - 3).
+ * @param command The value to write to I2CMCS.
+ * @return The status of the operation.
+ */
+static enum I2CStatus I2CMasterRun(uint8_t module, uint32_t command) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    uint32_t timeout = I2CInterruptSettings[module].timeout;
+
+    /* 1. Generate the command and wait for transmission completion. */
+    GET_REG(moduleBase + I2C_MCS_OFFSET) = command;
+    if (!I2CMasterWait(moduleBase, timeout)) {
+        I2CMasterRecover(module);
+        return I2C_ERR_TIMEOUT;
+    }
+
+    /* 2. Check for error. A lost arbitration releases the bus on its own;
+          otherwise generate a stop bit if the command did not. */
+    enum I2CStatus status = I2CMasterGetStatus(GET_REG(moduleBase + I2C_MCS_OFFSET));
+    if (status != I2C_OK && status != I2C_ERR_ARBITRATION_LOST && !(command & 0x4)) {
+        GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0100;
+        if (!I2CMasterWait(moduleBase, timeout)) {
+            I2CMasterRecover(module);
+            return I2C_ERR_TIMEOUT;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief I2CMasterSendMasterCode sends the high speed master code. The code is
+ *        not acknowledged by any slave; the following start is then a repeated
+ *        start in high speed mode.
+ *
+ * @param module The I2C module (0 - 3).
+ * @return I2C_OK, or the reason the handshake failed.
+ */
+static enum I2CStatus I2CMasterSendMasterCode(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+
+    /* 1. Write the master code to I2CMSA. */
+    GET_REG(moduleBase + I2C_MSA_OFFSET) = I2CInterruptSettings[module].masterCode;
+
+    /* 2. Generate high speed, start, run bits. */
+    GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b10011;
+
+    /* 3. Wait for transmission completion. */
+    if (!I2CMasterWait(moduleBase, I2CInterruptSettings[module].timeout)) {
+        I2CMasterRecover(module);
+        return I2C_ERR_TIMEOUT;
+    }
+
+    /* 4. A missing acknowledge is expected. */
+    enum I2CStatus status = I2CMasterGetStatus(GET_REG(moduleBase + I2C_MCS_OFFSET));
+    if (status == I2C_ERR_ADDRESS_NACK || status == I2C_ERR_DATA_NACK) return I2C_OK;
+    return status;
+}
+
+/**
+ * @brief I2CMasterBegin waits for the master to be ready and, in high speed
+ *        mode, sends the master code.
+ *
+ * @param module The I2C module (0 - 3).
+ * @return I2C_OK, or the reason the master is not ready.
+ */
+static inline enum I2CStatus I2CMasterBegin(uint8_t module) {
+    enum I2CStatus status = I2CMasterReady(module);
+    if (status == I2C_OK && I2CInterruptSettings[module].isHighSpeed) {
+        status = I2CMasterSendMasterCode(module);
+    }
+    return status;
+}
+
+enum I2CStatus I2CMasterTransmitByte(I2C_t i2c, uint8_t slaveAddress, uint8_t byte) {
     uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
 
     /* 1. Wait for I2C ready. */
-    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
+    enum I2CStatus status = I2CMasterBegin(i2c.module);
+    if (status != I2C_OK) return status;
 
     /* 2. Write slave address to I2CMSA in transmit mode. */
     GET_REG(moduleBase + I2C_MSA_OFFSET) = (slaveAddress << 1) & 0xFE;
@@ -121,184 +621,493 @@ bool I2CTx1(I2C_t i2c, uint8_t slaveAddress, uint8_t byte) {
     /* 3. Write data to I2CMDR. */
     GET_REG(moduleBase + I2C_MDR_OFFSET) = byte;
 
-    /* 4. Generate stop, start, run bits. */
-    GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0111;
-
-    /* 5. Wait for I2C ready. */
-    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
-
-    /* 6. Return result. False is failure. */ 
-    return !(GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x0E);
+    /* 4. Generate stop, start, run bits and wait for transmission completion. */
+    return I2CMasterRun(i2c.module, 0b0111);
 }
 
-bool I2CRx1(I2C_t i2c, uint8_t slaveAddress, uint8_t * byte) {
+enum I2CStatus I2CMasterReceiveByte(I2C_t i2c, uint8_t slaveAddress, uint8_t * byte) {
     uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
 
     /* 1. Wait for I2C ready. */
-    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
+    enum I2CStatus status = I2CMasterBegin(i2c.module);
+    if (status != I2C_OK) return status;
 
     /* 2. Write slave address to I2CMSA in receive mode. */
     GET_REG(moduleBase + I2C_MSA_OFFSET) = ((slaveAddress << 1) & 0xFE) | 0x1;
-    
-    /* 3. Generate stop, start, run bits. */
-    GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0111;
 
-    /* 4. Wait for I2C ready. */
-    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
+    /* 3. Generate stop, start, run bits. The byte is not acknowledged. */
+    status = I2CMasterRun(i2c.module, 0b0111);
 
-    /* 3. Read data from I2CMDR, regardless if correct or not. */
+    /* 4. Read data from I2CMDR, regardless if correct or not. */
     *byte = GET_REG(moduleBase + I2C_MDR_OFFSET) & 0xFF;
 
-    /* 6. Return result. False is failure. */ 
-    return !(GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x06);
+    return status;
 }
 
-bool I2CMasterTransmit(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t numBytes) {
-    uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
-
-    /* 1. Wait for I2C ready. */
-    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
-
-    /* 2. Write slave address to I2CMSA in transmit mode. */
-    GET_REG(moduleBase + I2C_MSA_OFFSET) = (slaveAddress << 1) & 0xFE;
+/**
+ * @brief I2CMasterWriteBytes writes the bytes of a transmit phase, holding the
+ *        bus after the last byte unless a stop is requested.
+ *
+ * @param module The I2C module (0 - 3).
+ * @param bytes Pointer to the data array to send.
+ * @param numBytes The number of bytes to send. At least one.
+ * @param isStop Whether the last byte ends with a stop.
+ * @return The status of the phase.
+ */
+static enum I2CStatus I2CMasterWriteBytes(uint8_t module, const uint8_t * bytes, uint8_t numBytes, bool isStop) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
 
     /* For each byte of data to send. */
     uint8_t i;
     for (i = 0; i < numBytes; ++i) {
-        /* 3. Write data to I2CMDR. */
+        /* 1. Write data to I2CMDR. */
         GET_REG(moduleBase + I2C_MDR_OFFSET) = bytes[i];
 
+        /* 2. Generate start, run bits for the first byte, else run bit. The
+              last byte also generates the stop bit, if requested. */
+        uint32_t command = (i == 0) ? 0b0011 : 0b0001;
+        if (isStop && i == numBytes - 1) command |= 0b0100;
+
+        /* 3. Wait for transmission completion and check for error. */
+        enum I2CStatus status = I2CMasterRun(module, command);
+        if (status != I2C_OK) return status;
+    }
+
+    return I2C_OK;
+}
+
+/**
+ * @brief I2CMasterReadBytes reads the bytes of a receive phase, starting with
+ *        a start or repeated start and ending with a stop.
+ *
+ * @param module The I2C module (0 - 3).
+ * @param bytes Pointer to the data array to fill.
+ * @param numBytes The number of bytes to receive. At least one.
+ * @return The status of the phase.
+ */
+static enum I2CStatus I2CMasterReadBytes(uint8_t module, uint8_t * bytes, uint8_t numBytes) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+
+    /* For each byte of data to receive. */
+    uint8_t i;
+    for (i = 0; i < numBytes; ++i) {
+        uint32_t command;
         if (i == 0) {
-            /* First byte. */
-            if (numBytes == 1) {
-                /* Special case of a single byte. */
-                /* 4a. Generate stop, start, run bits. */
-                GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0111;
-            } else {
-                /* 4a. Generate start, run bits. */
-                GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0011;
-            }
+            /* 1a. Generate ack, start, run bits. A single byte is not
+                   acknowledged and ends with a stop. */
+            command = (numBytes == 1) ? 0b0111 : 0b1011;
         } else if (i == numBytes - 1) {
-            /* Nth byte. */
-            /* 4b. Generate stop, run bits. */
-            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0101;
+            /* 1b. Generate stop, run bits. */
+            command = 0b0101;
         } else {
-            /* Kth byte. */
-            /* 4c. Generate run bit. */
-            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0001;
+            /* 1c. Generate ack, run bits. */
+            command = 0b1001;
         }
 
-        /* 5. Wait for transmission completion. */
-        while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
+        /* 2. Wait for transmission completion. */
+        enum I2CStatus status = I2CMasterRun(module, command);
 
-        /* 6. Check for error. */
-        bool error = GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x0E;
-        if (error) {
-            /* Generate stop bit. */
-            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0100;
-            while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
-            return false;
-        }
+        /* 3. Read data from I2CMDR, regardless if correct or not. */
+        bytes[i] = GET_REG(moduleBase + I2C_MDR_OFFSET) & 0xFF;
+
+        /* 4. Check for error. */
+        if (status != I2C_OK) return status;
     }
 
-    return true;
+    return I2C_OK;
 }
 
-bool I2CMasterReceive(I2C_t i2c, uint8_t slaveAddress, uint8_t bytes[], uint8_t numBytes) {
+enum I2CStatus I2CMasterTransmit(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t numBytes) {
     uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
 
     /* 1. Wait for I2C ready. */
-    while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
+    enum I2CStatus status = I2CMasterBegin(i2c.module);
+    if (status != I2C_OK) return status;
+
+    /* 2. Write slave address to I2CMSA in transmit mode. */
+    GET_REG(moduleBase + I2C_MSA_OFFSET) = (slaveAddress << 1) & 0xFE;
+
+    /* 3. Send each byte, ending with a stop. */
+    return I2CMasterWriteBytes(i2c.module, bytes, numBytes, true);
+}
+
+enum I2CStatus I2CMasterReceive(I2C_t i2c, uint8_t slaveAddress, uint8_t bytes[], uint8_t numBytes) {
+    uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
+
+    /* 1. Wait for I2C ready. */
+    enum I2CStatus status = I2CMasterBegin(i2c.module);
+    if (status != I2C_OK) return status;
 
     /* 2. Write slave address to I2CMSA in receive mode. */
     GET_REG(moduleBase + I2C_MSA_OFFSET) = ((slaveAddress << 1) & 0xFE) | 0x1;
 
-    /* For each byte of data to receive. */
-    uint8_t i;
-    for (i = 0; i < numBytes; ++i) {
-        if (i == 0) {
-            /* First byte. */
-            if (numBytes == 1) {
-                /* Special case of a single byte. */
-                /* 3a. Generate stop, start, run bits. */
-                GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0111;
-            } else {
-                /* 3a. Generate ack, start, run bits. */
-                GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b1011;
-            }
-        } else if (i == numBytes - 1) {
-            /* Nth byte. */
-            /* 3b. Generate stop, run bit. */
-            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0101;
+    /* 3. Receive each byte, ending with a stop. */
+    return I2CMasterReadBytes(i2c.module, bytes, numBytes);
+}
+
+enum I2CStatus I2CMasterWriteRead(I2C_t i2c, uint8_t slaveAddress, const uint8_t * txBytes, uint8_t numTx, uint8_t * rxBytes, uint8_t numRx) {
+    /* Without both phases, this is a plain transmit or receive. */
+    if (numRx == 0) return I2CMasterTransmit(i2c, slaveAddress, (uint8_t *)txBytes, numTx);
+    if (numTx == 0) return I2CMasterReceive(i2c, slaveAddress, rxBytes, numRx);
+
+    uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
+
+    /* 1. Wait for I2C ready. */
+    enum I2CStatus status = I2CMasterBegin(i2c.module);
+    if (status != I2C_OK) return status;
+
+    /* 2. Write slave address to I2CMSA in transmit mode. */
+    GET_REG(moduleBase + I2C_MSA_OFFSET) = (slaveAddress << 1) & 0xFE;
+
+    /* 3. Send each byte. The bus is held without a stop. */
+    status = I2CMasterWriteBytes(i2c.module, txBytes, numTx, false);
+    if (status != I2C_OK) return status;
+
+    /* 4. Write slave address to I2CMSA in receive mode. */
+    GET_REG(moduleBase + I2C_MSA_OFFSET) = ((slaveAddress << 1) & 0xFE) | 0x1;
+
+    /* 5. Receive each byte after a repeated start, ending with a stop. */
+    return I2CMasterReadBytes(i2c.module, rxBytes, numRx);
+}
+
+/**
+ * @brief I2CMasterStartRead issues the address of the read phase of the
+ *        current transaction, with a start or repeated start.
+ *
+ * @param module The I2C module (0 - 3).
+ */
+static void I2CMasterStartRead(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+
+    settings->state = I2C_STATE_READ;
+    settings->index = 0;
+    GET_REG(moduleBase + I2C_MSA_OFFSET) = ((settings->current->slaveAddress << 1) & 0xFE) | 0x1;
+
+    /* A single byte read is not acknowledged and ends with a stop. */
+    GET_REG(moduleBase + I2C_MCS_OFFSET) =
+        settings->current->numRx == 1 ? 0b0111 : 0b1011;
+}
+
+/**
+ * @brief I2CMasterStartTransaction issues the first byte of the current
+ *        transaction.
+ *
+ * @param module The I2C module (0 - 3).
+ */
+static void I2CMasterStartTransaction(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+    I2CTransaction_t * transaction = settings->current;
+
+    /* Start with the write phase, if any. */
+    if (transaction->numTx > 0) {
+        settings->state = I2C_STATE_WRITE;
+        settings->index = 1;
+        GET_REG(moduleBase + I2C_MSA_OFFSET) = (transaction->slaveAddress << 1) & 0xFE;
+        GET_REG(moduleBase + I2C_MDR_OFFSET) = transaction->txBytes[0];
+
+        /* A single byte write with nothing to read ends with a stop. */
+        GET_REG(moduleBase + I2C_MCS_OFFSET) =
+            (transaction->numTx == 1 && transaction->numRx == 0) ? 0b0111 : 0b0011;
+    } else {
+        I2CMasterStartRead(module);
+    }
+}
+
+/**
+ * @brief I2CMasterStartNext starts the oldest waiting transaction, if the bus
+ *        is free. Called with interrupts disabled or from the I2C interrupt.
+ *
+ * @param module The I2C module (0 - 3).
+ */
+static void I2CMasterStartNext(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+    if (settings->state != I2C_STATE_IDLE || settings->queueCount == 0) return;
+
+    /* 1. Pop the oldest transaction. */
+    I2CTransaction_t * transaction = settings->queue[settings->queueHead];
+    settings->queueHead = (settings->queueHead + 1) % I2C_QUEUE_SIZE;
+    --settings->queueCount;
+    settings->current = transaction;
+    if (transaction->batch != NULL && transaction == transaction->batch->transactions) {
+        transaction->batch->startCycle = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+    }
+
+    /* 2. Interrupt once each byte completes, or on a clock low timeout. */
+    GET_REG(moduleBase + I2C_MICR_OFFSET) = 0x3;
+    GET_REG(moduleBase + I2C_MIMR_OFFSET) = 0x3;
+
+    /* 3. In high speed mode, send the master code first. */
+    if (settings->isHighSpeed) {
+        settings->state = I2C_STATE_MASTER_CODE;
+        GET_REG(moduleBase + I2C_MSA_OFFSET) = settings->masterCode;
+        GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b10011;
+    } else {
+        I2CMasterStartTransaction(module);
+    }
+}
+
+/**
+ * @brief I2CMasterFinish retires the current transaction, starts the next
+ *        one, and calls the completion function.
+ *
+ * @param module The I2C module (0 - 3).
+ * @param status The result of the transaction.
+ */
+static void I2CMasterFinish(uint8_t module, enum I2CStatus status) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+    I2CTransaction_t * transaction = settings->current;
+
+    GET_REG(moduleBase + I2C_MIMR_OFFSET) = 0x0;
+    settings->current = NULL;
+    settings->state = I2C_STATE_IDLE;
+
+    transaction->status = status;
+    transaction->isDone = true;
+
+    /* The batch completes with its last transaction. */
+    I2CBatch_t * batch = transaction->batch;
+    if (batch != NULL) {
+        if (status != I2C_OK) ++batch->numFailed;
+        if (--batch->numRemaining == 0) {
+            batch->cycles = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET) - batch->startCycle;
+            batch->isDone = true;
         } else {
-            /* Kth byte. */
-            /* 3c. Generate ack, run bits. */
-            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b1001;
+            batch = NULL;
         }
+    }
 
-        /* 4. Wait for transmission completion. */
-        while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
+    I2CMasterStartNext(module);
 
-        /* 5. Write data to I2CMDR, regardless if correct or not. */
-        bytes[i] = GET_REG(moduleBase + I2C_MDR_OFFSET) & 0xFF;
+    if (transaction->doneTask != NULL) {
+        transaction->doneTask(transaction->doneArgs);
+    }
+    if (batch != NULL && batch->doneTask != NULL) {
+        batch->doneTask(batch->doneArgs);
+    }
+}
 
-        /* 6. Check for error. */
-        bool error = GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x6;
-        if (error) {
-            /* Generate stop bit. */
-            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0100;
-            while (GET_REG(moduleBase + I2C_MCS_OFFSET) & 0x1) {}
-            return false;
+bool I2CMasterSubmit(I2C_t i2c, I2CTransaction_t * transaction) {
+    /* Initialization asserts. */
+    assert(i2c.module <= I2C_MODULE_3);
+    assert(transaction != NULL);
+    assert(transaction->numTx > 0 || transaction->numRx > 0);
+    assert(transaction->numTx == 0 || transaction->txBytes != NULL);
+    assert(transaction->numRx == 0 || transaction->rxBytes != NULL);
+
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[i2c.module];
+    bool isAccepted = false;
+
+    /* A rejected transaction may still be queued from an earlier submit, so
+       its outputs are only reset once there is room for it. */
+    uint32_t sr = StartCritical();
+    if (settings->queueCount < I2C_QUEUE_SIZE) {
+        transaction->isDone = false;
+        transaction->status = I2C_OK;
+        transaction->batch = NULL;
+        settings->queue[(settings->queueHead + settings->queueCount) % I2C_QUEUE_SIZE] = transaction;
+        ++settings->queueCount;
+        isAccepted = true;
+        I2CMasterStartNext(i2c.module);
+    }
+    EndCritical(sr);
+
+    return isAccepted;
+}
+
+bool I2CMasterSubmitBatch(I2C_t i2c, I2CBatch_t * batch) {
+    /* Initialization asserts. */
+    assert(i2c.module <= I2C_MODULE_3);
+    assert(batch != NULL && batch->transactions != NULL);
+    assert(0 < batch->numTransactions && batch->numTransactions <= I2C_QUEUE_SIZE);
+
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[i2c.module];
+    bool isAccepted = false;
+    uint8_t i;
+    for (i = 0; i < batch->numTransactions; ++i) {
+        I2CTransaction_t * transaction = &batch->transactions[i];
+        assert(transaction->numTx > 0 || transaction->numRx > 0);
+        assert(transaction->numTx == 0 || transaction->txBytes != NULL);
+        assert(transaction->numRx == 0 || transaction->rxBytes != NULL);
+    }
+
+    /* 1. Check for room for every transaction. A rejected batch may still be
+          running from an earlier submit, so nothing is touched until then. */
+    uint32_t sr = StartCritical();
+    if (settings->queueCount + batch->numTransactions <= I2C_QUEUE_SIZE) {
+        /* 2. Reset the outputs of the batch and its transactions. */
+        batch->isDone = false;
+        batch->numFailed = 0;
+        batch->cycles = 0;
+        batch->numRemaining = batch->numTransactions;
+        for (i = 0; i < batch->numTransactions; ++i) {
+            I2CTransaction_t * transaction = &batch->transactions[i];
+            transaction->isDone = false;
+            transaction->status = I2C_OK;
+            transaction->batch = batch;
         }
+
+        /* 3. Queue every transaction at once. */
+        for (i = 0; i < batch->numTransactions; ++i) {
+            settings->queue[(settings->queueHead + settings->queueCount) % I2C_QUEUE_SIZE] = &batch->transactions[i];
+            ++settings->queueCount;
+        }
+        isAccepted = true;
+        I2CMasterStartNext(i2c.module);
     }
+    EndCritical(sr);
 
-    return true;
+    return isAccepted;
+}
+
+bool I2CMasterIsBusy(I2C_t i2c) {
+    /* Initialization asserts. */
+    assert(i2c.module <= I2C_MODULE_3);
+
+    return I2CInterruptSettings[i2c.module].state != I2C_STATE_IDLE ||
+        I2CInterruptSettings[i2c.module].queueCount > 0;
 }
 
+/**
+ * @brief I2CSlave_Handler serves a single byte of the register file, or
+ *        reports a completed write.
+ *
+ * @param module The I2C module (0 - 3) that raised the interrupt.
+ */
+static void I2CSlave_Handler(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+
+    /* 1. Acknowledge the slave interrupts. */
+    uint32_t status = GET_REG(moduleBase + I2C_SMIS_OFFSET);
+    GET_REG(moduleBase + I2C_SICR_OFFSET) = status;
+
+    if (status & 0x1) {
+        uint32_t scsr = GET_REG(moduleBase + I2C_SCSR_OFFSET);
+        if (scsr & 0x1) {
+            /* 2a. The master wrote a byte. The first byte after the address
+                   selects the register. */
+            uint8_t data = GET_REG(moduleBase + I2C_SDR_OFFSET) & 0xFF;
+            if (scsr & 0x4) {
+                settings->pointer = data % settings->numRegisters;
+                settings->writeStart = settings->pointer;
+                settings->numWritten = 0;
+            } else {
+                settings->registers[settings->pointer] = data;
+                settings->pointer = (settings->pointer + 1) % settings->numRegisters;
+                ++settings->numWritten;
+            }
+        } else if (scsr & 0x2) {
+            /* 2b. The master requested a byte. */
+            GET_REG(moduleBase + I2C_SDR_OFFSET) = settings->registers[settings->pointer];
+            settings->pointer = (settings->pointer + 1) % settings->numRegisters;
+        }
+    }
+
+    /* 3. Notify the user of the registers written once the master stops. */
+    if (status & 0x4) {
+        if (settings->numWritten > 0 && settings->writeTask != NULL) {
+            uint16_t numRegisters = settings->numWritten > settings->numRegisters ?
+                settings->numRegisters : settings->numWritten;
+            settings->writeTask(settings->writeStart, numRegisters);
+        }
+        settings->numWritten = 0;
+    }
+}
 
 /**
- * I2CSlaveProcess manages a single byte request across the I2C line.
- * 
- * @param i2c The I2C module to talk with.
- * @param slaveAddress I2C address of the self.
- * @param readTask  Pointer to a function to call when reading the byte from the
- *                  I2C line.
- * @param writeTask Pointer to a function to call to generate the data to write
- *                  across the I2C line.
- * @note readTask and writeTask, when undefined, will do nothing with the read
- *       data or will write 0xFF to the I2C line, respectively.
- * @note It is recommended that readTask and writeTask are written to be
- *       nonintrusive and FAST. Ideally, the function moves data from another
- *       place and performs more CPU intensive calculations outside of the
- *       I2CSlaveProcess parent call.
+ * @brief I2CGeneric_Handler advances the transaction state machine of a
+ *        module by one byte.
+ *
+ * @param module The I2C module (0 - 3) that raised the interrupt.
  */
-// void I2CSlaveProcess(I2C_t i2c, uint8_t slaveAddress, void (*readTask)(uint8_t), uint8_t (*writeTask)(void)) {
-//     uint32_t moduleBase = i2c.module * 0x1000 + I2C0_BASE;
-
-//     /* Write own slave address to I2CSOAR. */
-//     GET_REG(moduleBase + I2C_SOAR_OFFSET) = slaveAddress << 1;
-
-//     /* Write to device activate bit I2CSCSR. */
-//     GET_REG(moduleBase + I2C_SCSR_OFFSET) = 1;
-
-//     /* Determine Read request or write request. */
-//     while (!(GET_REG(moduleBase + I2C_SCSR_OFFSET) & 0x03)) {}
-//     if (GET_REG(moduleBase + I2C_SCSR_OFFSET) & 0x01) {
-//         /* Upon read request, read data from I2CSDR. */
-//         uint8_t data = GET_REG(moduleBase + I2C_SDR_OFFSET) & 0xFF;
-//         if (readTask != NULL)
-//             readTask(data);
-//     } else if (GET_REG(moduleBase + I2C_SCSR_OFFSET & 0x02)) {
-//         /* Upon transmit request, write data to I2CSDR. */
-
-//         if (writeTask != NULL) {
-//             uint8_t data = writeTask();
-//             GET_REG(moduleBase + I2C_SDR_OFFSET) = data;
-//         } else {
-//             GET_REG(moduleBase + I2C_SDR_OFFSET) = 0xFF;
-//         }
-//     } else {
-//         /* Illegal state. Goto error handler. */
-//         i2c.I2CErrorHandler();
-//     }
-// }
+static void I2CGeneric_Handler(uint8_t module) {
+    uint32_t moduleBase = module * 0x1000 + I2C0_BASE;
+    struct I2CInterruptSettings * settings = &I2CInterruptSettings[module];
+    I2CTransaction_t * transaction = settings->current;
+
+    if (settings->isSlave) {
+        I2CSlave_Handler(module);
+        return;
+    }
+
+    /* 1. Acknowledge the master and clock timeout interrupts. */
+    uint32_t interrupts = GET_REG(moduleBase + I2C_MMIS_OFFSET);
+    GET_REG(moduleBase + I2C_MICR_OFFSET) = 0x3;
+    if (transaction == NULL) return;
+
+    /* 2. A slave held SCL low past the clock timeout. Free the bus. */
+    if (interrupts & 0x2) {
+        I2CMasterRecover(module);
+        I2CMasterFinish(module, I2C_ERR_CLOCK_TIMEOUT);
+        return;
+    }
+
+    enum I2CStatus status = I2CMasterGetStatus(GET_REG(moduleBase + I2C_MCS_OFFSET));
+
+    /* 3. A stop issued after an error has completed. */
+    if (settings->state == I2C_STATE_STOP) {
+        I2CMasterFinish(module, settings->error);
+        return;
+    }
+
+    /* 4. The master code is never acknowledged. Start the transaction unless
+          arbitration was lost. */
+    if (settings->state == I2C_STATE_MASTER_CODE) {
+        if (status == I2C_ERR_ARBITRATION_LOST || status == I2C_ERR_CLOCK_TIMEOUT) {
+            I2CMasterFinish(module, status);
+        } else {
+            I2CMasterStartTransaction(module);
+        }
+        return;
+    }
+
+    /* 5. Check for error. A lost arbitration releases the bus on its own;
+          otherwise generate a stop bit and finish once it completes. */
+    if (status != I2C_OK) {
+        if (status == I2C_ERR_ARBITRATION_LOST) {
+            I2CMasterFinish(module, status);
+        } else {
+            settings->state = I2C_STATE_STOP;
+            settings->error = status;
+            GET_REG(moduleBase + I2C_MCS_OFFSET) = 0b0100;
+        }
+        return;
+    }
+
+    if (settings->state == I2C_STATE_WRITE) {
+        if (settings->index < transaction->numTx) {
+            /* 6a. Write the next byte. The last byte ends with a stop unless a
+                   read phase follows. */
+            bool isLast = settings->index == transaction->numTx - 1;
+            GET_REG(moduleBase + I2C_MDR_OFFSET) = transaction->txBytes[settings->index];
+            GET_REG(moduleBase + I2C_MCS_OFFSET) =
+                (isLast && transaction->numRx == 0) ? 0b0101 : 0b0001;
+            ++settings->index;
+        } else if (transaction->numRx > 0) {
+            /* 6b. Repeated start into the read phase. */
+            I2CMasterStartRead(module);
+        } else {
+            I2CMasterFinish(module, I2C_OK);
+        }
+    } else {
+        /* 7. Store the byte read. The last byte is not acknowledged and ends
+              with a stop. */
+        transaction->rxBytes[settings->index] = GET_REG(moduleBase + I2C_MDR_OFFSET) & 0xFF;
+        ++settings->index;
+        if (settings->index < transaction->numRx) {
+            GET_REG(moduleBase + I2C_MCS_OFFSET) =
+                (settings->index == transaction->numRx - 1) ? 0b0101 : 0b1001;
+        } else {
+            I2CMasterFinish(module, I2C_OK);
+        }
+    }
+}
+
+void I2C0_Handler(void) { I2CGeneric_Handler(0); }
+void I2C1_Handler(void) { I2CGeneric_Handler(1); }
+void I2C2_Handler(void) { I2CGeneric_Handler(2); }
+void I2C3_Handler(void) { I2CGeneric_Handler(3); }
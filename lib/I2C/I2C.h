@@ -6,10 +6,30 @@
  * @date 2021-10-07
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support the TM4C as a slave
- * device. This device does not support interrupts. This device does not support
- * loopback mode, glitch filters, high speed mode, or simultaneous master/slave
- * mode.
+ * Interrupts. I2CMasterSubmit queues transactions that are run by the I2C
+ * interrupt as a state machine, one byte per interrupt. Each transaction may
+ * write, read, or write then read after a repeated start. I2CMasterSubmitBatch
+ * queues a group of transactions (i.e. one sweep over every sensor on the bus)
+ * that run back to back and report once, with the cycles taken by the sweep.
+ *
+ * Timing. The SCL period is derived from the system clock reported by
+ * PLLGetFrequency, rounded so the bus never runs faster than requested. In high
+ * speed mode, each transaction is preceded by the master code handshake.
+ *
+ * Errors. Blocking functions return an I2CStatus. Every wait on the master is
+ * bounded by a cycle budget, and a slave stretching SCL is bounded by the
+ * clock low timeout. A master that never finishes is recovered by clocking SCL
+ * as a GPIO until the slave releases SDA, then generating a stop.
+ *
+ * Slave Mode. I2CSlaveInit exposes a RAM register file to an external master.
+ * The first byte written after the slave address selects a register; further
+ * bytes written are stored from that register onward, and bytes read are
+ * served from it, all from the I2C interrupt. A write task is notified of the
+ * registers changed once the master issues a stop.
+ *
+ * Unsupported Features. This device does not support loopback mode or
+ * simultaneous master/slave mode on a single module. The TM4C123 I2C modules
+ * have no uDMA channels, so the register file is served by interrupt.
  */
 
 #pragma once
@@ -18,6 +38,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/** @brief I2C_QUEUE_SIZE is the maximum number of transactions waiting on a
+ *         single I2C module. */
+#define I2C_QUEUE_SIZE 16
 
 /**
  * @brief I2CModule is an enumeration specifying a set of pins used for I2C
@@ -52,6 +75,31 @@ enum I2CSpeed {
     I2C_SPEED_3_33_MBPS,
 };
 
+/** @brief I2CStatus is an enumeration specifying the result of a master
+ *         operation. */
+enum I2CStatus {
+    I2C_OK,
+    I2C_ERR_ADDRESS_NACK,       /* No slave acknowledged the address. */
+    I2C_ERR_DATA_NACK,          /* The slave did not acknowledge a byte. */
+    I2C_ERR_ARBITRATION_LOST,   /* Another master took the bus. */
+    I2C_ERR_CLOCK_TIMEOUT,      /* A slave held SCL low too long. */
+    I2C_ERR_TIMEOUT,            /* The master never finished; bus recovered. */
+    I2C_ERR_BUS_STUCK           /* SDA stayed low through bus recovery. */
+};
+
+/** @brief I2CGlitchFilter is an enumeration specifying the width of pulses,
+ *         in system clocks, suppressed on SCL and SDA. */
+enum I2CGlitchFilter {
+    I2C_GLITCH_FILTER_OFF,
+    I2C_GLITCH_FILTER_1_CLOCK,
+    I2C_GLITCH_FILTER_2_CLOCKS,
+    I2C_GLITCH_FILTER_3_CLOCKS,
+    I2C_GLITCH_FILTER_4_CLOCKS,
+    I2C_GLITCH_FILTER_8_CLOCKS,
+    I2C_GLITCH_FILTER_16_CLOCKS,
+    I2C_GLITCH_FILTER_31_CLOCKS
+};
+
 /** @brief I2CConfig_t is a user defined struct that specifies an I2C config. */
 typedef struct I2CConfig {
     /** ------------- Optional Fields. ------------- */
@@ -64,12 +112,55 @@ typedef struct I2CConfig {
     enum I2CModule module;
 
     /**
-     * @brief The data transmission speed for the I2C module.
+     * @brief The data transmission speed for the I2C module. The actual speed
+     *        is the closest speed at or below this achievable with the current
+     *        system clock. See I2CGetTimerPeriod.
      * 
      * Default I2C_SPEED_100_KBPS.
      */
     enum I2CSpeed speed;
 
+    /**
+     * @brief The master code sent before each transaction in high speed mode,
+     *        from 0 - 7. Must be unique for each master on the bus. Only used
+     *        with I2C_SPEED_3_33_MBPS.
+     *
+     * Default is 0 (Master code 0b00001000).
+     */
+    uint8_t masterCode;
+
+    /**
+     * @brief Suppresses pulses on SCL and SDA shorter than the filter width.
+     *
+     * Default is I2C_GLITCH_FILTER_OFF.
+     */
+    enum I2CGlitchFilter glitchFilter;
+
+    /**
+     * @brief The longest wait on the master for a single byte, in
+     *        microseconds, before the bus is recovered and the operation
+     *        fails with I2C_ERR_TIMEOUT.
+     *
+     * Default is 0 (10 ms).
+     */
+    uint32_t timeout;
+
+    /**
+     * @brief The longest a slave may hold SCL low, in units of 16 SCL periods,
+     *        before the operation fails with I2C_ERR_CLOCK_TIMEOUT.
+     *
+     * Default is 0 (255, or 40.8 ms at 100 kbps).
+     */
+    uint8_t clockTimeout;
+
+    /**
+     * @brief I2C interrupt priority. From 0 - 7. Lower value is higher
+     *        priority. Used by queued transactions.
+     *
+     * Default is 0 (Highest priority).
+     */
+    uint8_t priority;
+
     /** ------------- Unimplemented Fields. ------------- */
 
     // /**
@@ -81,12 +172,226 @@ typedef struct I2CConfig {
 
 } I2CConfig_t;
 
+/** @brief I2CSlaveConfig_t is a user defined struct that specifies an I2C
+ *         slave configuration backed by a register file. */
+typedef struct I2CSlaveConfig {
+    /**
+     * @brief The 7-bit address the module responds to.
+     *
+     * Default is 0x00. This must be set.
+     */
+    uint8_t slaveAddress;
+
+    /**
+     * @brief The register file served to the master. Must remain valid while
+     *        the slave is active.
+     *
+     * Default is NULL. This must be set.
+     */
+    volatile uint8_t * registers;
+
+    /**
+     * @brief The number of registers in the register file. From 1 - 256.
+     *        Register accesses past the end wrap around to register 0.
+     *
+     * Default is 0. This must be set.
+     */
+    uint16_t numRegisters;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief The I2C module used for configuration.
+     *
+     * Default I2C_MODULE_0.
+     */
+    enum I2CModule module;
+
+    /**
+     * @brief Pointer to function called from the I2C interrupt when a write
+     *        from the master completes. Receives the first register written
+     *        and the number of registers written, from 1 - numRegisters. A
+     *        write that wraps around the whole 256 register file reports 256,
+     *        which is why the count is 16 bits wide.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*writeTask)(uint8_t firstRegister, uint16_t numRegisters);
+
+    /**
+     * @brief I2C interrupt priority. From 0 - 7. Lower value is higher
+     *        priority.
+     *
+     * Default is 0 (Highest priority).
+     */
+    uint8_t priority;
+
+    /**
+     * @brief Suppresses pulses on SCL and SDA shorter than the filter width.
+     *
+     * Default is I2C_GLITCH_FILTER_OFF.
+     */
+    enum I2CGlitchFilter glitchFilter;
+} I2CSlaveConfig_t;
+
 /** @brief I2C_t is a struct containing user relevant data of a I2C peripheral. */
 typedef struct I2C {
     /** @brief The I2CModule used with communicating to another device. */
     enum I2CModule module;
 } I2C_t;
 
+/** @brief I2CTransaction_t is a user defined struct that specifies a single
+ *         queued master transaction. The write phase, if any, runs first. The
+ *         read phase, if any, follows after a repeated start. */
+typedef struct I2CTransaction {
+    /** 
+     * @brief Address of the slave device to contact.
+     *
+     * Default is 0x00.
+     */
+    uint8_t slaveAddress;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Bytes to write.
+     *
+     * Default is NULL (No write phase).
+     */
+    const uint8_t * txBytes;
+
+    /**
+     * @brief The number of bytes to write.
+     *
+     * Default is 0 (No write phase).
+     */
+    uint8_t numTx;
+
+    /**
+     * @brief Buffer to read into.
+     *
+     * Default is NULL (No read phase).
+     */
+    uint8_t * rxBytes;
+
+    /**
+     * @brief The number of bytes to read.
+     *
+     * Default is 0 (No read phase).
+     */
+    uint8_t numRx;
+
+    /**
+     * @brief Pointer to function called from the I2C interrupt when the
+     *        transaction completes, successfully or not.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+
+    /** ------------- Output Fields. ------------- */
+
+    /** @brief Set once the transaction completes. Cleared on submit. */
+    volatile bool isDone;
+
+    /** @brief The result of the transaction. Valid once isDone is set. */
+    volatile enum I2CStatus status;
+
+    /** ------------- Internal Fields. ------------- */
+
+    /** @brief The batch the transaction belongs to. Set on submit. */
+    struct I2CBatch * batch;
+} I2CTransaction_t;
+
+/** @brief I2CBatch_t is a user defined struct that specifies a group of
+ *         transactions run back to back on a single I2C module. */
+typedef struct I2CBatch {
+    /**
+     * @brief Array of transactions, run in order. Each transaction keeps its
+     *        own status and completion function.
+     *
+     * Default is NULL. This must be set.
+     */
+    I2CTransaction_t * transactions;
+
+    /**
+     * @brief The number of transactions. From 1 - I2C_QUEUE_SIZE.
+     *
+     * Default is 0. This must be set.
+     */
+    uint8_t numTransactions;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Pointer to function called from the I2C interrupt when every
+     *        transaction in the batch completes.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+
+    /** ------------- Output Fields. ------------- */
+
+    /** @brief Set once every transaction completes. Cleared on submit. */
+    volatile bool isDone;
+
+    /** @brief The number of transactions that failed. */
+    volatile uint8_t numFailed;
+
+    /**
+     * @brief System clock cycles from the start of the first transaction to
+     *        the end of the last transaction.
+     */
+    volatile uint32_t cycles;
+
+    /** ------------- Internal Fields. ------------- */
+
+    /** @brief The number of transactions not yet completed. */
+    uint8_t numRemaining;
+
+    /** @brief Cycle count at the start of the first transaction. */
+    uint32_t startCycle;
+} I2CBatch_t;
+
+/**
+ * @brief I2CSlaveInit initializes an I2C module as a slave serving a register
+ *        file. Requests are handled entirely by the I2C interrupt.
+ * 
+ * @param config The configuration of the I2C slave.
+ * @return An I2C_t struct instance.
+ * @note Requires calling EnableInterrupts() after initialization.
+ */
+I2C_t I2CSlaveInit(I2CSlaveConfig_t config);
+
+/**
+ * @brief I2CGetTimerPeriod computes the MTPR timer period of a speed at a
+ *        given system clock, without touching any hardware.
+ * 
+ * @param systemClock The system clock frequency, in Hz.
+ * @param speed The data transmission speed.
+ * @return The timer period, from 0 - 127. The SCL frequency is
+ *         systemClock / (2 * (period + 1) * 10), or
+ *         systemClock / (2 * (period + 1) * 3) for I2C_SPEED_3_33_MBPS.
+ */
+uint8_t I2CGetTimerPeriod(uint32_t systemClock, enum I2CSpeed speed);
+
 /**
  * @brief I2CInit initializes an I2C module given an I2CConfig_t configuration.
  * 
@@ -103,9 +408,9 @@ I2C_t I2CInit(I2CConfig_t config);
  * @param slaveAddress Address of the slave device to contact.
  * @param bytes Pointer to the data array to send.
  * @param numBytes The number of bytes in the data array to send.
- * @return Whether the transmission was successful or not.
+ * @return I2C_OK, or the reason the transmission failed.
  */
-bool I2CMasterTransmit(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t numBytes);
+enum I2CStatus I2CMasterTransmit(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t numBytes);
 
 /**
  * @brief I2CMasterReceive receives a specified number of bytes across the data
@@ -115,6 +420,97 @@ bool I2CMasterTransmit(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t
  * @param slaveAddress Address of the slave device to get data from.
  * @param bytes Pointer to the data array to fill.
  * @param numBytes The number of bytes in the data array to fill.
- * @return Whether the transmission was successful or not.
+ * @return I2C_OK, or the reason the transmission failed.
+ */
+enum I2CStatus I2CMasterReceive(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t numBytes);
+
+/**
+ * @brief I2CMasterTransmitByte transmits a single byte, ending with a stop.
+ *        Faster than I2CMasterTransmit for single byte commands.
+ * 
+ * @param i2c The I2C module to transmit across.
+ * @param slaveAddress Address of the slave device to contact.
+ * @param byte The byte to send.
+ * @return I2C_OK, or the reason the transmission failed.
+ */
+enum I2CStatus I2CMasterTransmitByte(I2C_t i2c, uint8_t slaveAddress, uint8_t byte);
+
+/**
+ * @brief I2CMasterReceiveByte receives a single byte, ending with a stop.
+ *        Faster than I2CMasterReceive for single byte reads.
+ * 
+ * @param i2c The I2C module to receive across.
+ * @param slaveAddress Address of the slave device to get data from.
+ * @param byte Pointer to the byte to fill.
+ * @return I2C_OK, or the reason the transmission failed.
+ */
+enum I2CStatus I2CMasterReceiveByte(I2C_t i2c, uint8_t slaveAddress, uint8_t * byte);
+
+/**
+ * @brief I2CMasterWriteRead transmits bytes and then receives bytes from the
+ *        same slave after a repeated start, without releasing the bus in
+ *        between. This is the usual register read: write the register
+ *        address, then read its contents.
+ * 
+ * @param i2c The I2C module to communicate across.
+ * @param slaveAddress Address of the slave device to contact.
+ * @param txBytes Pointer to the data array to send.
+ * @param numTx The number of bytes in the data array to send.
+ * @param rxBytes Pointer to the data array to fill.
+ * @param numRx The number of bytes in the data array to fill.
+ * @return I2C_OK, or the reason the transmission failed.
+ */
+enum I2CStatus I2CMasterWriteRead(I2C_t i2c, uint8_t slaveAddress, const uint8_t * txBytes, uint8_t numTx, uint8_t * rxBytes, uint8_t numRx);
+
+/**
+ * @brief I2CBusRecover frees a bus held by a slave stuck mid transfer by
+ *        clocking SCL up to nine times until SDA is released, then generating a
+ *        stop. Called automatically when a master operation times out.
+ * 
+ * @param i2c The I2C module whose bus is recovered.
+ * @return I2C_OK, or I2C_ERR_BUS_STUCK if SDA is still held low.
+ */
+enum I2CStatus I2CBusRecover(I2C_t i2c);
+
+/**
+ * @brief I2CMasterSubmit queues a transaction on an I2C module and returns
+ *        immediately. Safe to call from both the main loop and interrupts.
+ *        Transactions run in submission order from the I2C interrupt.
+ * 
+ * @param i2c The I2C module to run the transaction on.
+ * @param transaction The transaction to queue. It, and its buffers, must
+ *                    remain valid until isDone is set.
+ * @return False if I2C_QUEUE_SIZE transactions are already waiting. The
+ *         transaction is then left untouched.
+ * @note Do not mix queued transactions with the blocking master functions on
+ *       the same module while the queue is running.
+ */
+bool I2CMasterSubmit(I2C_t i2c, I2CTransaction_t * transaction);
+
+/**
+ * @brief I2CMasterSubmitBatch queues every transaction of a batch on an I2C
+ *        module and returns immediately. The batch is queued whole or not at
+ *        all, so its transactions run back to back.
+ * 
+ * @param i2c The I2C module to run the batch on.
+ * @param batch The batch to queue. It, its transactions, and their buffers
+ *              must remain valid until isDone is set.
+ * @return False if the queue cannot hold every transaction of the batch. The
+ *         batch and its transactions are then left untouched.
  */
-bool I2CMasterReceive(I2C_t i2c, uint8_t slaveAddress, uint8_t * bytes, uint8_t numBytes);
+bool I2CMasterSubmitBatch(I2C_t i2c, I2CBatch_t * batch);
+
+/**
+ * @brief I2CMasterIsBusy returns whether a module has transactions running or
+ *        waiting.
+ * 
+ * @param i2c The I2C module to check.
+ * @return True if the queue is not empty.
+ */
+bool I2CMasterIsBusy(I2C_t i2c);
+
+/** I2C handler declarations. */
+void I2C0_Handler(void);
+void I2C1_Handler(void);
+void I2C2_Handler(void);
+void I2C3_Handler(void);
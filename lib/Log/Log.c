@@ -0,0 +1,297 @@
+/**
+ * @file Log.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Deferred printf style logging.
+ * @version 0.1
+ * @date 2022-03-08
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <assert.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/Common/Common.h>
+#include <lib/Log/Log.h>
+
+
+uint32_t StartCritical(void);       // Defined in startup.s
+void EndCritical(uint32_t sr);      // Defined in startup.s
+
+/** @brief LogBuffer is the ring of records. */
+static struct LogBuffer {
+    /** @brief The records. Written through volatile pointers so a record is
+     *         complete before it is published. */
+    LogRecord_t records[LOG_BUFFER_SIZE];
+
+    /** @brief Whether each record has been published by its writer. */
+    volatile bool isReady[LOG_BUFFER_SIZE];
+
+    /** @brief The number of records reserved by writers. */
+    volatile uint32_t head;
+
+    /** @brief The number of records read. */
+    volatile uint32_t tail;
+
+    /** @brief The number of records dropped because the ring was full. */
+    volatile uint32_t dropped;
+
+    /** @brief The number of dropped records reported by LogFlush. */
+    uint32_t droppedReported;
+} LogBuffer;
+
+/** @brief LogFrame is the formatted lines sent by LogFlush with the uDMA.
+ *         Owned by the uDMA until the UART is idle. */
+static char LogFrame[LOG_FRAME_SIZE];
+
+void LogInit(void) {
+    /* 1. Enable the cycle counter. */
+    CommonEnableCycleCounter();
+
+    /* 2. Empty the ring. */
+    uint32_t sr = StartCritical();
+    uint32_t i;
+    for (i = 0; i < LOG_BUFFER_SIZE; ++i) LogBuffer.isReady[i] = false;
+    LogBuffer.head = 0;
+    LogBuffer.tail = 0;
+    LogBuffer.dropped = 0;
+    LogBuffer.droppedReported = 0;
+    EndCritical(sr);
+}
+
+bool LogWrite(const char * format, uint8_t numArgs, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d) {
+    /* Initialization asserts. */
+    assert(format != NULL);
+    assert(numArgs <= LOG_MAX_ARGS);
+
+    /* 1. Reserve a record. Interrupts are masked only while the head moves. */
+    uint32_t sr = StartCritical();
+    uint32_t head = LogBuffer.head;
+    if (head - LogBuffer.tail >= LOG_BUFFER_SIZE) {
+        ++LogBuffer.dropped;
+        EndCritical(sr);
+        return false;
+    }
+    LogBuffer.head = head + 1;
+    EndCritical(sr);
+
+    /* 2. Fill the record, then publish it. */
+    uint32_t index = head & (LOG_BUFFER_SIZE - 1);
+    volatile LogRecord_t * record = &LogBuffer.records[index];
+    record->format = format;
+    record->timestamp = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+    record->numArgs = numArgs;
+    record->args[0] = a;
+    record->args[1] = b;
+    record->args[2] = c;
+    record->args[3] = d;
+    LogBuffer.isReady[index] = true;
+    return true;
+}
+
+bool LogRead(LogRecord_t * record) {
+    /* Initialization asserts. */
+    assert(record != NULL);
+
+    /* 1. Records are read in reservation order. A record still being written
+          (i.e. by an interrupted writer) holds back the ones after it. */
+    uint32_t tail = LogBuffer.tail;
+    if (tail == LogBuffer.head) return false;
+    uint32_t index = tail & (LOG_BUFFER_SIZE - 1);
+    if (!LogBuffer.isReady[index]) return false;
+
+    /* 2. Copy the record out, then release it to the writers. */
+    volatile LogRecord_t * source = &LogBuffer.records[index];
+    record->format = source->format;
+    record->timestamp = source->timestamp;
+    record->numArgs = source->numArgs;
+    uint8_t i;
+    for (i = 0; i < LOG_MAX_ARGS; ++i) record->args[i] = source->args[i];
+
+    LogBuffer.isReady[index] = false;
+    LogBuffer.tail = tail + 1;
+    return true;
+}
+
+uint8_t LogSnapshot(LogRecord_t * records, uint8_t maxRecords) {
+    /* Initialization asserts. */
+    assert(records != NULL);
+
+    /* 1. Records are only overwritten after LOG_BUFFER_SIZE reservations, so
+          the last ones reserved are still in the ring, read or not. */
+    uint32_t head = LogBuffer.head;
+    uint32_t count = maxRecords;
+    if (count > LOG_BUFFER_SIZE) count = LOG_BUFFER_SIZE;
+    if (count > head) count = head;
+
+    /* 2. Copy them out, oldest first. */
+    uint32_t i;
+    for (i = 0; i < count; ++i) {
+        volatile LogRecord_t * source = &LogBuffer.records[(head - count + i) & (LOG_BUFFER_SIZE - 1)];
+        records[i].format = source->format;
+        records[i].timestamp = source->timestamp;
+        records[i].numArgs = source->numArgs;
+        uint8_t j;
+        for (j = 0; j < LOG_MAX_ARGS; ++j) records[i].args[j] = source->args[j];
+    }
+    return count;
+}
+
+uint8_t LogFormat(const LogRecord_t * record, char * line) {
+    /* Initialization asserts. */
+    assert(record != NULL);
+    assert(line != NULL);
+
+    /* Leave room for the ending. */
+    const uint8_t maxLength = LOG_LINE_SIZE - 3;
+
+    /* 1. Timestamp. */
+    uint8_t length = CommonFormatNumber(line, 0, maxLength, record->timestamp, 10, false, 0, ' ');
+    line[length++] = ' ';
+
+    /* 2. Message. */
+    const char * format = record->format;
+    uint8_t arg = 0;
+    while (*format != '\0' && length < maxLength) {
+        if (*format != '%') {
+            line[length++] = *format++;
+            continue;
+        }
+        ++format;
+
+        /* Flags and width. */
+        char pad = ' ';
+        uint8_t width = 0;
+        if (*format == '0') {
+            pad = '0';
+            ++format;
+        }
+        while ('0' <= *format && *format <= '9') {
+            width = width * 10 + (*format - '0');
+            ++format;
+        }
+
+        /* Missing arguments are formatted as 0. */
+        uintptr_t value = 0;
+        if (*format != '%' && *format != '\0') {
+            value = (arg < record->numArgs) ? record->args[arg] : 0;
+            ++arg;
+        }
+
+        switch (*format) {
+            case 'd':
+            case 'i':
+                if ((intptr_t)value < 0) {
+                    line[length++] = '-';
+                    value = 0 - value;
+                }
+                length = CommonFormatNumber(line, length, maxLength, value, 10, false, width, pad);
+                break;
+            case 'u':
+                length = CommonFormatNumber(line, length, maxLength, value, 10, false, width, pad);
+                break;
+            case 'x':
+            case 'X':
+                length = CommonFormatNumber(line, length, maxLength, value, 16, *format == 'X', width, pad);
+                break;
+            case 'p':
+                line[length++] = '0';
+                if (length < maxLength) line[length++] = 'x';
+                length = CommonFormatNumber(line, length, maxLength, value, 16, false, 2 * sizeof(uintptr_t), '0');
+                break;
+            case 'c':
+                line[length++] = (char)value;
+                break;
+            case 's': {
+                const char * string = (value != 0) ? (const char *)value : "(null)";
+                while (*string != '\0' && length < maxLength) line[length++] = *string++;
+                break;
+            }
+            case '%':
+                line[length++] = '%';
+                break;
+            default:
+                /* Unknown conversions are dropped. */
+                break;
+        }
+        if (*format != '\0') ++format;
+    }
+
+    line[length++] = '\r';
+    line[length++] = '\n';
+    line[length] = '\0';
+    return length;
+}
+
+uint32_t LogGetDropped(void) {
+    return LogBuffer.dropped;
+}
+
+/**
+ * @brief LogFormatDropped formats a line reporting the records lost since the
+ *        last flush, and marks them reported.
+ *
+ * @param line Output buffer of at least LOG_LINE_SIZE bytes.
+ * @return The length of the line, or 0 if no record was lost.
+ */
+static uint8_t LogFormatDropped(char * line) {
+    uint32_t dropped = LogBuffer.dropped;
+    if (dropped == LogBuffer.droppedReported) return 0;
+
+    LogRecord_t notice = {
+        .format="LOG: %u records dropped",
+        .timestamp=GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET),
+        .numArgs=1,
+        .args={ dropped - LogBuffer.droppedReported }
+    };
+    LogBuffer.droppedReported = dropped;
+    return LogFormat(&notice, line);
+}
+
+/**
+ * @brief LogFlushAsync formats records into LogFrame while a full line still
+ *        fits, and sends the frame with the uDMA.
+ *
+ * @param uart The UART to transmit across. Initialized with isDMA.
+ * @param maxRecords The most records to send.
+ * @return The number of records handed to the uDMA.
+ */
+static uint32_t LogFlushAsync(UART_t uart, uint32_t maxRecords) {
+    LogRecord_t record;
+
+    /* 1. The previous frame is still being sent. */
+    if (UARTIsBusy(uart)) return 0;
+
+    /* 2. Fill the frame, starting with the records lost since the last flush. */
+    uint16_t length = LogFormatDropped(LogFrame);
+    uint32_t count = 0;
+    while (count < maxRecords && length + LOG_LINE_SIZE <= LOG_FRAME_SIZE && LogRead(&record)) {
+        length += LogFormat(&record, LogFrame + length);
+        ++count;
+    }
+
+    /* 3. Transmit the frame in the background. */
+    if (length > 0) UARTSendAsync(uart, (uint8_t *)LogFrame, length);
+    return count;
+}
+
+uint32_t LogFlush(UART_t uart, uint32_t maxRecords) {
+    char line[LOG_LINE_SIZE];
+    LogRecord_t record;
+
+    if (uart.isDMA) return LogFlushAsync(uart, maxRecords);
+
+    /* 1. Report records lost since the last flush. */
+    uint8_t length = LogFormatDropped(line);
+    if (length > 0) UARTSend(uart, (uint8_t *)line, length);
+
+    /* 2. Send the oldest records. */
+    uint32_t count = 0;
+    while (count < maxRecords && LogRead(&record)) {
+        UARTSend(uart, (uint8_t *)line, LogFormat(&record, line));
+        ++count;
+    }
+    return count;
+}
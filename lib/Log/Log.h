@@ -0,0 +1,159 @@
+/**
+ * @file Log.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Deferred printf style logging.
+ * @version 0.1
+ * @date 2022-03-08
+ * @copyright Copyright (c) 2022
+ * @note
+ * Usage. LOG stores the format string pointer, up to LOG_MAX_ARGS raw
+ * arguments, and a cycle counter timestamp into a ring of records. Nothing is
+ * formatted at the call site, so LOG is safe and cheap to call from interrupts.
+ * Formatting happens later, in the idle loop, with LogFlush (over UART) or
+ * LogRead and LogFormat (for any other backend). When the UART was initialized
+ * with isDMA, LogFlush formats a batch of records into a frame owned by Log and
+ * hands it to the uDMA, returning without waiting for it to be sent.
+ *
+ *      LOG("adc %u on channel %d", sample, channel);
+ *      ...
+ *      while (1) { LogFlush(uart, 4); WaitForInterrupt(); }
+ *
+ * Format strings and strings passed to %s must outlive the record; use string
+ * literals. Supported conversions are %d, %i, %u, %x, %X, %c, %s, %p and %%,
+ * with an optional '0' flag and width (i.e. %08x).
+ *
+ * Concurrency. Writers reserve a record with interrupts masked for a few
+ * instructions, fill it, then publish it. A writer never waits on the reader.
+ * When the ring is full, the record is dropped and counted. LogRead and
+ * LogFlush must be called from a single context.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Device specific imports. */
+#include <lib/UART/UART.h>
+
+
+/** @brief LOG_MAX_ARGS is the maximum number of arguments of a record. */
+#define LOG_MAX_ARGS 4
+
+/** @brief LOG_BUFFER_SIZE is the number of records in the ring. Must be a
+ *         power of two. */
+#define LOG_BUFFER_SIZE 32
+
+/** @brief LOG_LINE_SIZE is the maximum length of a formatted record. */
+#define LOG_LINE_SIZE 96
+
+/** @brief LOG_FRAME_SIZE is the size of the frame LogFlush sends with the
+ *         uDMA. Holds at least 5 full lines; at most 1024 bytes. */
+#define LOG_FRAME_SIZE 512
+
+/**
+ * @brief LOG records a message with up to LOG_MAX_ARGS integer or pointer
+ *        arguments.
+ *
+ * @return False if the ring was full and the record was dropped.
+ * @note Passing 5 to 12 arguments fails to compile, naming
+ *       LOG_takes_at_most_4_arguments. The macros below are written for a
+ *       LOG_MAX_ARGS of 4 and must be updated with it.
+ */
+#define LOG(...) LOG_(LOG_NUM_ARGS(__VA_ARGS__), __VA_ARGS__, 0, 0, 0, 0, 0)
+#define LOG_(numArgs, format, a, b, c, d, ...) \
+    LogWrite(format, numArgs, (uintptr_t)(a), (uintptr_t)(b), (uintptr_t)(c), (uintptr_t)(d))
+#define LOG_NUM_ARGS(...) LOG_NUM_ARGS_(__VA_ARGS__, \
+    LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, \
+    LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, \
+    4, 3, 2, 1, 0, 0)
+#define LOG_NUM_ARGS_(format, a, b, c, d, e, f, g, h, i, j, k, l, numArgs, ...) numArgs
+#define LOG_TOO_MANY_ARGS LOG_takes_at_most_4_arguments
+
+/** @brief LogRecord_t is a single unformatted log message. */
+typedef struct LogRecord {
+    /** @brief The format string. */
+    const char * format;
+
+    /** @brief The cycle counter when the record was written. */
+    uint32_t timestamp;
+
+    /** @brief The number of arguments used, from 0 - LOG_MAX_ARGS. */
+    uint8_t numArgs;
+
+    /** @brief The raw arguments. */
+    uintptr_t args[LOG_MAX_ARGS];
+} LogRecord_t;
+
+/**
+ * @brief LogInit empties the ring and enables the DWT cycle counter used for
+ *        timestamps.
+ */
+void LogInit(void);
+
+/**
+ * @brief LogWrite records a message. Use LOG instead, which counts the
+ *        arguments.
+ *
+ * @param format The format string. Must outlive the record.
+ * @param numArgs The number of arguments used, from 0 - LOG_MAX_ARGS.
+ * @param a First argument.
+ * @param b Second argument.
+ * @param c Third argument.
+ * @param d Fourth argument.
+ * @return False if the ring was full and the record was dropped.
+ */
+bool LogWrite(const char * format, uint8_t numArgs, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d);
+
+/**
+ * @brief LogRead removes the oldest published record from the ring.
+ *
+ * @param record Output for the record.
+ * @return False if there is no published record.
+ */
+bool LogRead(LogRecord_t * record);
+
+/**
+ * @brief LogSnapshot copies the most recent records, oldest first, without
+ *        removing them from the ring. Records already read are included. Meant
+ *        for crash dumps, where the ring is frozen.
+ *
+ * @param records Output for the records.
+ * @param maxRecords The most records to copy.
+ * @return The number of records copied.
+ */
+uint8_t LogSnapshot(LogRecord_t * records, uint8_t maxRecords);
+
+/**
+ * @brief LogFormat formats a record as "<timestamp> <message>\r\n".
+ *
+ * @param record The record to format.
+ * @param line Output buffer of at least LOG_LINE_SIZE bytes. Long messages
+ *             are truncated.
+ * @return The length of the line, excluding the null terminator.
+ */
+uint8_t LogFormat(const LogRecord_t * record, char * line);
+
+/**
+ * @brief LogGetDropped returns the number of records dropped because the ring
+ *        was full.
+ *
+ * @return The number of records dropped since LogInit.
+ */
+uint32_t LogGetDropped(void);
+
+/**
+ * @brief LogFlush formats and transmits up to maxRecords records over a UART.
+ *        New drops are reported in a line of their own. Call from the idle
+ *        loop.
+ *
+ *        Without isDMA, each line is sent with UARTSend, which blocks until it
+ *        is in the transmit FIFO. With isDMA, the records that fit in
+ *        LOG_FRAME_SIZE are sent with UARTSendAsync, and nothing is sent while
+ *        the previous frame is still transmitting.
+ *
+ * @param uart The UART to transmit across.
+ * @param maxRecords The most records to send, bounding the time spent.
+ * @return The number of records sent, or handed to the uDMA.
+ */
+uint32_t LogFlush(UART_t uart, uint32_t maxRecords);
@@ -28,12 +28,125 @@
  * http://users.ece.utexas.edu/~valvano/
  */
 
+/** General imports. */
+#include <stdbool.h>
+#include <stdlib.h>
+#include <assert.h>
+
 /** Device specific imports. */
 #include <lib/PLL/PLL.h>
 #include <inc/RegDefs.h>
 
 
-void PLLInit(uint32_t freq) {
+/** @brief PLLFrequency is the system clock frequency, in Hz. 0 until the clock
+ *         configuration is first decoded. */
+static uint32_t PLLFrequency = 0;
+
+uint32_t StartCritical(void);       // Defined in startup.s
+void EndCritical(uint32_t sr);      // Defined in startup.s
+
+/** @brief PLLClockTask is a function called around a clock change. */
+struct PLLClockTask {
+    /** @brief User function called with the new frequency. */
+    void (*task)(uint32_t frequency, uint32_t *args);
+
+    /** @brief User args associated with the function. */
+    uint32_t * args;
+};
+
+/** @brief PLLClockTasks are the functions called after the clock changes. */
+static struct PLLClockTask PLLClockTasks[PLL_CLOCK_TASK_COUNT];
+
+/** @brief The number of PLLClockTasks registered. */
+static uint8_t PLLClockTaskCount = 0;
+
+/** @brief PLLPrepareTasks are the functions called before the clock changes. */
+static struct PLLClockTask PLLPrepareTasks[PLL_CLOCK_TASK_COUNT];
+
+/** @brief The number of PLLPrepareTasks registered. */
+static uint8_t PLLPrepareTaskCount = 0;
+
+/**
+ * @brief PLLCrystalMapping is the main oscillator frequency, in Hz, of each
+ *        RCC XTAL field value from 0x06 to 0x15. See the RCC register on p. 254
+ *        of the TM4C Datasheet.
+ */
+static const uint32_t PLLCrystalMapping[16] = {
+    4000000, 4096000, 4915200, 5000000, 5120000, 6000000, 6144000, 7372800,
+    8000000, 8192000, 10000000, 12000000, 12288000, 13560000, 14318180, 16000000
+};
+
+/**
+ * @brief PLLDecodeFrequency decodes the system clock frequency from the clock
+ *        configuration registers.
+ * 
+ * @return The system clock frequency, in Hz.
+ */
+static uint32_t PLLDecodeFrequency(void) {
+    uint32_t rcc = GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET);
+    uint32_t rcc2 = GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET);
+    bool isRCC2 = rcc2 & 0x80000000;
+
+    /* 1. Find the oscillator source. */
+    uint32_t source = isRCC2 ? (rcc2 >> 4) & 0x7 : (rcc >> 4) & 0x3;
+    uint32_t xtal = (rcc >> 6) & 0x1F;
+    uint32_t sourceFreq;
+    switch (source) {
+        case 0: /* Main oscillator. */
+            sourceFreq = xtal >= 0x06 ? PLLCrystalMapping[xtal - 0x06] : 16000000;
+            break;
+        case 1: /* Precision internal oscillator. */
+            sourceFreq = 16000000;
+            break;
+        case 2: /* Precision internal oscillator / 4. */
+            sourceFreq = 4000000;
+            break;
+        case 3: /* Low frequency internal oscillator. */
+            sourceFreq = 30000;
+            break;
+        default: /* 32.768 kHz hibernation oscillator. */
+            sourceFreq = 32768;
+            break;
+    }
+
+    /* 2. Apply the PLL, if not bypassed. The PLL always uses the divisor. */
+    if (isRCC2) {
+        uint32_t sysdiv = (rcc2 >> 23) & 0x3F;
+        if (!(rcc2 & 0x00000800)) {
+            if (rcc2 & 0x40000000) {
+                return 400000000 / (((sysdiv << 1) | ((rcc2 >> 22) & 0x1)) + 1);
+            }
+            return 200000000 / (sysdiv + 1);
+        }
+        return (rcc & 0x00400000) ? sourceFreq / (sysdiv + 1) : sourceFreq;
+    } else {
+        uint32_t sysdiv = (rcc >> 23) & 0xF;
+        if (!(rcc & 0x00000800)) {
+            return 200000000 / (sysdiv + 1);
+        }
+        return (rcc & 0x00400000) ? sourceFreq / (sysdiv + 1) : sourceFreq;
+    }
+}
+
+
+/**
+ * @brief PLLStartMainOscillator powers up the main oscillator, if it is
+ *        powered down, and waits for it to stabilize.
+ */
+static void PLLStartMainOscillator(void) {
+    if (GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) & 0x00000001) {
+        GET_REG(SYSCTL_BASE + SYSCTL_MISC_OFFSET) = 0x00000100;
+        GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) &= ~0x00000001;
+        while ((GET_REG(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x00000100) == 0) {}
+    }
+}
+
+/**
+ * @brief PLLConfigurePLL runs the system clock from the PLL.
+ * 
+ * @param freq SYSDIV2 of the PLL. One of the BUS_ defines.
+ */
+static void PLLConfigurePLL(uint32_t freq) {
     /* 1. Configure the system to use RCC@ for advanced features. */
     GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= 0x80000000;
 
@@ -45,11 +158,19 @@ void PLLInit(uint32_t freq) {
     GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) |= 0x00000540;
 
     /* 4. Clear the oscillator source field and configure for main oscillator source. */
+    PLLStartMainOscillator();
     GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00000070;
     GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= 0;
 
-    /* 5. Activate PLL by clearing PWRDN. */
-    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00002000;
+    /* 5. Activate PLL by clearing PWRDN. PLLLRIS is sticky, so clear it
+          first; otherwise a lock from an earlier power up passes step 7. A
+          PLL that is already powered up stays locked and sets no new
+          PLLLRIS, so it is not waited on. */
+    bool isPoweredDown = GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) & 0x00002000;
+    if (isPoweredDown) {
+        GET_REG(SYSCTL_BASE + SYSCTL_MISC_OFFSET) = 0x00000040;
+        GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00002000;
+    }
 
     /* 6. Set PLL frequency. */
     GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= 0x40000000;
@@ -57,12 +178,107 @@ void PLLInit(uint32_t freq) {
     GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= freq << 22;
 
     /* 7. Wait for PLL to lock. */
-    while ((GET_REG(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x00000040) == 0) {}
+    if (isPoweredDown) {
+        while ((GET_REG(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x00000040) == 0) {}
+    }
 
     /* 8. Enable PLL. */
     GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00000800;
 }
 
+/**
+ * @brief PLLConfigureBypass runs the system clock from an oscillator, with
+ *        the PLL powered down.
+ * 
+ * @param source PLL_SOURCE_MOSC or PLL_SOURCE_PIOSC.
+ * @param divisor The clock divisor less one, from 0 - 63.
+ */
+static void PLLConfigureBypass(enum PLLSource source, uint32_t divisor) {
+    /* 1. Configure the system to use RCC2 and bypass the PLL. */
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= 0x80000000;
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= 0x00000800;
+
+    /* 2. Select the oscillator source. The main oscillator is a 16 MHz
+          crystal. */
+    if (source == PLL_SOURCE_MOSC) {
+        GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) &= ~0x000007C0;
+        GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) |= 0x00000540;
+        PLLStartMainOscillator();
+    }
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00000070;
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= (source == PLL_SOURCE_PIOSC) ? 0x00000010 : 0;
+
+    /* 3. Set the divisor. DIV400 is cleared so SYSDIV2 is the whole divisor. */
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x5FC00000;
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= divisor << 23;
+    if (divisor > 0) GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) |= 0x00400000;
+    else GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) &= ~0x00400000;
+
+    /* 4. Power down the PLL, and the main oscillator if it is unused. */
+    GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) |= 0x00002000;
+    if (source == PLL_SOURCE_PIOSC) GET_REG(SYSCTL_BASE + SYSCTL_RCC_OFFSET) |= 0x00000001;
+}
+
+void PLLInit(uint32_t freq) {
+    PLLSetClock(PLL_SOURCE_PLL, freq);
+}
+
+uint32_t PLLSetClock(enum PLLSource source, uint32_t divisor) {
+    /* Initialization asserts. */
+    assert(source <= PLL_SOURCE_PIOSC);
+    assert(source != PLL_SOURCE_PLL || (BUS_80_MHZ <= divisor && divisor <= BUS_3_125_MHZ));
+    assert(source == PLL_SOURCE_PLL || divisor <= 63);
+
+    /* 1. Let the drivers finish in-flight transfers at the old clock. */
+    uint32_t frequency = (source == PLL_SOURCE_PLL) ?
+        400000000 / (divisor + 1) : 16000000 / (divisor + 1);
+    bool isChanged = frequency != PLLGetFrequency();
+    uint8_t i;
+    if (isChanged) {
+        for (i = 0; i < PLLPrepareTaskCount; ++i) {
+            PLLPrepareTasks[i].task(frequency, PLLPrepareTasks[i].args);
+        }
+    }
+
+    /* 2. Switch the clock and retime the drivers in one critical section. */
+    uint32_t sr = StartCritical();
+    if (source == PLL_SOURCE_PLL) PLLConfigurePLL(divisor);
+    else PLLConfigureBypass(source, divisor);
+
+    PLLFrequency = PLLDecodeFrequency();
+    if (isChanged) {
+        for (i = 0; i < PLLClockTaskCount; ++i) {
+            PLLClockTasks[i].task(PLLFrequency, PLLClockTasks[i].args);
+        }
+    }
+    EndCritical(sr);
+
+    return PLLFrequency;
+}
+
+uint32_t PLLGetFrequency(void) {
+    if (PLLFrequency == 0) PLLFrequency = PLLDecodeFrequency();
+    return PLLFrequency;
+}
+
+bool PLLAddClockTask(void (*clockTask)(uint32_t frequency, uint32_t *args), uint32_t * clockArgs) {
+    if (clockTask == NULL || PLLClockTaskCount >= PLL_CLOCK_TASK_COUNT) return false;
+
+    PLLClockTasks[PLLClockTaskCount].task = clockTask;
+    PLLClockTasks[PLLClockTaskCount].args = clockArgs;
+    ++PLLClockTaskCount;
+    return true;
+}
+
+bool PLLAddClockPrepareTask(void (*prepareTask)(uint32_t frequency, uint32_t *args), uint32_t * prepareArgs) {
+    if (prepareTask == NULL || PLLPrepareTaskCount >= PLL_CLOCK_TASK_COUNT) return false;
+
+    PLLPrepareTasks[PLLPrepareTaskCount].task = prepareTask;
+    PLLPrepareTasks[PLLPrepareTaskCount].args = prepareArgs;
+    ++PLLPrepareTaskCount;
+    return true;
+}
+
 
 /**
     SYSDIV2  Divisor  Clock (MHz)
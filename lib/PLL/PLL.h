@@ -26,20 +26,98 @@
  * OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
  * For more information about my classes, my research, and my books, see
  * http://users.ece.utexas.edu/~valvano/
+ * @note
+ * Frequency Scaling. PLLSetClock switches between PLL frequencies and the
+ * bypassed main (MOSC) or precision internal (PIOSC) oscillators at runtime,
+ * powering down whatever is left unused. Drivers that derive divisors from the
+ * clock register with PLLAddClockPrepareTask and PLLAddClockTask:
+ *      1. Prepare tasks run first, with interrupts enabled, so each driver can
+ *         finish in-flight transfers at the old clock.
+ *      2. The clock is switched and every clock task is called inside one
+ *         critical section, so no handler ever runs with divisors computed
+ *         for the wrong clock.
+ * Do not start transfers from interrupts while a switch is in progress.
  */
 
+#pragma once
+
 /** General imports. */
 #include <stdint.h>
+#include <stdbool.h>
+
+
+/** @brief PLL_CLOCK_TASK_COUNT is the maximum number of clock change tasks,
+ *         and of clock prepare tasks. */
+#define PLL_CLOCK_TASK_COUNT 8
 
+/** @brief PLLSource is the oscillator driving the system clock. */
+enum PLLSource {
+    PLL_SOURCE_PLL,     /* 400 MHz PLL driven by the 16 MHz main oscillator. */
+    PLL_SOURCE_MOSC,    /* 16 MHz main oscillator. The PLL is powered down. */
+    PLL_SOURCE_PIOSC    /* 16 MHz precision internal oscillator. The PLL and
+                           the main oscillator are powered down. */
+};
 
 /**
- * @brief PLLInit sets up the internal clock at the provided frequency.
+ * @brief PLLInit sets up the internal clock at the provided frequency. The
+ *        new frequency is recorded and every registered clock task is called.
+ *        Equivalent to PLLSetClock(PLL_SOURCE_PLL, freq).
  * 
  * @param freq Frequency to drive the TM4C.
  * @note Use the defines defined in the header file.
  */
 void PLLInit(uint32_t freq);
 
+/**
+ * @brief PLLSetClock switches the system clock at runtime. If the frequency
+ *        changes, the registered prepare tasks are called, then the clock is
+ *        switched and the clock tasks are called with interrupts disabled.
+ * 
+ * @param source The oscillator to run from.
+ * @param divisor For PLL_SOURCE_PLL, one of the BUS_ defines below. For the
+ *                bypassed oscillators, the clock divisor less one, from
+ *                0 - 63. 0 runs the oscillator undivided.
+ * @return The new system clock frequency, in Hz.
+ */
+uint32_t PLLSetClock(enum PLLSource source, uint32_t divisor);
+
+/**
+ * @brief PLLGetFrequency returns the current system clock frequency. The
+ *        clock configuration registers are decoded on the first call and
+ *        whenever PLLSetClock changes the clock, so this works whether or not
+ *        PLLInit was called. Drivers should derive their divisors from this
+ *        instead of assuming 80 MHz.
+ * 
+ * @return The system clock frequency, in Hz.
+ */
+uint32_t PLLGetFrequency(void);
+
+/**
+ * @brief PLLAddClockTask registers a function called whenever the system
+ *        clock frequency changes, so a driver can recompute its divisors.
+ *        Tasks are called in the order they were added, after the new clock
+ *        is running, with interrupts disabled.
+ * 
+ * @param clockTask Function called with the new frequency, in Hz.
+ * @param clockArgs The pointer to an array of uint32_t arguments fed into
+ *                  clockTask upon being called.
+ * @return False if PLL_CLOCK_TASK_COUNT tasks are already registered.
+ */
+bool PLLAddClockTask(void (*clockTask)(uint32_t frequency, uint32_t *args), uint32_t * clockArgs);
+
+/**
+ * @brief PLLAddClockPrepareTask registers a function called before the system
+ *        clock frequency changes, so a driver can wait for in-flight transfers
+ *        to finish at the old clock. Tasks are called in the order they were
+ *        added, with interrupts enabled.
+ * 
+ * @param prepareTask Function called with the upcoming frequency, in Hz.
+ * @param prepareArgs The pointer to an array of uint32_t arguments fed into
+ *                    prepareTask upon being called.
+ * @return False if PLL_CLOCK_TASK_COUNT tasks are already registered.
+ */
+bool PLLAddClockPrepareTask(void (*prepareTask)(uint32_t frequency, uint32_t *args), uint32_t * prepareArgs);
+
 #define BUS_80_000_MHZ      4
 #define BUS_80_MHZ          4
 #define BUS_66_667_MHZ      5
@@ -7,13 +7,17 @@
  * @copyright Copyright (c) 2021
  * @note
  * Modes. This driver will support both the TM4C's existing PWM modules as well
- * as a GPIO + Timer configuration.
+ * as a GPIO + Timer configuration. A third mode streams a buffer of match values
+ * into a timer's PWM match register with the uDMA, one value per period, to
+ * generate arbitrary pulse trains (i.e. WS2812 LED data or PWM audio) without
+ * CPU involvement.
  * Unsupported Features. This driver does not support PWM module interrupts, or
  * different priorities for Timer based PWM.
  */
 
 /** General imports. */
 #include <assert.h>
+#include <stdlib.h>
 
 /** Device Specific imports. */
 #include <lib/PWM/PWM.h>
@@ -79,9 +83,94 @@ static struct PWMSettings {
  *         the idx of the PWM and index 3 holds the boolean state of the PWM. */
 static uint32_t pwmTimerSettings[TIMER_COUNT][4] = {0};
 
+/** @brief pwmWaveformSettings hold the state of each uDMA fed timer PWM. */
+static struct PWMWaveformSettings {
+    /** @brief uDMA channel feeding the timer match register. */
+    DMA_t dma;
+
+    /** @brief Buffer currently being streamed. */
+    const uint32_t * matches;
+
+    /** @brief Number of values in the buffer. */
+    uint16_t count;
+
+    /** @brief Match value that holds the output low. */
+    uint32_t idle;
+
+    /** @brief Whether the buffer is replayed once it completes. */
+    bool isLooping;
+
+    /** @brief User function called when a non-looping buffer completes. */
+    void (*doneTask)(uint32_t *args);
+
+    /** @brief User args associated with the completion function. */
+    uint32_t * doneArgs;
+} pwmWaveformSettings[TIMER_5B + 1];
+
+/** @brief pwmWaveformArgs hold the args for the waveform timer interrupt
+ *         handler. Index 0 holds the TimerID_t. */
+static uint32_t pwmWaveformArgs[TIMER_5B + 1][1] = {0};
+
+/**
+ * @brief PWMWaveformGetMatchAddress returns the match register of a 16/32 bit
+ *        timer.
+ *
+ * @param timerID Timer to get the match register of.
+ * @return Address of GPTMTAMATCHR or GPTMTBMATCHR.
+ */
+static volatile uint32_t * PWMWaveformGetMatchAddress(TimerID_t timerID) {
+    return (volatile uint32_t *)(uintptr_t)(GPTM_BASE + 0x1000 * (uint32_t)(timerID >> 1) +
+        (((timerID % 2) == 0) ? GPTMTAMATCHR_OFFSET : GPTMTBMATCHR_OFFSET));
+}
+
+/**
+ * @brief PWMWaveformLoad arms the uDMA channel of a waveform with its buffer.
+ *
+ * @param timerID Timer associated with the waveform.
+ */
+static void PWMWaveformLoad(TimerID_t timerID) {
+    DMATransfer_t transfer = {
+        .source=pwmWaveformSettings[timerID].matches,
+        .destination=PWMWaveformGetMatchAddress(timerID),
+        .count=pwmWaveformSettings[timerID].count,
+        .size=DMA_SIZE_32,
+        .isSourceIncrementing=true,
+        .isDestinationIncrementing=false,
+        .arbitration=DMA_ARB_1,
+        .mode=DMA_MODE_BASIC
+    };
+    DMASetTransfer(pwmWaveformSettings[timerID].dma, transfer, false);
+    DMAStart(pwmWaveformSettings[timerID].dma);
+}
+
+/**
+ * @brief PWMWaveformHandler is the handler passed to the Timer interrupt
+ *        functions for WAVEFORM sources. The timer interrupt only fires when
+ *        the uDMA completes the buffer.
+ *
+ * @param args A pointer to a list of arguments. In this function, args[0]
+ *             should be the TimerID_t of the waveform.
+ */
+static void PWMWaveformHandler(uint32_t * args) {
+    TimerID_t timerID = args[0];
+    struct PWMWaveformSettings * settings = &pwmWaveformSettings[timerID];
+
+    if (!DMAAcknowledge(settings->dma)) return;
+
+    if (settings->isLooping) {
+        PWMWaveformLoad(timerID);
+    } else {
+        /* Hold the output low once the last value has been consumed. */
+        *PWMWaveformGetMatchAddress(timerID) = settings->idle;
+        if (settings->doneTask != NULL) {
+            settings->doneTask(settings->doneArgs);
+        }
+    }
+}
+
 PWM_t PWMInit(PWMConfig_t config) {
     /* Initialization asserts. */
-    assert(config.source <= PWM_SOURCE_TIMER);
+    assert(config.source <= PWM_SOURCE_WAVEFORM);
     assert(config.dutyCycle <= 100);
 
     PWM_t pwm = {
@@ -153,6 +242,72 @@ PWM_t PWMInit(PWMConfig_t config) {
 
         /* 9. Enable the PWM outputs. */
         GET_REG(PWMBase + PWM_ENABLE_OFFSET) |= 1 << pwmSettings[pwmPin].generator;
+    } else if (config.source == PWM_SOURCE_WAVEFORM) {
+        struct PWMWaveformConfig waveformConfig = config.sourceInfo.waveformSelect;
+        assert(waveformConfig.pin < PIN_COUNT);
+        assert(waveformConfig.timerID <= TIMER_5B);
+        assert(waveformConfig.period > 1);
+
+        TimerID_t timerID = waveformConfig.timerID;
+        uint32_t timerOffset = 0x1000 * (uint32_t)(timerID >> 1);
+        uint32_t idle = waveformConfig.period - 1;
+
+        pwm.sourceInfo.waveformInfo.pin = waveformConfig.pin;
+
+        /* 1. Enable the CCP pin. */
+        GPIOConfig_t pinConfig = {
+            .pin=waveformConfig.pin,
+            .pull=GPIO_TRI_STATE,
+            .isOutput=true,
+            .alternateFunction=7,
+            .isAnalog=false,
+            .drive=GPIO_DRIVE_2MA,
+            .enableSlew=false
+        };
+        GPIOInit(pinConfig);
+
+        /* 2. Set up the timer. The timer interrupt is only used to catch the
+              uDMA completion, which is routed to the timer's vector. */
+        pwmWaveformArgs[timerID][0] = timerID;
+        TimerConfig_t tConfig = {
+            .timerID=timerID,
+            .period=waveformConfig.period,
+            .isIndividual=true,
+            .prescale=0,
+            .timerTask=PWMWaveformHandler,
+            .isPeriodic=true,
+            .priority=3,
+            .timerArgs=pwmWaveformArgs[timerID]
+        };
+        pwm.sourceInfo.waveformInfo.timer = TimerInit(tConfig);
+
+        /* 3. Switch to PWM mode. Periodic, alternate mode select, capture
+              event interrupt on, match register updates on the next timeout.
+              The capture event (positive edge, at reload) requests a uDMA
+              transfer every period. The output is high from reload to match. */
+        if ((timerID % 2) == 0) {
+            GET_REG(GPTM_BASE + timerOffset + GPTMTAMR_OFFSET) = 0x0000060A;
+            GET_REG(GPTM_BASE + timerOffset + GPTMCTL_OFFSET) &= ~0x0000004C;
+            GET_REG(GPTM_BASE + timerOffset + GPTMTAMATCHR_OFFSET) = idle;
+            GET_REG(GPTM_BASE + timerOffset + GPTMIMR_OFFSET) &= ~0x0000001F;
+        } else {
+            GET_REG(GPTM_BASE + timerOffset + GPTMTBMR_OFFSET) = 0x0000060A;
+            GET_REG(GPTM_BASE + timerOffset + GPTMCTL_OFFSET) &= ~0x00004C00;
+            GET_REG(GPTM_BASE + timerOffset + GPTMTBMATCHR_OFFSET) = idle;
+            GET_REG(GPTM_BASE + timerOffset + GPTMIMR_OFFSET) &= ~0x00000F00;
+        }
+
+        /* 4. Connect the timer to its uDMA channel. */
+        DMAConfig_t dmaConfig = DMAGetTimerConfig(timerID);
+        pwm.sourceInfo.waveformInfo.dma = DMAInit(dmaConfig);
+
+        pwmWaveformSettings[timerID].dma = pwm.sourceInfo.waveformInfo.dma;
+        pwmWaveformSettings[timerID].matches = NULL;
+        pwmWaveformSettings[timerID].count = 0;
+        pwmWaveformSettings[timerID].idle = idle;
+        pwmWaveformSettings[timerID].isLooping = waveformConfig.isLooping;
+        pwmWaveformSettings[timerID].doneTask = waveformConfig.doneTask;
+        pwmWaveformSettings[timerID].doneArgs = waveformConfig.doneArgs;
     } else {
         struct PWMTimerConfig timerConfig = config.sourceInfo.timerSelect;
         assert(timerConfig.pin < PIN_COUNT);
@@ -211,7 +366,7 @@ PWM_t PWMInit(PWMConfig_t config) {
 
 void PWMStop(PWM_t pwm) {
     /* Initialization asserts. */
-    assert(pwm.source <= PWM_SOURCE_TIMER);
+    assert(pwm.source <= PWM_SOURCE_WAVEFORM);
     if (pwm.source == PWM_SOURCE_DEFAULT) {
         assert(pwm.sourceInfo.pin < PWM_COUNT);
 
@@ -226,6 +381,12 @@ void PWMStop(PWM_t pwm) {
 
         /* 1. Disable the timers. */
         GET_REG(PWMBase + PWM_CTL_OFFSET + PWM_OFFSET * generatorOffset) &= ~0x1;
+    } else if (pwm.source == PWM_SOURCE_WAVEFORM) {
+        assert(pwm.sourceInfo.waveformInfo.timer.timerID <= TIMER_5B);
+
+        /* Drop any buffer in progress, then halt the timer. */
+        DMAStop(pwm.sourceInfo.waveformInfo.dma);
+        TimerStop(pwm.sourceInfo.waveformInfo.timer);
     } else {
         assert(pwm.sourceInfo.timerInfo.timer.timerID < TIMER_COUNT);
         assert(pwm.sourceInfo.timerInfo.timer.period > 0);
@@ -238,7 +399,7 @@ void PWMStop(PWM_t pwm) {
 
 void PWMStart(PWM_t pwm) {
     /* Initialization asserts. */
-    assert(pwm.source <= PWM_SOURCE_TIMER);
+    assert(pwm.source <= PWM_SOURCE_WAVEFORM);
     if (pwm.source == PWM_SOURCE_DEFAULT) {
         assert(pwm.sourceInfo.pin < PWM_COUNT);
         
@@ -253,6 +414,11 @@ void PWMStart(PWM_t pwm) {
 
         /* 1. Enable the timers. */
         GET_REG(PWMBase + PWM_CTL_OFFSET + PWM_OFFSET * generatorOffset) |= 0x1;
+    } else if (pwm.source == PWM_SOURCE_WAVEFORM) {
+        assert(pwm.sourceInfo.waveformInfo.timer.timerID <= TIMER_5B);
+
+        /* The output idles low until a buffer is written. */
+        TimerStart(pwm.sourceInfo.waveformInfo.timer);
     } else {
         assert(pwm.sourceInfo.timerInfo.timer.timerID < TIMER_COUNT);
         assert(pwm.sourceInfo.timerInfo.timer.period > 0);
@@ -262,3 +428,57 @@ void PWMStart(PWM_t pwm) {
         TimerStart(pwm.sourceInfo.timerInfo.timer);    
     }
 }
+
+void PWMWaveformWrite(PWM_t pwm, const uint32_t * matches, uint16_t count) {
+    /* Initialization asserts. */
+    assert(pwm.source == PWM_SOURCE_WAVEFORM);
+    assert(pwm.sourceInfo.waveformInfo.timer.timerID <= TIMER_5B);
+    assert(matches != NULL);
+    assert(0 < count && count <= 1024);
+
+    TimerID_t timerID = pwm.sourceInfo.waveformInfo.timer.timerID;
+
+    /* 1. Cancel any buffer in progress. */
+    DMAStop(pwm.sourceInfo.waveformInfo.dma);
+    DMAAcknowledge(pwm.sourceInfo.waveformInfo.dma);
+
+    /* 2. Arm the channel. The next period request starts the stream. */
+    pwmWaveformSettings[timerID].matches = matches;
+    pwmWaveformSettings[timerID].count = count;
+    PWMWaveformLoad(timerID);
+}
+
+bool PWMWaveformIsBusy(PWM_t pwm) {
+    /* Initialization asserts. */
+    assert(pwm.source == PWM_SOURCE_WAVEFORM);
+
+    return DMAIsActive(pwm.sourceInfo.waveformInfo.dma);
+}
+
+uint32_t PWMWaveformMatch(uint16_t period, uint16_t highCycles) {
+    /* Initialization asserts. */
+    assert(highCycles < period);
+
+    /* The counter reloads at period - 1 with the output high and drives it
+       low once it counts down to the match value. */
+    return (uint32_t)(period - 1 - highCycles);
+}
+
+void PWMWaveformEncodeWS2812(uint16_t period, const uint8_t * bytes, uint16_t numBytes, uint32_t * matches) {
+    /* Initialization asserts. */
+    assert(bytes != NULL);
+    assert(matches != NULL);
+
+    /* A 0 bit is high for 0.4 us and a 1 bit is high for 0.8 us out of a
+       1.25 us period. */
+    uint32_t zero = PWMWaveformMatch(period, period * 8 / 25);
+    uint32_t one = PWMWaveformMatch(period, period * 16 / 25);
+
+    uint16_t i;
+    uint8_t j;
+    for (i = 0; i < numBytes; ++i) {
+        for (j = 0; j < 8; ++j) {
+            *matches++ = ((bytes[i] << j) & 0x80) ? one : zero;
+        }
+    }
+}
@@ -7,7 +7,10 @@
  * @copyright Copyright (c) 2021
  * @note
  * Modes. This driver will support both the TM4C's existing PWM modules as well
- * as a GPIO + Timer configuration.
+ * as a GPIO + Timer configuration. A third mode streams a buffer of match values
+ * into a timer's PWM match register with the uDMA, one value per period, to
+ * generate arbitrary pulse trains (i.e. WS2812 LED data or PWM audio) without
+ * CPU involvement.
  * Unsupported Features. This driver does not support PWM module interrupts, or
  * different priorities for Timer based PWM.
  */
@@ -20,6 +23,7 @@
 /** Device Specific imports. */
 #include <lib/GPIO/GPIO.h>
 #include <lib/Timer/Timer.h>
+#include <lib/DMA/DMA.h>
 
 
 /** @brief PWMPin is an enumeration that specifies one of the available PWM pins
@@ -52,7 +56,8 @@ typedef enum PWMPin {
  *         generated. */
 enum PWMSource { 
     PWM_SOURCE_DEFAULT, 
-    PWM_SOURCE_TIMER
+    PWM_SOURCE_TIMER,
+    PWM_SOURCE_WAVEFORM
 };
 
 /** @brief PWMDivisor is an enumeration that specifies the PWM unit clock
@@ -160,6 +165,61 @@ struct PWMTimerConfig {
     uint16_t prescale;
 };
 
+/** @brief PWMWaveformConfig is a struct defined by the user to specify a uDMA
+ *         fed timer PWM configuration. */
+struct PWMWaveformConfig {
+    /** 
+     * @brief Pin to output PWM with. Must be the CCP pin of the selected timer.
+     *        See Table 23-5. GPIO Pins and Alternate Functions on p. 1351 of
+     *        the TM4C Datasheet. I.e. PIN_B6 for TIMER_0A.
+     * 
+     * Default PIN_A0.
+     */
+    GPIOPin_t pin;
+
+    /**
+     * @brief The Timer module to enable. Must be a 16/32 bit timer, from
+     *        TIMER_0A to TIMER_5B. The timer runs as an individual 16 bit
+     *        timer.
+     *
+     * Default is TIMER_0A.
+     */
+    TimerID_t timerID;
+
+    /**
+     * @brief The PWM period, in cycles. Every period consumes one match value
+     *        from the waveform buffer. I.e. 100 cycles at 80 MHz is 800 kHz.
+     *
+     * This value must be specified and be greater than one. Failing this
+     * condition will trigger an internal assert in debug mode.
+     */
+    uint16_t period;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Whether the buffer is replayed from the start once it completes.
+     *
+     * Default is false (The output idles low after the buffer completes).
+     */
+    bool isLooping;
+
+    /**
+     * @brief Pointer to function called when a non-looping buffer completes.
+     *
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     *
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+};
+
 /** @brief PWMConfig_t is a user defined struct that specifies a PWM pin
  *         configuration. */
 typedef struct PWMConfig {
@@ -186,12 +246,22 @@ typedef struct PWMConfig {
          * prescaling. 
          */
         struct PWMTimerConfig timerSelect;
+
+        /**
+         * @brief Struct configuration used with a WAVEFORM source.
+         *
+         * Default PIN_A0, TIMER_0A, non-looping, with no done task.
+         */
+        struct PWMWaveformConfig waveformSelect;
     } sourceInfo;
 
     /**
      * @brief Percentage of the PWM that is on. This is a value from [0, 100].
      * 
      * Default value is 0, but the recommended value is 50 for most applications.
+     * 
+     * @note Unused by WAVEFORM sources. Each period's duty cycle is taken from
+     *       the waveform buffer instead.
      */
     uint8_t dutyCycle;
 } PWMConfig_t;
@@ -213,6 +283,18 @@ typedef struct PWM {
             /** @brief The pin acting as a PWM associated with the timer. */
             GPIOPin_t pin;
         } timerInfo;
+
+        /** @brief Timer and uDMA info generated for this PWM. */
+        struct {
+            /** @brief The user relevant data of the timer being used. */
+            Timer_t timer;
+
+            /** @brief The CCP pin driven by the timer. */
+            GPIOPin_t pin;
+
+            /** @brief The uDMA channel feeding the timer match register. */
+            DMA_t dma;
+        } waveformInfo;
     } sourceInfo;
 } PWM_t;
 
@@ -246,3 +328,51 @@ void PWMStop(PWM_t pwm);
  * @param pwm The PWM instance that should be updated and restarted.
  */
 void PWMStart(PWM_t pwm);
+
+/**
+ * @brief PWMWaveformWrite streams a buffer of match values into a WAVEFORM
+ *        PWM, one value per period, starting on the period after the next.
+ *        The PWM must be started with PWMStart for the buffer to be consumed.
+ * 
+ * @param pwm The WAVEFORM PWM instance to write to.
+ * @param matches Buffer of match values, built with PWMWaveformMatch or
+ *                PWMWaveformEncodeWS2812. Must remain valid until the transfer
+ *                completes (or indefinitely, when looping).
+ * @param count The number of values in the buffer. From 1 - 1024.
+ * @note A write replaces any buffer in progress.
+ */
+void PWMWaveformWrite(PWM_t pwm, const uint32_t * matches, uint16_t count);
+
+/**
+ * @brief PWMWaveformIsBusy returns whether a WAVEFORM PWM is still streaming
+ *        a non-looping buffer.
+ * 
+ * @param pwm The WAVEFORM PWM instance to check.
+ * @return True if the buffer has not yet completed.
+ */
+bool PWMWaveformIsBusy(PWM_t pwm);
+
+/**
+ * @brief PWMWaveformMatch converts a high time into the match value for a
+ *        WAVEFORM PWM.
+ * 
+ * @param period The PWM period, in cycles. Must match the configured period.
+ * @param highCycles Cycles the output is high for the period. From 0 (always
+ *                   low) to period - 1.
+ * @return The match value to place in a waveform buffer.
+ */
+uint32_t PWMWaveformMatch(uint16_t period, uint16_t highCycles);
+
+/**
+ * @brief PWMWaveformEncodeWS2812 converts a byte stream into WS2812 bit
+ *        timings, most significant bit first. Each byte expands into eight
+ *        match values. The period should be 1.25 us (100 cycles at 80 MHz).
+ * 
+ * @param period The PWM period, in cycles. Must match the configured period.
+ * @param bytes Bytes to send. Each LED takes three bytes in G, R, B order.
+ * @param numBytes The number of bytes to send.
+ * @param matches Output buffer. Must hold numBytes * 8 values.
+ * @note The line idles low after the buffer completes, which latches the data
+ *       after 50 us.
+ */
+void PWMWaveformEncodeWS2812(uint16_t period, const uint8_t * bytes, uint16_t numBytes, uint32_t * matches);
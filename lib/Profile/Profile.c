@@ -0,0 +1,149 @@
+/**
+ * @file Profile.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Interrupt latency and duration profiler.
+ * @version 0.1
+ * @date 2022-03-10
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <assert.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/Common/Common.h>
+#include <lib/Profile/Profile.h>
+
+#ifdef __PROFILE__
+
+uint32_t StartCritical(void);       // Defined in startup.s
+void EndCritical(uint32_t sr);      // Defined in startup.s
+
+/** @brief ProfileNames is the name of each slot. */
+static const char * ProfileNames[PROFILE_SLOT_COUNT] = {
+    "TIMER_0A", "TIMER_0B", "TIMER_1A", "TIMER_1B", "TIMER_2A", "TIMER_2B",
+    "TIMER_3A", "TIMER_3B", "TIMER_4A", "TIMER_4B", "TIMER_5A", "TIMER_5B",
+    "WTIMER_0A", "WTIMER_0B", "WTIMER_1A", "WTIMER_1B", "WTIMER_2A", "WTIMER_2B",
+    "WTIMER_3A", "WTIMER_3B", "WTIMER_4A", "WTIMER_4B", "WTIMER_5A", "WTIMER_5B",
+    "SYSTICK",
+    "GPIO_A", "GPIO_B", "GPIO_C", "GPIO_D", "GPIO_E", "GPIO_F"
+};
+
+/** @brief ProfileTable is the statistics of each slot. Each slot is only
+ *         written by its own interrupt, which cannot preempt itself. */
+static ProfileStats_t ProfileTable[PROFILE_SLOT_COUNT];
+
+void ProfileInit(void) {
+    /* 1. Enable the cycle counter. */
+    CommonEnableCycleCounter();
+
+    /* 2. Clear the table. */
+    ProfileReset();
+}
+
+void ProfileRecord(uint8_t slot, ProfileSample_t sample, bool isOverrun) {
+    uint32_t cycles = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET) - sample.start;
+    ProfileStats_t * stats = &ProfileTable[slot];
+
+    /* 1. Counts and extremes. */
+    if (stats->count == 0 || cycles < stats->cyclesMin) stats->cyclesMin = cycles;
+    if (cycles > stats->cyclesMax) stats->cyclesMax = cycles;
+    if (sample.latency > stats->latencyMax) stats->latencyMax = sample.latency;
+    stats->cyclesTotal += cycles;
+    stats->latencyTotal += sample.latency;
+    ++stats->count;
+    if (isOverrun) ++stats->overruns;
+
+    /* 2. Histogram bin, from the position of the highest set bit. */
+    uint8_t bin = 0;
+    cycles >>= 5;
+    while (cycles > 0 && bin < PROFILE_BINS - 1) {
+        cycles >>= 1;
+        ++bin;
+    }
+    ++stats->histogram[bin];
+}
+
+void ProfileGet(uint8_t slot, ProfileStats_t * stats) {
+    /* Initialization asserts. */
+    assert(slot < PROFILE_SLOT_COUNT);
+    assert(stats != NULL);
+
+    /* The copy is not atomic, so mask the interrupt writing it. */
+    uint32_t sr = StartCritical();
+    *stats = ProfileTable[slot];
+    EndCritical(sr);
+}
+
+void ProfileReset(void) {
+    uint32_t sr = StartCritical();
+    uint8_t slot;
+    for (slot = 0; slot < PROFILE_SLOT_COUNT; ++slot) {
+        ProfileStats_t empty = { 0 };
+        ProfileTable[slot] = empty;
+    }
+    EndCritical(sr);
+}
+
+uint8_t ProfileFormat(uint8_t slot, char * line) {
+    /* Initialization asserts. */
+    assert(slot < PROFILE_SLOT_COUNT);
+    assert(line != NULL);
+
+    ProfileStats_t stats;
+    ProfileGet(slot, &stats);
+
+    /* 1. Name. */
+    uint8_t length = 0;
+    const char * name = ProfileNames[slot];
+    while (name[length] != '\0') {
+        line[length] = name[length];
+        ++length;
+    }
+
+    /* 2. Statistics. */
+    uint32_t count = (stats.count > 0) ? stats.count : 1;
+    uint32_t values[7] = {
+        stats.count,
+        stats.overruns,
+        (uint32_t)(stats.latencyTotal / count),
+        stats.latencyMax,
+        stats.cyclesMin,
+        (uint32_t)(stats.cyclesTotal / count),
+        stats.cyclesMax
+    };
+    uint8_t i;
+    for (i = 0; i < 7; ++i) {
+        line[length++] = ',';
+        length = CommonFormatNumber(line, length, PROFILE_LINE_SIZE - 3, values[i], 10, false, 0, ' ');
+    }
+
+    /* 3. Histogram. */
+    for (i = 0; i < PROFILE_BINS; ++i) {
+        line[length++] = ',';
+        length = CommonFormatNumber(line, length, PROFILE_LINE_SIZE - 3, stats.histogram[i], 10, false, 0, ' ');
+    }
+
+    line[length++] = '\r';
+    line[length++] = '\n';
+    line[length] = '\0';
+    return length;
+}
+
+uint8_t ProfileReport(UART_t uart) {
+    char line[PROFILE_LINE_SIZE];
+    UARTSend(uart, (uint8_t *)PROFILE_HEADER, sizeof(PROFILE_HEADER) - 1);
+
+    uint8_t count = 0;
+    uint8_t slot;
+    for (slot = 0; slot < PROFILE_SLOT_COUNT; ++slot) {
+        if (ProfileTable[slot].count == 0) continue;
+        UARTSend(uart, (uint8_t *)line, ProfileFormat(slot, line));
+        ++count;
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file Profile.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Interrupt latency and duration profiler.
+ * @version 0.1
+ * @date 2022-03-10
+ * @copyright Copyright (c) 2022
+ * @note
+ * Usage. Compile the drivers and the application with `-D__PROFILE__`. The
+ * timer and GPIO interrupt handlers then time each call of their user task
+ * with the DWT cycle counter and record it into a table with one slot per
+ * interrupt source. Read the table over UART from the idle loop:
+ *
+ *      ProfileInit();
+ *      ...
+ *      while (1) { ProfileReport(uart); DelayMillisec(1000); }
+ *
+ * Without __PROFILE__, the handlers are unchanged, the table does not exist,
+ * and the functions below compile to nothing.
+ *
+ * Statistics. For each slot:
+ *      - Latency is the number of timer ticks between the timeout and the
+ *        start of the dispatch, read as the reload value minus the current
+ *        count. It is only measured for periodic timers without a prescaler,
+ *        and is 0 for GPIO.
+ *      - Cycles are the duration of the dispatch, including any higher
+ *        priority interrupts that preempted it. The histogram bins them by
+ *        powers of two: bin 0 counts calls under 32 cycles, bin i counts calls
+ *        from 2^(i+4) to 2^(i+5) - 1 cycles, and the last bin counts the rest.
+ *      - Overruns count calls that ended with their own interrupt pending
+ *        again, i.e. the task took longer than the timer period.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/UART/UART.h>
+
+
+/** @brief PROFILE_TIMER_SLOTS is the number of timer slots, one per
+ *         TimerID_t. */
+#define PROFILE_TIMER_SLOTS 25
+
+/** @brief PROFILE_GPIO_SLOTS is the number of GPIO slots, one per port. */
+#define PROFILE_GPIO_SLOTS 6
+
+/** @brief PROFILE_SLOT_COUNT is the number of slots in the table. */
+#define PROFILE_SLOT_COUNT (PROFILE_TIMER_SLOTS + PROFILE_GPIO_SLOTS)
+
+/** @brief PROFILE_SLOT_TIMER is the slot of a TimerID_t. */
+#define PROFILE_SLOT_TIMER(ID) (ID)
+
+/** @brief PROFILE_SLOT_GPIO is the slot of a GPIO port, from 0 (A) - 5 (F). */
+#define PROFILE_SLOT_GPIO(port) (PROFILE_TIMER_SLOTS + (port))
+
+/** @brief PROFILE_BINS is the number of histogram bins. */
+#define PROFILE_BINS 12
+
+/** @brief PROFILE_LINE_SIZE is the maximum length of a formatted slot. */
+#define PROFILE_LINE_SIZE 240
+
+/** @brief PROFILE_HEADER is the CSV header matching ProfileFormat. */
+#define PROFILE_HEADER \
+    "irq,count,overruns,latency mean,latency max,cycles min,cycles mean," \
+    "cycles max,<32,<64,<128,<256,<512,<1K,<2K,<4K,<8K,<16K,<32K,>=32K\r\n"
+
+/** @brief ProfileSample_t is the state of a dispatch in progress. */
+typedef struct ProfileSample {
+    /** @brief The cycle counter at the start of the dispatch. */
+    uint32_t start;
+
+    /** @brief The latency measured at the start of the dispatch. */
+    uint32_t latency;
+} ProfileSample_t;
+
+/** @brief ProfileStats_t is the statistics of one slot. */
+typedef struct ProfileStats {
+    /** @brief The number of dispatches. */
+    uint32_t count;
+
+    /** @brief The number of dispatches that overran. */
+    uint32_t overruns;
+
+    /** @brief The sum and maximum of the latencies. */
+    uint64_t latencyTotal;
+    uint32_t latencyMax;
+
+    /** @brief The sum, minimum and maximum of the durations. */
+    uint64_t cyclesTotal;
+    uint32_t cyclesMin;
+    uint32_t cyclesMax;
+
+    /** @brief The duration histogram. */
+    uint32_t histogram[PROFILE_BINS];
+} ProfileStats_t;
+
+#ifdef __PROFILE__
+
+/**
+ * @brief PROFILE_BEGIN starts timing a dispatch. Declares a ProfileSample_t.
+ *
+ * @param sample The name of the sample.
+ * @param entryLatency Expression evaluating to the entry latency.
+ */
+#define PROFILE_BEGIN(sample, entryLatency) \
+    ProfileSample_t sample = { \
+        .latency=(entryLatency), \
+        .start=GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET) \
+    }
+
+/**
+ * @brief PROFILE_END records a dispatch started with PROFILE_BEGIN.
+ *
+ * @param sample The name of the sample.
+ * @param slot The slot to record into.
+ * @param isOverrun Expression evaluating to whether the dispatch overran.
+ */
+#define PROFILE_END(sample, slot, isOverrun) \
+    ProfileRecord((slot), (sample), (isOverrun))
+
+/**
+ * @brief ProfileInit clears the table and enables the DWT cycle counter.
+ */
+void ProfileInit(void);
+
+/**
+ * @brief ProfileRecord adds a dispatch to a slot. Use PROFILE_END instead.
+ *
+ * @param slot The slot to record into.
+ * @param sample The sample from PROFILE_BEGIN.
+ * @param isOverrun Whether the dispatch overran.
+ */
+void ProfileRecord(uint8_t slot, ProfileSample_t sample, bool isOverrun);
+
+/**
+ * @brief ProfileGet copies the statistics of a slot.
+ *
+ * @param slot The slot, from 0 - PROFILE_SLOT_COUNT - 1.
+ * @param stats Output for the statistics.
+ */
+void ProfileGet(uint8_t slot, ProfileStats_t * stats);
+
+/**
+ * @brief ProfileReset clears the statistics of every slot.
+ */
+void ProfileReset(void);
+
+/**
+ * @brief ProfileFormat formats a slot as a CSV line ending in "\r\n".
+ *
+ * @param slot The slot, from 0 - PROFILE_SLOT_COUNT - 1.
+ * @param line Output buffer of at least PROFILE_LINE_SIZE bytes.
+ * @return The length of the line, excluding the null terminator.
+ */
+uint8_t ProfileFormat(uint8_t slot, char * line);
+
+/**
+ * @brief ProfileReport transmits PROFILE_HEADER and each slot with at least
+ *        one dispatch over a UART. Call from the idle loop.
+ *
+ * @param uart The UART to transmit across.
+ * @return The number of slots sent.
+ */
+uint8_t ProfileReport(UART_t uart);
+
+#else
+
+/* Profiling is compiled out. The handlers skip timing entirely, and the
+   stubs below let the application call the profiler unconditionally. */
+#define PROFILE_BEGIN(sample, entryLatency)
+#define PROFILE_END(sample, slot, isOverrun)
+
+static inline void ProfileInit(void) {}
+static inline void ProfileReset(void) {}
+static inline uint8_t ProfileReport(UART_t uart) { return 0; }
+
+#endif
@@ -0,0 +1,378 @@
+/**
+ * @file RegSim.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Host register simulation backend for GET_REG.
+ * @version 0.1
+ * @date 2022-03-05
+ * @copyright Copyright (c) 2022
+ * @note See RegSim.h for usage. Host builds only.
+ */
+#define _GNU_SOURCE
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/RegSim/RegSim.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+
+/** @brief RegSimWindows are the device address ranges backed by memory. */
+static struct RegSimWindow {
+    uint32_t base;
+    uint32_t size;
+} RegSimWindows[2] = {
+    {0x40000000, 0x00100000}, // Peripherals.
+    {0xE0000000, 0x00100000}, // Private peripherals.
+};
+
+/** @brief RegSimHooks is an open addressed table of the registers with hooks. */
+static struct RegSimHook {
+    /** @brief Device address of the register. 0 is an empty slot. */
+    uint32_t address;
+
+    /** @brief Function called before the register is read. */
+    uint32_t (*readTask)(uint32_t address, uint32_t value);
+
+    /** @brief Function called after a store changes the register. */
+    void (*writeTask)(uint32_t address, uint32_t oldValue, uint32_t newValue);
+} RegSimHooks[REG_SIM_HOOK_COUNT];
+
+/** @brief RegSimPending is the last register accessed that has a write hook. */
+static struct RegSimPending {
+    struct RegSimHook * hook;
+    uint32_t value;
+} RegSimPending = { NULL, 0 };
+
+/** @brief Whether the windows have been mapped. */
+static bool isMapped = false;
+
+/** @brief The remaining FIFO entries of each ADC sample sequencer. */
+static uint8_t RegSimADCCount[2][4];
+
+/** @brief The FIFO depth of each ADC sample sequencer. */
+static const uint8_t RegSimADCDepth[4] = { 8, 4, 4, 1 };
+
+/** @brief Whether the PLL is locked, and the RIS reads left until it locks
+ *         after a power up. */
+static bool isPLLLocked = false;
+static uint8_t RegSimPLLLockReads = 0;
+
+/**
+ * @brief RegSimMap maps the device address windows as fresh, zeroed memory.
+ */
+static void RegSimMap(void) {
+    uint8_t i;
+    for (i = 0; i < 2; ++i) {
+        void * base = (void *)(uintptr_t)RegSimWindows[i].base;
+        if (isMapped) munmap(base, RegSimWindows[i].size);
+
+        void * window = mmap(
+            base,
+            RegSimWindows[i].size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE,
+            -1,
+            0
+        );
+        if (window != base) {
+            fprintf(stderr, "RegSim: unable to map 0x%08X.\n", RegSimWindows[i].base);
+            exit(EXIT_FAILURE);
+        }
+    }
+    isMapped = true;
+}
+
+/**
+ * @brief RegSimFind returns the hook slot of a register.
+ *
+ * @param address Device address of the register.
+ * @param isInsert Whether to claim an empty slot if the register has none.
+ * @return The slot, or NULL if not found.
+ */
+static struct RegSimHook * RegSimFind(uint32_t address, bool isInsert) {
+    uint32_t index = (address >> 2) * 2654435761u % REG_SIM_HOOK_COUNT;
+    uint32_t i;
+    for (i = 0; i < REG_SIM_HOOK_COUNT; ++i) {
+        struct RegSimHook * hook = &RegSimHooks[(index + i) % REG_SIM_HOOK_COUNT];
+        if (hook->address == address) return hook;
+        if (hook->address == 0) {
+            if (!isInsert) return NULL;
+            hook->address = address;
+            return hook;
+        }
+    }
+
+    fprintf(stderr, "RegSim: out of hook slots.\n");
+    exit(EXIT_FAILURE);
+}
+
+volatile int32_t * RegSimAccess(uint32_t address) {
+    RegSimFlush();
+
+    volatile int32_t * reg = (volatile int32_t *)(uintptr_t)address;
+    struct RegSimHook * hook = RegSimFind(address, false);
+    if (hook == NULL) return reg;
+
+    /* 1. Let the model update the register before it is read. */
+    if (hook->readTask != NULL) {
+        *reg = hook->readTask(address, *reg);
+    }
+
+    /* 2. Remember the value to detect a store on the next access. */
+    if (hook->writeTask != NULL) {
+        RegSimPending.hook = hook;
+        RegSimPending.value = *reg;
+    }
+    return reg;
+}
+
+void RegSimFlush(void) {
+    struct RegSimHook * hook = RegSimPending.hook;
+    if (hook == NULL) return;
+    RegSimPending.hook = NULL;
+
+    uint32_t value = RegSimPeek(hook->address);
+    if (value != RegSimPending.value) {
+        hook->writeTask(hook->address, RegSimPending.value, value);
+    }
+}
+
+void RegSimSetReadHook(uint32_t address, uint32_t (*readTask)(uint32_t address, uint32_t value)) {
+    RegSimFind(address, true)->readTask = readTask;
+}
+
+void RegSimSetWriteHook(uint32_t address, void (*writeTask)(uint32_t address, uint32_t oldValue, uint32_t newValue)) {
+    RegSimFlush();
+    RegSimFind(address, true)->writeTask = writeTask;
+}
+
+uint32_t RegSimPeek(uint32_t address) {
+    return *(volatile uint32_t *)(uintptr_t)address;
+}
+
+void RegSimPoke(uint32_t address, uint32_t value) {
+    *(volatile uint32_t *)(uintptr_t)address = value;
+}
+
+/** ------------- Peripheral Models. ------------- */
+
+/**
+ * @brief RegSimADCIdle marks every sample sequencer FIFO of an ADC empty.
+ *
+ * @param module ADC module, 0 or 1.
+ */
+static void RegSimADCIdle(uint8_t module) {
+    uint32_t moduleBase = module ? ADC1_BASE : ADC0_BASE;
+    uint8_t sequencer;
+    for (sequencer = 0; sequencer < 4; ++sequencer) {
+        RegSimADCCount[module][sequencer] = 0;
+        RegSimPoke(moduleBase + ADC_SS0 + 0x020 * sequencer + ADC_SSFSTAT, 0x100);
+    }
+}
+
+/**
+ * @brief RegSimClockGate mirrors an RCGC register into its PR register, and
+ *        sets newly clocked peripherals to their idle state.
+ */
+static void RegSimClockGate(uint32_t address, uint32_t oldValue, uint32_t newValue) {
+    RegSimPoke(address - SYSCTL_RCGCTIMER_OFFSET + SYSCTL_PRTIMER_OFFSET, newValue);
+
+    uint32_t enabled = newValue & ~oldValue;
+    uint8_t i;
+    for (i = 0; i < 8; ++i) {
+        if (!((enabled >> i) & 0x1)) continue;
+
+        if (address == SYSCTL_BASE + SYSCTL_RCGCUART_OFFSET) {
+            /* TXFE and RXFE. */
+            RegSimPoke(UART_BASE + 0x1000 * i + UART_FR_OFFSET, 0x90);
+        } else if (address == SYSCTL_BASE + SYSCTL_RCGCSSI_OFFSET) {
+            /* TNF and TFE. */
+            RegSimPoke(SSI_BASE + 0x1000 * i + SSI_SR_OFFSET, 0x3);
+        } else if (address == SYSCTL_BASE + SYSCTL_RCGCADC_OFFSET && i < 2) {
+            RegSimADCIdle(i);
+        }
+    }
+}
+
+/**
+ * @brief RegSimADCTrigger completes the triggered sample sequencers of an ADC.
+ */
+static void RegSimADCTrigger(uint32_t address, uint32_t oldValue, uint32_t newValue) {
+    uint8_t module = address >= ADC1_BASE;
+    uint32_t moduleBase = module ? ADC1_BASE : ADC0_BASE;
+
+    uint8_t sequencer;
+    for (sequencer = 0; sequencer < 4; ++sequencer) {
+        if (!((newValue >> sequencer) & 0x1)) continue;
+        RegSimADCCount[module][sequencer] = RegSimADCDepth[sequencer];
+        RegSimPoke(moduleBase + ADC_SS0 + 0x020 * sequencer + ADC_SSFSTAT, 0x000);
+        RegSimPoke(moduleBase + ADC_RIS, RegSimPeek(moduleBase + ADC_RIS) | (1 << sequencer));
+    }
+
+    /* PSSI reads as zero, so repeated triggers are seen as stores. */
+    RegSimPoke(address, 0);
+}
+
+/**
+ * @brief RegSimADCClear clears the raw interrupt status of an ADC.
+ */
+static void RegSimADCClear(uint32_t address, uint32_t oldValue, uint32_t newValue) {
+    uint32_t moduleBase = (address >= ADC1_BASE) ? ADC1_BASE : ADC0_BASE;
+    RegSimPoke(moduleBase + ADC_RIS, RegSimPeek(moduleBase + ADC_RIS) & ~newValue);
+    RegSimPoke(address, 0);
+}
+
+/**
+ * @brief RegSimADCRead consumes a sample sequencer FIFO entry.
+ */
+static uint32_t RegSimADCRead(uint32_t address, uint32_t value) {
+    uint8_t module = address >= ADC1_BASE;
+    uint32_t moduleBase = module ? ADC1_BASE : ADC0_BASE;
+    uint8_t sequencer = (address - moduleBase - ADC_SS0 - ADC_SSFIFO) / 0x020;
+
+    if (RegSimADCCount[module][sequencer] > 0 &&
+        --RegSimADCCount[module][sequencer] == 0) {
+        RegSimPoke(moduleBase + ADC_SS0 + 0x020 * sequencer + ADC_SSFSTAT, 0x100);
+    }
+    return value;
+}
+
+/**
+ * @brief RegSimI2CCommand completes an I2C master command immediately. The
+ *        addressed slave always acknowledges.
+ */
+static void RegSimI2CCommand(uint32_t address, uint32_t oldValue, uint32_t newValue) {
+    /* IDLE once a STOP has been generated, otherwise still holding the bus. */
+    RegSimPoke(address, (newValue & 0x4) ? 0x20 : 0x40);
+}
+
+/**
+ * @brief RegSimClockConfig models RCC and RCC2. Powering up the main
+ *        oscillator sets MOSCPUPRIS at once. Powering up the PLL starts its
+ *        lock; powering it down unlocks it. Running the system clock from an
+ *        unlocked PLL is a driver bug, so the simulation stops.
+ */
+static void RegSimClockConfig(uint32_t address, uint32_t oldValue, uint32_t newValue) {
+    if (address == SYSCTL_BASE + SYSCTL_RCC_OFFSET) {
+        if ((oldValue & 0x00000001) && !(newValue & 0x00000001)) {
+            RegSimPoke(SYSCTL_BASE + SYSCTL_RIS_OFFSET,
+                RegSimPeek(SYSCTL_BASE + SYSCTL_RIS_OFFSET) | 0x00000100);
+        }
+        return;
+    }
+
+    if (!(oldValue & 0x00002000) && (newValue & 0x00002000)) {
+        isPLLLocked = false;
+        RegSimPLLLockReads = 0;
+    } else if ((oldValue & 0x00002000) && !(newValue & 0x00002000)) {
+        RegSimPLLLockReads = REG_SIM_PLL_LOCK_READS;
+    }
+
+    bool isOnPLL = (newValue & 0x80000000) && !(newValue & 0x00002800);
+    if (isOnPLL && !isPLLLocked) {
+        fprintf(stderr, "RegSim: system clock switched to an unlocked PLL.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief RegSimClockStatus locks the PLL after REG_SIM_PLL_LOCK_READS reads of
+ *        RIS, setting PLLLRIS.
+ */
+static uint32_t RegSimClockStatus(uint32_t address, uint32_t value) {
+    if (RegSimPLLLockReads > 0 && --RegSimPLLLockReads == 0) {
+        isPLLLocked = true;
+        value |= 0x00000040;
+    }
+    return value;
+}
+
+/**
+ * @brief RegSimClockClear clears the RIS bits written to MISC.
+ */
+static void RegSimClockClear(uint32_t address, uint32_t oldValue, uint32_t newValue) {
+    RegSimPoke(SYSCTL_BASE + SYSCTL_RIS_OFFSET,
+        RegSimPeek(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & ~newValue);
+    RegSimPoke(address, 0);
+}
+
+/**
+ * @brief RegSimCycleCount returns host time in REG_SIM_CLOCK cycles.
+ */
+static uint32_t RegSimCycleCount(uint32_t address, uint32_t value) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+    return (uint32_t)(ns * (REG_SIM_CLOCK / 1000000) / 1000);
+}
+
+void RegSimReset(void) {
+    /* 1. Zero the register file and drop all hooks. */
+    RegSimMap();
+    memset(RegSimHooks, 0, sizeof(RegSimHooks));
+    memset(RegSimADCCount, 0, sizeof(RegSimADCCount));
+    RegSimPending.hook = NULL;
+
+    /* 2. Clock gates. */
+    uint32_t offset;
+    for (offset = SYSCTL_RCGCTIMER_OFFSET - 0x4; offset <= SYSCTL_RCGCWTIMER_OFFSET + 0x1C; offset += 0x4) {
+        RegSimSetWriteHook(SYSCTL_BASE + offset, RegSimClockGate);
+    }
+
+    /* 3. PLL lock and main oscillator power up. RCC and RCC2 start at their
+          reset values, running from the PIOSC with the main oscillator and
+          the PLL powered down. */
+    RegSimPoke(SYSCTL_BASE + SYSCTL_RCC_OFFSET, 0x078E3AD1);
+    RegSimPoke(SYSCTL_BASE + SYSCTL_RCC2_OFFSET, 0x07C06810);
+    isPLLLocked = false;
+    RegSimPLLLockReads = 0;
+    RegSimSetWriteHook(SYSCTL_BASE + SYSCTL_RCC_OFFSET, RegSimClockConfig);
+    RegSimSetWriteHook(SYSCTL_BASE + SYSCTL_RCC2_OFFSET, RegSimClockConfig);
+    RegSimSetReadHook(SYSCTL_BASE + SYSCTL_RIS_OFFSET, RegSimClockStatus);
+    RegSimSetWriteHook(SYSCTL_BASE + SYSCTL_MISC_OFFSET, RegSimClockClear);
+
+    /* 4. ADC sample sequencers. */
+    uint32_t moduleBase;
+    for (moduleBase = ADC0_BASE; moduleBase <= ADC1_BASE; moduleBase += 0x1000) {
+        RegSimSetWriteHook(moduleBase + ADC_PSSI, RegSimADCTrigger);
+        RegSimSetWriteHook(moduleBase + ADC_ISC, RegSimADCClear);
+        uint8_t sequencer;
+        for (sequencer = 0; sequencer < 4; ++sequencer) {
+            RegSimSetReadHook(moduleBase + ADC_SS0 + 0x020 * sequencer + ADC_SSFIFO, RegSimADCRead);
+        }
+    }
+
+    /* 5. I2C masters. */
+    for (moduleBase = I2C0_BASE; moduleBase <= I2C3_BASE; moduleBase += 0x1000) {
+        RegSimSetWriteHook(moduleBase + I2C_MCS_OFFSET, RegSimI2CCommand);
+    }
+
+    /* 6. Cycle counter. */
+    RegSimSetReadHook(DWT_BASE + DWT_CYCCNT_OFFSET, RegSimCycleCount);
+}
+
+/** @brief RegSimInit sets up the register file before main runs. */
+__attribute__((constructor)) static void RegSimInit(void) {
+    RegSimReset();
+}
+
+/** ------------- Host versions of the functions in startup.s. ------------- */
+
+void DisableInterrupts(void) {}
+
+void EnableInterrupts(void) {}
+
+uint32_t StartCritical(void) { return 0; }
+
+void EndCritical(uint32_t sr) {}
+
+void WaitForInterrupt(void) {}
@@ -0,0 +1,125 @@
+/**
+ * @file RegSim.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Host register simulation backend for GET_REG.
+ * @version 0.1
+ * @date 2022-03-05
+ * @copyright Copyright (c) 2022
+ * @note
+ * Usage. Defining __HOST__ (i.e. `-D__HOST__`) routes GET_REG in
+ * inc/RegDefs.h through RegSimAccess, so the drivers in lib/ compile unchanged
+ * into a Linux binary:
+ *
+ *      gcc -std=c99 -D__HOST__ -I. <driver .c files> lib/RegSim/RegSim.c \
+ *          <test .c files>
+ *
+ * FaultHandler.c and the startup files are device only and should be left
+ * out; RegSim.c provides host versions of the functions in startup.s.
+ *
+ * Register File. The peripheral (0x4000.0000 - 0x400F.FFFF) and private
+ * peripheral (0xE000.0000 - 0xE00F.FFFF) windows are mapped at their device
+ * addresses as lazily allocated memory, so only touched pages take up space.
+ * Drivers that cache register addresses as pointers work as well, but bypass
+ * the hooks below.
+ *
+ * Hooks. Each register may have a read hook, called before GET_REG reads it,
+ * and a write hook, called once a GET_REG store changes its value. Since
+ * GET_REG is an lvalue, stores are detected lazily: the write hook of a
+ * register runs at the start of the next GET_REG access, or on RegSimFlush.
+ *
+ * Models. RegSimReset installs peripheral models for the registers the
+ * drivers spin on:
+ *      - RCGC* clock gates are mirrored into the PR* peripheral ready bits.
+ *        Enabling a UART or SSI sets its FR or SR to the idle, FIFO empty
+ *        state. Enabling an ADC marks its sample sequencer FIFOs empty.
+ *      - Powering up the main oscillator sets MOSCPUPRIS. Powering up the PLL
+ *        sets PLLLRIS after REG_SIM_PLL_LOCK_READS reads of RIS. Both are
+ *        sticky until 1 is written to MISC. Running the system clock from
+ *        the PLL before it locks stops the simulation with an error.
+ *      - A PSSI write completes the triggered sample sequencers immediately.
+ *        Each sequencer returns its SSFIFO value until the FIFO depth is read.
+ *        Use RegSimPoke on SSFIFO to set the value sampled.
+ *      - I2C master commands complete immediately and are acknowledged.
+ *      - DWT CYCCNT counts at REG_SIM_CLOCK Hz of host time.
+ *
+ * Unsupported Features. Bit-band aliases, GPIODATA address masking (each
+ * masked address is its own register), interrupts, and the uDMA are not
+ * modeled.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/** @brief REG_SIM_HOOK_COUNT is the maximum number of registers with hooks. */
+#define REG_SIM_HOOK_COUNT 256
+
+/** @brief REG_SIM_CLOCK is the frequency DWT CYCCNT counts at, in Hz. */
+#define REG_SIM_CLOCK 80000000
+
+/** @brief REG_SIM_PLL_LOCK_READS is the number of RIS reads the PLL takes to
+ *         lock after a power up. */
+#define REG_SIM_PLL_LOCK_READS 4
+
+/**
+ * @brief RegSimAccess returns the simulated register at an address, running
+ *        any pending write hook and the register's read hook first. Used by
+ *        GET_REG on host builds.
+ *
+ * @param address Device address of the register.
+ * @return Pointer to the register.
+ */
+volatile int32_t * RegSimAccess(uint32_t address);
+
+/**
+ * @brief RegSimFlush runs the write hook of the last register accessed, if a
+ *        store changed its value. Call before checking the result of a store
+ *        that is not followed by another GET_REG access.
+ */
+void RegSimFlush(void);
+
+/**
+ * @brief RegSimReset zeroes every touched register, removes all hooks, and
+ *        reinstalls the default peripheral models. Called automatically
+ *        before main.
+ */
+void RegSimReset(void);
+
+/**
+ * @brief RegSimSetReadHook sets the function called before a register is read
+ *        through GET_REG. The returned value is stored to the register and
+ *        read by the driver.
+ *
+ * @param address Device address of the register.
+ * @param readTask Function called with the address and the current value.
+ *                 NULL removes the hook.
+ */
+void RegSimSetReadHook(uint32_t address, uint32_t (*readTask)(uint32_t address, uint32_t value));
+
+/**
+ * @brief RegSimSetWriteHook sets the function called after a store through
+ *        GET_REG changes a register.
+ *
+ * @param address Device address of the register.
+ * @param writeTask Function called with the address, the value before the
+ *                  store, and the value after. NULL removes the hook.
+ */
+void RegSimSetWriteHook(uint32_t address, void (*writeTask)(uint32_t address, uint32_t oldValue, uint32_t newValue));
+
+/**
+ * @brief RegSimPeek reads a register without running any hooks.
+ *
+ * @param address Device address of the register.
+ * @return The register value.
+ */
+uint32_t RegSimPeek(uint32_t address);
+
+/**
+ * @brief RegSimPoke writes a register without running any hooks.
+ *
+ * @param address Device address of the register.
+ * @param value The value to write.
+ */
+void RegSimPoke(uint32_t address, uint32_t value);
@@ -6,17 +6,305 @@
  * @date 2021-09-23
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support DMA control. This driver
- * does not support interrupts.
+ * DMA. When isDMA is set at initialization, SPITransferAsync and
+ * SPITransmitGather hand transfers to the uDMA and return immediately. One
+ * transfer may be queued behind the active one, so the application can render
+ * frame N+1 while frame N streams out. The queued transfer starts from the
+ * completion interrupt.
+ *
+ * Interrupts. SPITransferInterrupt services the FIFOs from the SSI interrupt
+ * at the half full (RX), half empty (TX) and receive timeout levels. It shares
+ * the transfer queue with the uDMA transfers.
+ *
+ * Shared Buses. Several devices can share one SSI module, each with its own
+ * GPIO chip select and frame settings. Initialize the module once with
+ * isManualChipSelect, then describe each device with SPIDeviceInit. The
+ * device's CR0 and CPSR values are cached and only written when the bus
+ * switches to a device with different settings. After a system clock change,
+ * the settings of each device are rescaled once and cached with the module.
+ * SPIDeviceSubmit queues transactions from the main loop or from interrupts
+ * and runs them in order.
  */
 
 /** General imports. */
 #include <assert.h>
+#include <stdlib.h>
 
 /** Device specific imports. */
 #include <inc/RegDefs.h>
 #include <lib/SSI/SSI.h>
 #include <lib/GPIO/GPIO.h>
+#include <lib/PLL/PLL.h>
+
+
+uint32_t StartCritical(void);    // Defined in startup.s
+void EndCritical(uint32_t sr);   // Defined in startup.s
+
+/**
+ * @brief This field is either 0, 1, 2, 3, specifying the byte that the
+ *        interrupt of priority X should be set to.
+ */
+enum InterruptPriorityIdx {INTA, INTB, INTC, INTD};
+
+/** @brief SPIJob is a single asynchronous transfer. */
+struct SPIJob {
+    /** @brief Frames to transmit, or NULL. Unused for scatter-gather. */
+    const void * tx;
+
+    /** @brief Buffer to receive into, or NULL. */
+    void * rx;
+
+    /** @brief The number of frames. Unused for scatter-gather. */
+    size_t count;
+
+    /** @brief Whether the FIFOs are serviced by the SSI interrupt instead of
+     *         the uDMA. */
+    bool isInterrupt;
+
+    /** @brief Per transfer completion function. Overrides doneTask of the
+     *         module when defined. */
+    void (*doneTask)(uint32_t *args);
+
+    /** @brief User args associated with the completion function. */
+    uint32_t * doneArgs;
+
+    /** @brief Segments to transmit, or NULL for a plain transfer. */
+    const SPISegment_t * segments;
+
+    /** @brief The number of segments. */
+    uint8_t numSegments;
+};
+
+/** @brief SSIDeviceScale is the settings of a device rescaled to the current
+ *         system clock. */
+struct SSIDeviceScale {
+    /** @brief SSICR0 value of the device, from SPIDeviceInit. */
+    uint16_t deviceCr0;
+
+    /** @brief SSICPSR value of the device, from SPIDeviceInit. */
+    uint8_t deviceCpsr;
+
+    /** @brief The system clock frequency the device values were computed for. */
+    uint32_t deviceClock;
+
+    /** @brief Rescaled SSICR0 value. */
+    uint16_t cr0;
+
+    /** @brief Rescaled SSICPSR value. */
+    uint8_t cpsr;
+};
+
+/** @brief SSIInterruptSettings is a set of SSI configurations. */
+static struct SSIInterruptSettings {
+    /** @brief Priority index of the SSI. */
+    enum InterruptPriorityIdx priorityIdx;
+
+    /** @brief Address of the relevant priority register. */
+    volatile uint32_t * NVIC_PRI_ADDR;
+
+    /** @brief Address of the relevant set enable register. */
+    volatile uint32_t * NVIC_EN_ADDR;
+
+    /** @brief Relevant IRQ number of the interrupt. */
+    uint32_t IRQ;
+
+    /** @brief uDMA channel of the receive FIFO. */
+    enum DMAChannel rxChannel;
+
+    /** @brief uDMA channel of the transmit FIFO. */
+    enum DMAChannel txChannel;
+
+    /** @brief uDMA channel encoding of the SSI. */
+    uint8_t assignment;
+
+    /** @brief User function associated with transfer completion. */
+    void (*doneTask)(uint32_t *args);
+
+    /** @brief User args associated with the completion function. */
+    uint32_t * doneArgs;
+
+    /** @brief The transfer running on the uDMA. */
+    struct SPIJob active;
+
+    /** @brief The transfer waiting for the active transfer to complete. */
+    struct SPIJob pending;
+
+    /** @brief Whether active holds a running transfer. */
+    volatile bool isActive;
+
+    /** @brief Whether pending holds a queued transfer. */
+    volatile bool isPending;
+
+    /** @brief Scatter-gather tasks of the active transfer. */
+    DMAControl_t tasks[SPI_MAX_SEGMENTS];
+
+    /** @brief Frames written by an interrupt mode transfer. */
+    size_t txCount;
+
+    /** @brief Frames read by an interrupt mode transfer. */
+    size_t rxCount;
+
+    /** @brief Whether an interrupt mode transfer uses 16 bit elements. */
+    bool isWide;
+
+    /** @brief Whether the FIFOs are connected to the uDMA. */
+    bool isDMA;
+
+    /** @brief SSICR0 value currently applied to the module. */
+    uint16_t cr0;
+
+    /** @brief SSICPSR value currently applied to the module. */
+    uint8_t cpsr;
+
+    /** @brief SSICR0 value set by SSIInit. */
+    uint16_t configCr0;
+
+    /** @brief SSICPSR value set by SSIInit. */
+    uint8_t configCpsr;
+
+    /** @brief The system clock frequency configCr0 and configCpsr were set
+     *         for. 0 if the module is not initialized. */
+    uint32_t configClock;
+
+    /** @brief Device transactions waiting for the bus. */
+    SPITransaction_t queue[SPI_QUEUE_SIZE];
+
+    /** @brief Index of the oldest waiting transaction. */
+    uint8_t queueHead;
+
+    /** @brief Number of waiting transactions. */
+    volatile uint8_t queueCount;
+
+    /** @brief Whether a device transaction owns the bus. */
+    volatile bool isBusActive;
+
+    /** @brief Whether the finished device transaction waits for its last
+     *         frames to shift out before releasing chip select. */
+    volatile bool isBusDraining;
+
+    /** @brief The transaction that owns the bus. */
+    SPITransaction_t current;
+
+    /** @brief Device settings rescaled to scaledClock. */
+    struct SSIDeviceScale scaled[SPI_DEVICE_CACHE_SIZE];
+
+    /** @brief The number of valid entries in scaled. */
+    uint8_t numScaled;
+
+    /** @brief The entry of scaled replaced next once it is full. */
+    uint8_t nextScaled;
+
+    /** @brief The system clock frequency the entries of scaled are for. */
+    uint32_t scaledClock;
+} SSIInterruptSettings[4] = {
+    {INTD, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI1_OFFSET),  (uint32_t *)(PERIPHERALS_BASE + NVIC_EN0_OFFSET), 7,     DMA10, DMA11, 0}, /* SSI0. */
+    {INTC, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI8_OFFSET),  (uint32_t *)(PERIPHERALS_BASE + NVIC_EN1_OFFSET), 34-32, DMA24, DMA25, 0}, /* SSI1. */
+    {INTB, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI14_OFFSET), (uint32_t *)(PERIPHERALS_BASE + NVIC_EN1_OFFSET), 57-32, DMA12, DMA13, 2}, /* SSI2. */
+    {INTC, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI14_OFFSET), (uint32_t *)(PERIPHERALS_BASE + NVIC_EN1_OFFSET), 58-32, DMA14, DMA15, 2}, /* SSI3. */
+};
+
+/** @brief SSI_FIFO_DEPTH is the number of frames held by each SSI FIFO. */
+#define SSI_FIFO_DEPTH 8
+
+/** @brief ssiDummy is the source of SPI_DUMMY frames for RX only transfers. */
+static const uint16_t ssiDummy = SPI_DUMMY;
+
+uint32_t SSIGetDivisors(uint32_t systemClock, uint32_t bitRate, uint8_t * prescaler, uint8_t * clockModifier) {
+    /* Initialization asserts. */
+    assert(bitRate > 0);
+    assert(prescaler != NULL && clockModifier != NULL);
+
+    /* 1. The smallest divisor that does not exceed the requested rate. */
+    uint32_t target = (systemClock + bitRate - 1) / bitRate;
+
+    /* 2. Search the even prescalers for the divisor closest to the target,
+          which is CPSDVSR * (1 + SCR). Starts from the slowest rate. */
+    uint32_t bestDivisor = 254 * 256;
+    *prescaler = 254;
+    *clockModifier = 255;
+    uint32_t cpsr;
+    for (cpsr = 2; cpsr <= 254; cpsr += 2) {
+        uint32_t scr = (target + cpsr - 1) / cpsr;
+        if (scr > 0) --scr;
+        if (scr > 255) continue;
+
+        uint32_t divisor = cpsr * (1 + scr);
+        if (divisor < bestDivisor) {
+            bestDivisor = divisor;
+            *prescaler = cpsr;
+            *clockModifier = scr;
+            if (divisor == target) break;
+        }
+    }
+    return systemClock / bestDivisor;
+}
+
+/**
+ * @brief SSIScaleDivisors rescales CR0 and CPSR values computed at one system
+ *        clock so the bit rate is kept, without exceeding it, at another.
+ *
+ * @param fromClock The system clock the values were computed for, in Hz.
+ * @param toClock The system clock to compute the values for, in Hz.
+ * @param cr0 The SSICR0 value. The SCR field is replaced.
+ * @param cpsr The SSICPSR value. Replaced.
+ */
+static void SSIScaleDivisors(uint32_t fromClock, uint32_t toClock, uint16_t * cr0, uint8_t * cpsr) {
+    uint32_t bitRate = fromClock / (*cpsr * (1 + (*cr0 >> 8)));
+    if (bitRate == 0) bitRate = 1;
+
+    uint8_t clockModifier;
+    SSIGetDivisors(toClock, bitRate, cpsr, &clockModifier);
+    *cr0 = (*cr0 & 0x00FF) | (clockModifier << 8);
+}
+
+/**
+ * @brief SSIPrepareClock lets the transfers of every initialized module
+ *        finish before the system clock changes.
+ *
+ * @param frequency The upcoming system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void SSIPrepareClock(uint32_t frequency, uint32_t * args) {
+    uint8_t ssi;
+    for (ssi = 0; ssi < 4; ++ssi) {
+        struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+        if (settings->configClock == 0) continue;
+
+        while (settings->isActive || settings->isBusActive || settings->queueCount > 0 ||
+            (GET_REG(SSI_BASE + 0x1000 * ssi + SSI_SR_OFFSET) & 0x10)) {}
+    }
+}
+
+/**
+ * @brief SSIUpdateClock rescales the bit rate divisors of every initialized
+ *        module when the system clock changes.
+ *
+ * @param frequency The new system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void SSIUpdateClock(uint32_t frequency, uint32_t * args) {
+    uint8_t ssi;
+    for (ssi = 0; ssi < 4; ++ssi) {
+        struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+        if (settings->configClock == 0) continue;
+
+        /* Rescale from the SSIInit values so repeated switches do not drift.
+           Devices are rescaled the first time they are next selected. */
+        settings->cr0 = settings->configCr0;
+        settings->cpsr = settings->configCpsr;
+        SSIScaleDivisors(settings->configClock, frequency, &settings->cr0, &settings->cpsr);
+
+        /* The module must be disabled while CR0 and CPSR are written. */
+        uint32_t SSIOffset = 0x1000 * ssi;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) &= ~0x00000002;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CPSR_OFFSET) = settings->cpsr;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) = settings->cr0;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) |= 0x00000002;
+    }
+}
+
+/** @brief Whether the SSI clock tasks have been registered with the PLL. */
+static bool isSSIClockTaskAdded = false;
 
 SSIModule_t SSIInit(SSIConfig_t config) {
     /* Initialization asserts. */
@@ -25,6 +313,7 @@ SSIModule_t SSIInit(SSIConfig_t config) {
     assert(0 < config.ssiPrescaler && !(config.ssiPrescaler & 0x1));
     assert(config.frameFormat <= MICROWIRE);
     assert(config.polarity <= SSI_SECOND_EDGE);
+    assert(config.priority <= 7);
 
     /* 1. Enable the SSI module clock and stall until ready. */
     GET_REG(SYSCTL_BASE + SYSCTL_RCGCSSI_OFFSET) |= (1 << (config.ssi%4));
@@ -71,7 +360,7 @@ SSIModule_t SSIInit(SSIConfig_t config) {
             break;
     }
     GPIOInit(configs[0]);
-    GPIOInit(configs[1]);
+    if (!config.isManualChipSelect) GPIOInit(configs[1]);
 
     /* Note Initialize the RX or TX pin depending on whether we're transmitting or not.
        If you think that you can keep both pins initialized, well, have fun for the
@@ -96,22 +385,75 @@ SSIModule_t SSIInit(SSIConfig_t config) {
     /* 6. Configure SSI clock source. */
     GET_REG(SSI_BASE + SSIOffset + SSI_CC_OFFSET) = 0x00000000;
 
-    /* 7. Configure clock prescale divisor. By default, 10MHz with an 80MHz
-       SysClk. */
+    /* 7. Configure clock prescale divisor. The bit rate is
+          SysClk / (CPSDVSR * (1 + SCR)); see SSIGetDivisors. */
     GET_REG(SSI_BASE + SSIOffset + SSI_CPSR_OFFSET) = config.ssiPrescaler;
 
     /* 8. Set clock phase, clock polarity, frame format, and data size. */
-    GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) &= ~(0x0000FFFF);
-    GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) |=
+    uint16_t cr0 =
         (config.ssiClockModifier << 8) |
         (config.polarity << 7) |
         (!config.isClockLow << 6) |
         (config.frameFormat << 4) |
         config.dataSize;
+    GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) &= ~(0x0000FFFF);
+    GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) |= cr0;
 
     /* 9. Re-enable SSI operation. */
     GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) |= 0x00000002;
 
+    /* 10. Set up asynchronous transfers. FIFO interrupts are only unmasked
+           while an interrupt mode transfer runs. */
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[config.ssi%4];
+    settings->doneTask = config.doneTask;
+    settings->doneArgs = config.doneArgs;
+    settings->isActive = false;
+    settings->isPending = false;
+    settings->isDMA = config.isDMA;
+    settings->cr0 = cr0;
+    settings->cpsr = config.ssiPrescaler;
+    settings->configCr0 = cr0;
+    settings->configCpsr = config.ssiPrescaler;
+    settings->configClock = PLLGetFrequency();
+    settings->queueHead = 0;
+    settings->queueCount = 0;
+    settings->isBusActive = false;
+    settings->isBusDraining = false;
+    settings->numScaled = 0;
+    settings->nextScaled = 0;
+    if (!isSSIClockTaskAdded) {
+        isSSIClockTaskAdded = PLLAddClockPrepareTask(SSIPrepareClock, NULL) &&
+            PLLAddClockTask(SSIUpdateClock, NULL);
+    }
+    GET_REG(SSI_BASE + SSIOffset + SSI_IM_OFFSET) = 0x0;
+
+    uint32_t mask = 0xFFFFFFFF;
+    uint32_t intVal = config.priority << 5;
+    mask &= ~(0xFF << (settings->priorityIdx * 8));
+    intVal = intVal << (settings->priorityIdx * 8);
+    (*settings->NVIC_PRI_ADDR) = ((*settings->NVIC_PRI_ADDR)&mask)|intVal;
+    (*settings->NVIC_EN_ADDR) = 1 << settings->IRQ;
+
+    /* 11. Connect the FIFOs to the uDMA. Completion interrupts arrive on the
+           SSI vector. */
+    if (config.isDMA) {
+        /* The receive channel is arbitrated first so the RX FIFO never
+           overruns during full duplex transfers. */
+        DMAConfig_t dmaConfig = {
+            .channel=settings->rxChannel,
+            .assignment=settings->assignment,
+            .isHighPriority=true,
+            .isOnlyBurst=false,
+            .doneTask=NULL,
+            .doneArgs=NULL,
+            .priority=0
+        };
+        DMAInit(dmaConfig);
+        dmaConfig.channel = settings->txChannel;
+        dmaConfig.isHighPriority = false;
+        DMAInit(dmaConfig);
+    }
+
     return config.ssi;
 }
 
@@ -140,3 +482,649 @@ void SPIWrite(SSIModule_t ssi, uint16_t data) {
     while (!(GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET) & 0x2)) {}
     GET_REG(SSI_BASE + SSIOffset + SSI_DR_OFFSET) = data;
 }
+
+void SPITransfer(SSIModule_t ssi, const void * tx, void * rx, size_t n) {
+    /* Initialization asserts. */
+    assert(ssi != 4 && ssi <= SSI1_PD);
+
+    /* We'll generate the SSI offset to find the correct addresses for each
+       SSI module. */
+    uint32_t SSIOffset = 0x1000 * (ssi%4);
+    volatile int32_t * SR = &GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET);
+    volatile int32_t * DR = &GET_REG(SSI_BASE + SSIOffset + SSI_DR_OFFSET);
+
+    /* 1. Frames wider than a byte use 16 bit elements. */
+    bool isWide = (GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) & 0xF) > SSI_SIZE_8;
+    const uint8_t * tx8 = tx;
+    const uint16_t * tx16 = tx;
+    uint8_t * rx8 = rx;
+    uint16_t * rx16 = rx;
+
+    /* 2. Flush stale frames out of the receive FIFO. */
+    while (*SR & 0x4) { (void)*DR; }
+
+    if (rx == NULL) {
+        /* 3a. TX only. Keep the transmit FIFO full and let the receive FIFO
+               overrun; nothing is read until the bus goes idle. */
+        size_t i;
+        for (i = 0; i < n; ++i) {
+            while (!(*SR & 0x2)) {}
+            *DR = tx == NULL ? SPI_DUMMY : (isWide ? tx16[i] : tx8[i]);
+        }
+
+        /* Wait until the last frame is shifted out, then flush. */
+        while (*SR & 0x10) {}
+        while (*SR & 0x4) { (void)*DR; }
+        return;
+    }
+
+    /* 3b. Full duplex. Never have more frames in flight than the receive FIFO
+           can hold, so no received frame is dropped. */
+    size_t txCount = 0;
+    size_t rxCount = 0;
+    while (rxCount < n) {
+        while (txCount < n && (txCount - rxCount) < SSI_FIFO_DEPTH && (*SR & 0x2)) {
+            *DR = tx == NULL ? SPI_DUMMY : (isWide ? tx16[txCount] : tx8[txCount]);
+            ++txCount;
+        }
+        while (*SR & 0x4) {
+            if (isWide) rx16[rxCount] = *DR & 0xFFFF;
+            else        rx8[rxCount] = *DR & 0xFF;
+            ++rxCount;
+        }
+    }
+}
+
+void SPITransmit(SSIModule_t ssi, const void * tx, size_t n) {
+    SPITransfer(ssi, tx, NULL, n);
+}
+
+void SPIReceive(SSIModule_t ssi, void * rx, size_t n) {
+    SPITransfer(ssi, NULL, rx, n);
+}
+
+static void SPIStartJob(SSIModule_t ssi, struct SPIJob job);
+
+/**
+ * @brief SPIFinishJob retires the active transfer, starts the queued one, and
+ *        calls the completion function.
+ *
+ * @param ssi SSI module (0 - 3) whose transfer completed.
+ */
+static void SPIFinishJob(uint8_t ssi) {
+    uint32_t SSIOffset = 0x1000 * ssi;
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+
+    void (*doneTask)(uint32_t *args) = settings->active.doneTask;
+    uint32_t * doneArgs = settings->active.doneArgs;
+    if (doneTask == NULL) {
+        doneTask = settings->doneTask;
+        doneArgs = settings->doneArgs;
+    }
+
+    /* 1. Release the FIFOs. */
+    GET_REG(SSI_BASE + SSIOffset + SSI_DMACTL_OFFSET) = 0x0;
+    GET_REG(SSI_BASE + SSIOffset + SSI_IM_OFFSET) = 0x0;
+    settings->isActive = false;
+
+    /* 2. Start the queued transfer. */
+    if (settings->isPending) {
+        settings->isPending = false;
+        SPIStartJob(ssi, settings->pending);
+    }
+
+    if (doneTask != NULL) {
+        doneTask(doneArgs);
+    }
+}
+
+/**
+ * @brief SPIServiceFIFOs moves frames for an interrupt mode transfer. The
+ *        receive FIFO is drained first, then the transmit FIFO is filled
+ *        without letting more frames be in flight than the receive FIFO can
+ *        hold.
+ *
+ * @param ssi SSI module (0 - 3) to service.
+ */
+static void SPIServiceFIFOs(uint8_t ssi) {
+    uint32_t SSIOffset = 0x1000 * ssi;
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+    struct SPIJob * job = &settings->active;
+    volatile int32_t * SR = &GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET);
+    volatile int32_t * DR = &GET_REG(SSI_BASE + SSIOffset + SSI_DR_OFFSET);
+    const uint8_t * tx8 = job->tx;
+    const uint16_t * tx16 = job->tx;
+    uint8_t * rx8 = job->rx;
+    uint16_t * rx16 = job->rx;
+
+    /* 1. Drain the receive FIFO. Frames are discarded when there is no
+          receive buffer. */
+    while (*SR & 0x4) {
+        uint16_t data = *DR & 0xFFFF;
+        if (rx8 != NULL) {
+            if (settings->isWide) rx16[settings->rxCount] = data;
+            else                  rx8[settings->rxCount] = data;
+        }
+        ++settings->rxCount;
+    }
+
+    /* 2. Refill the transmit FIFO. */
+    while (settings->txCount < job->count &&
+           (settings->txCount - settings->rxCount) < SSI_FIFO_DEPTH &&
+           (*SR & 0x2)) {
+        *DR = tx8 == NULL ? SPI_DUMMY :
+            (settings->isWide ? tx16[settings->txCount] : tx8[settings->txCount]);
+        ++settings->txCount;
+    }
+
+    /* 3. Clear the receive timeout and overrun flags. */
+    GET_REG(SSI_BASE + SSIOffset + SSI_ICR_OFFSET) = 0x3;
+
+    if (settings->rxCount >= job->count) {
+        SPIFinishJob(ssi);
+    } else {
+        /* Receive on half full or timeout. Transmit on half empty until the
+           last frame is written; the TX interrupt is level triggered. */
+        GET_REG(SSI_BASE + SSIOffset + SSI_IM_OFFSET) =
+            0x6 | ((settings->txCount < job->count) << 3);
+    }
+}
+
+/**
+ * @brief SPIStartJob hands a transfer to the uDMA. The module must be idle.
+ *
+ * @param ssi SSI to transfer over.
+ * @param job Transfer to start.
+ */
+static void SPIStartJob(SSIModule_t ssi, struct SPIJob job) {
+    uint32_t SSIOffset = 0x1000 * (ssi%4);
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi%4];
+    DMA_t rxDMA = { .channel=settings->rxChannel };
+    DMA_t txDMA = { .channel=settings->txChannel };
+
+    settings->active = job;
+    settings->isActive = true;
+
+    /* 1. Frames wider than a byte use 16 bit elements. */
+    settings->isWide = (GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) & 0xF) > SSI_SIZE_8;
+    enum DMASize size = settings->isWide ? DMA_SIZE_16 : DMA_SIZE_8;
+    volatile void * DR = &GET_REG(SSI_BASE + SSIOffset + SSI_DR_OFFSET);
+
+    /* 2. Flush stale frames out of the receive FIFO. */
+    while (GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET) & 0x4) {
+        (void)GET_REG(SSI_BASE + SSIOffset + SSI_DR_OFFSET);
+    }
+
+    /* 3. Interrupt mode. Prime the transmit FIFO, then let the half FIFO and
+          receive timeout interrupts carry the rest of the transfer. */
+    if (job.isInterrupt) {
+        settings->txCount = 0;
+        settings->rxCount = 0;
+        SPIServiceFIFOs(ssi%4);
+        return;
+    }
+
+    /* 4. Arm the receive channel. The FIFO requests a burst once half full. */
+    if (job.rx != NULL) {
+        DMATransfer_t rxTransfer = {
+            .source=DR,
+            .destination=job.rx,
+            .count=job.count,
+            .size=size,
+            .isSourceIncrementing=false,
+            .isDestinationIncrementing=true,
+            .arbitration=DMA_ARB_4,
+            .mode=DMA_MODE_BASIC
+        };
+        DMASetTransfer(rxDMA, rxTransfer, false);
+        DMAStart(rxDMA);
+    }
+
+    /* 5. Arm the transmit channel, either as one transfer or as a chain of
+          segments. */
+    if (job.segments != NULL) {
+        uint8_t i;
+        for (i = 0; i < job.numSegments; ++i) {
+            DMATransfer_t txTransfer = {
+                .source=job.segments[i].tx,
+                .destination=DR,
+                .count=job.segments[i].count,
+                .size=size,
+                .isSourceIncrementing=true,
+                .isDestinationIncrementing=false,
+                .arbitration=DMA_ARB_4,
+                .mode=DMA_MODE_BASIC
+            };
+            settings->tasks[i] = DMABuildControl(txTransfer);
+        }
+        DMASetScatterGather(txDMA, settings->tasks, job.numSegments, true);
+    } else {
+        DMATransfer_t txTransfer = {
+            .source=job.tx == NULL ? (const void *)&ssiDummy : job.tx,
+            .destination=DR,
+            .count=job.count,
+            .size=size,
+            .isSourceIncrementing=job.tx != NULL,
+            .isDestinationIncrementing=false,
+            .arbitration=DMA_ARB_4,
+            .mode=DMA_MODE_BASIC
+        };
+        DMASetTransfer(txDMA, txTransfer, false);
+    }
+    DMAStart(txDMA);
+
+    /* 6. Let the FIFOs request transfers. Starts the transfer. */
+    GET_REG(SSI_BASE + SSIOffset + SSI_DMACTL_OFFSET) = 0x2 | (job.rx != NULL);
+}
+
+/**
+ * @brief SPISubmitJob starts a transfer, or queues it behind the active one.
+ *
+ * @param ssi SSI to transfer over.
+ * @param job Transfer to submit.
+ * @return False if the queue is full.
+ */
+static bool SPISubmitJob(SSIModule_t ssi, struct SPIJob job) {
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi%4];
+    bool isAccepted = true;
+
+    uint32_t sr = StartCritical();
+    if (!settings->isActive) {
+        SPIStartJob(ssi, job);
+    } else if (!settings->isPending) {
+        settings->pending = job;
+        settings->isPending = true;
+    } else {
+        isAccepted = false;
+    }
+    EndCritical(sr);
+
+    return isAccepted;
+}
+
+bool SPITransferAsync(SSIModule_t ssi, const void * tx, void * rx, size_t n) {
+    /* Initialization asserts. */
+    assert(ssi != 4 && ssi <= SSI1_PD);
+    assert(0 < n && n <= 1024);
+    assert(SSIInterruptSettings[ssi%4].isDMA);
+
+    struct SPIJob job = {
+        .tx=tx,
+        .rx=rx,
+        .count=n,
+        .segments=NULL,
+        .numSegments=0,
+        .isInterrupt=false,
+        .doneTask=NULL,
+        .doneArgs=NULL
+    };
+
+    return SPISubmitJob(ssi, job);
+}
+
+bool SPITransmitGather(SSIModule_t ssi, const SPISegment_t * segments, uint8_t numSegments) {
+    /* Initialization asserts. */
+    assert(ssi != 4 && ssi <= SSI1_PD);
+    assert(segments != NULL);
+    assert(0 < numSegments && numSegments <= SPI_MAX_SEGMENTS);
+    assert(SSIInterruptSettings[ssi%4].isDMA);
+
+    struct SPIJob job = {
+        .tx=NULL,
+        .rx=NULL,
+        .count=0,
+        .segments=segments,
+        .numSegments=numSegments,
+        .isInterrupt=false,
+        .doneTask=NULL,
+        .doneArgs=NULL
+    };
+
+    return SPISubmitJob(ssi, job);
+}
+
+bool SPITransferInterrupt(SSIModule_t ssi, const void * tx, void * rx, size_t n, void (*doneTask)(uint32_t *args), uint32_t * doneArgs) {
+    /* Initialization asserts. */
+    assert(ssi != 4 && ssi <= SSI1_PD);
+    assert(0 < n);
+
+    struct SPIJob job = {
+        .tx=tx,
+        .rx=rx,
+        .count=n,
+        .segments=NULL,
+        .numSegments=0,
+        .isInterrupt=true,
+        .doneTask=doneTask,
+        .doneArgs=doneArgs
+    };
+
+    return SPISubmitJob(ssi, job);
+}
+
+bool SPIIsBusy(SSIModule_t ssi) {
+    /* Initialization asserts. */
+    assert(ssi != 4 && ssi <= SSI1_PD);
+
+    uint32_t SSIOffset = 0x1000 * (ssi%4);
+    return SSIInterruptSettings[ssi%4].isActive ||
+        (GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET) & 0x10);
+}
+
+static void SPIBusRelease(uint8_t ssi);
+
+/**
+ * @brief SSIGeneric_Handler services interrupt mode transfers, completes
+ *        uDMA transfers, and releases drained shared bus transactions of a
+ *        module.
+ *
+ * @param ssi SSI module (0 - 3) that raised the interrupt.
+ */
+static void SSIGeneric_Handler(uint8_t ssi) {
+    uint32_t SSIOffset = 0x1000 * ssi;
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+
+    /* 0. A shared bus transaction waiting to drain is released on the end of
+          transmission interrupt: the transmit FIFO is empty and the last bit
+          has shifted out. */
+    if (settings->isBusDraining &&
+        (GET_REG(SSI_BASE + SSIOffset + SSI_MIS_OFFSET) & 0x8)) {
+        GET_REG(SSI_BASE + SSIOffset + SSI_IM_OFFSET) = 0x0;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) &= ~0x00000010;
+        settings->isBusDraining = false;
+        SPIBusRelease(ssi);
+        return;
+    }
+
+    /* 1. Interrupt mode transfers are carried by the FIFO interrupts. */
+    if (settings->isActive && settings->active.isInterrupt) {
+        SPIServiceFIFOs(ssi);
+        return;
+    }
+    if (!settings->isDMA) return;
+
+    /* 2. Acknowledge both channels. */
+    DMA_t rxDMA = { .channel=settings->rxChannel };
+    DMA_t txDMA = { .channel=settings->txChannel };
+    bool isRxDone = DMAAcknowledge(rxDMA);
+    bool isTxDone = DMAAcknowledge(txDMA);
+    if (!settings->isActive) return;
+
+    /* 3. A transfer is done once its last channel is done. Full duplex
+          transfers finish on the receive side. */
+    if (settings->active.rx != NULL) {
+        if (!isRxDone && DMAIsActive(rxDMA)) return;
+    } else {
+        if (!isTxDone && DMAIsActive(txDMA)) return;
+    }
+
+    SPIFinishJob(ssi);
+}
+
+void SSI0_Handler(void) { SSIGeneric_Handler(0); }
+void SSI1_Handler(void) { SSIGeneric_Handler(1); }
+void SSI2_Handler(void) { SSIGeneric_Handler(2); }
+void SSI3_Handler(void) { SSIGeneric_Handler(3); }
+
+/** @brief spiBusArgs hold the args for the bus completion handler. Index 0
+ *         holds the SSI module (0 - 3). */
+static uint32_t spiBusArgs[4][1] = {{0}, {1}, {2}, {3}};
+
+static void SPIBusStartNext(uint8_t ssi);
+
+/**
+ * @brief SPIBusRelease releases the chip select of the finished transaction,
+ *        starts the next one, and calls the completion function. The frames
+ *        of the finished transaction must have shifted out.
+ *
+ * @param ssi SSI module (0 - 3) whose transaction finished.
+ */
+static void SPIBusRelease(uint8_t ssi) {
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+    SPITransaction_t transaction = settings->current;
+
+    GPIOSetBit(transaction.device->chipSelect, !transaction.device->isChipSelectHigh);
+    settings->isBusActive = false;
+    SPIBusStartNext(ssi);
+
+    if (transaction.doneTask != NULL) {
+        transaction.doneTask(transaction.doneArgs);
+    }
+}
+
+/**
+ * @brief SPIBusDoneHandler releases the finished transaction once its last
+ *        frame has shifted out. Called from the SSI interrupt.
+ *
+ * @param args A pointer to a list of arguments. In this function, args[0]
+ *             should be the SSI module (0 - 3).
+ */
+static void SPIBusDoneHandler(uint32_t * args) {
+    uint8_t ssi = args[0];
+    uint32_t SSIOffset = 0x1000 * ssi;
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+
+    /* Transfers that receive finish once the last frame is read, after it
+       has shifted. uDMA transmit only transfers finish once the last frame is
+       written, up to a FIFO earlier. Rather than spin on BSY here, switch the
+       transmit interrupt to end of transmission mode and release the bus from
+       it. The interrupt is level triggered, so it cannot be missed if the
+       FIFO drains in between. */
+    if (GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET) & 0x10) {
+        settings->isBusDraining = true;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) |= 0x00000010;
+        GET_REG(SSI_BASE + SSIOffset + SSI_IM_OFFSET) = 0x8;
+        return;
+    }
+    SPIBusRelease(ssi);
+}
+
+/**
+ * @brief SPIBusStartNext starts the oldest waiting transaction, if the bus is
+ *        free. Called with interrupts disabled or from the SSI interrupt.
+ *
+ * @param ssi SSI module (0 - 3) to start.
+ */
+static void SPIBusStartNext(uint8_t ssi) {
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[ssi];
+    if (settings->isBusActive || settings->queueCount == 0) return;
+
+    /* 1. Pop the oldest transaction. */
+    settings->current = settings->queue[settings->queueHead];
+    settings->queueHead = (settings->queueHead + 1) % SPI_QUEUE_SIZE;
+    --settings->queueCount;
+    settings->isBusActive = true;
+
+    /* 2. Switch to the device. */
+    SPIDeviceSelect(settings->current.device);
+
+    /* 3. Hand the frames to the uDMA or the SSI interrupt. */
+    struct SPIJob job = {
+        .tx=settings->current.tx,
+        .rx=settings->current.rx,
+        .count=settings->current.n,
+        .segments=NULL,
+        .numSegments=0,
+        .isInterrupt=!settings->isDMA || settings->current.n > 1024,
+        .doneTask=SPIBusDoneHandler,
+        .doneArgs=spiBusArgs[ssi]
+    };
+
+    /* Shared buses must not be mixed with SPITransferAsync, SPITransmitGather
+       or SPITransferInterrupt, so the module is always free here. */
+    bool isStarted = SPISubmitJob(settings->current.device->ssi, job);
+    assert(isStarted);
+    (void)isStarted;
+}
+
+SPIDevice_t SPIDeviceInit(SPIDeviceConfig_t config) {
+    /* Initialization asserts. */
+    assert(config.ssi != 4 && config.ssi <= SSI1_PD);
+    assert(config.chipSelect < PIN_COUNT);
+    assert(SSI_SIZE_4 <= config.dataSize && config.dataSize <= SSI_SIZE_16);
+    assert(0 < config.ssiPrescaler && !(config.ssiPrescaler & 0x1));
+    assert(config.frameFormat <= MICROWIRE);
+    assert(config.polarity <= SSI_SECOND_EDGE);
+
+    /* 1. Release the chip select. */
+    GPIOConfig_t pinConfig = {
+        .pin=config.chipSelect,
+        .pull=GPIO_TRI_STATE,
+        .isOutput=true,
+        .alternateFunction=0,
+        .isAnalog=false,
+        .drive=GPIO_DRIVE_2MA,
+        .enableSlew=false
+    };
+    GPIOInit(pinConfig);
+    GPIOSetBit(config.chipSelect, !config.isChipSelectHigh);
+
+    /* 2. Precompute the register values used by the device. */
+    SPIDevice_t device = {
+        .ssi=config.ssi,
+        .chipSelect=config.chipSelect,
+        .isChipSelectHigh=config.isChipSelectHigh,
+        .cr0=(config.ssiClockModifier << 8) |
+             (config.polarity << 7) |
+             (!config.isClockLow << 6) |
+             (config.frameFormat << 4) |
+             config.dataSize,
+        .cpsr=config.ssiPrescaler,
+        .clock=PLLGetFrequency()
+    };
+
+    return device;
+}
+
+/**
+ * @brief SPIDeviceGetDivisors returns the CR0 and CPSR values of a device at
+ *        the current system clock. Values rescaled since SPIDeviceInit are
+ *        cached with the module until the clock changes again, so the divisor
+ *        search runs once per device and clock instead of on every select.
+ *
+ * @param settings The settings of the device's SSI module.
+ * @param device The device.
+ * @param cr0 Output for the SSICR0 value.
+ * @param cpsr Output for the SSICPSR value.
+ */
+static void SPIDeviceGetDivisors(struct SSIInterruptSettings * settings, const SPIDevice_t * device, uint16_t * cr0, uint8_t * cpsr) {
+    *cr0 = device->cr0;
+    *cpsr = device->cpsr;
+    uint32_t clock = PLLGetFrequency();
+    if (device->clock == clock) return;
+
+    /* 1. Look the device up in the cache of the current clock. */
+    if (settings->scaledClock != clock) {
+        settings->numScaled = 0;
+        settings->nextScaled = 0;
+        settings->scaledClock = clock;
+    }
+    uint8_t i;
+    for (i = 0; i < settings->numScaled; ++i) {
+        struct SSIDeviceScale * scale = &settings->scaled[i];
+        if (scale->deviceCr0 == device->cr0 && scale->deviceCpsr == device->cpsr &&
+            scale->deviceClock == device->clock) {
+            *cr0 = scale->cr0;
+            *cpsr = scale->cpsr;
+            return;
+        }
+    }
+
+    /* 2. Rescale it, replacing the oldest entry once the cache is full. */
+    SSIScaleDivisors(device->clock, clock, cr0, cpsr);
+    struct SSIDeviceScale * scale = &settings->scaled[settings->nextScaled];
+    scale->deviceCr0 = device->cr0;
+    scale->deviceCpsr = device->cpsr;
+    scale->deviceClock = device->clock;
+    scale->cr0 = *cr0;
+    scale->cpsr = *cpsr;
+    settings->nextScaled = (settings->nextScaled + 1) % SPI_DEVICE_CACHE_SIZE;
+    if (settings->numScaled < SPI_DEVICE_CACHE_SIZE) ++settings->numScaled;
+}
+
+void SPIDeviceSelect(const SPIDevice_t * device) {
+    /* Initialization asserts. */
+    assert(device != NULL);
+    assert(device->ssi != 4 && device->ssi <= SSI1_PD);
+
+    uint32_t SSIOffset = 0x1000 * (device->ssi%4);
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[device->ssi%4];
+
+    /* 1. Rescale the device settings if the system clock changed since
+          SPIDeviceInit. */
+    uint16_t cr0;
+    uint8_t cpsr;
+    SPIDeviceGetDivisors(settings, device, &cr0, &cpsr);
+
+    /* 2. Only reprogram the module when the device settings differ. The
+          module must be disabled while CR0 and CPSR are written. */
+    if (settings->cr0 != cr0 || settings->cpsr != cpsr) {
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) &= ~0x00000002;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CPSR_OFFSET) = cpsr;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR0_OFFSET) = cr0;
+        GET_REG(SSI_BASE + SSIOffset + SSI_CR1_OFFSET) |= 0x00000002;
+        settings->cr0 = cr0;
+        settings->cpsr = cpsr;
+    }
+
+    /* 3. Assert chip select. */
+    GPIOSetBit(device->chipSelect, device->isChipSelectHigh);
+}
+
+void SPIDeviceDeselect(const SPIDevice_t * device) {
+    /* Initialization asserts. */
+    assert(device != NULL);
+    assert(device->ssi != 4 && device->ssi <= SSI1_PD);
+
+    uint32_t SSIOffset = 0x1000 * (device->ssi%4);
+
+    /* Wait for the last frame to shift out. */
+    while (GET_REG(SSI_BASE + SSIOffset + SSI_SR_OFFSET) & 0x10) {}
+    GPIOSetBit(device->chipSelect, !device->isChipSelectHigh);
+}
+
+bool SPIDeviceSubmit(SPITransaction_t transaction) {
+    /* Initialization asserts. */
+    assert(transaction.device != NULL);
+    assert(transaction.device->ssi != 4 && transaction.device->ssi <= SSI1_PD);
+    assert(0 < transaction.n);
+
+    struct SSIInterruptSettings * settings = &SSIInterruptSettings[transaction.device->ssi%4];
+    bool isAccepted = false;
+
+    uint32_t sr = StartCritical();
+    if (settings->queueCount < SPI_QUEUE_SIZE) {
+        settings->queue[(settings->queueHead + settings->queueCount) % SPI_QUEUE_SIZE] = transaction;
+        ++settings->queueCount;
+        isAccepted = true;
+        SPIBusStartNext(transaction.device->ssi%4);
+    }
+    EndCritical(sr);
+
+    return isAccepted;
+}
+
+/**
+ * @brief SPIDeviceTransferDone flags a blocking transaction as complete.
+ *
+ * @param args A pointer to a list of arguments. In this function, args[0]
+ *             should be the completion flag.
+ */
+static void SPIDeviceTransferDone(uint32_t * args) {
+    args[0] = 1;
+}
+
+void SPIDeviceTransfer(const SPIDevice_t * device, const void * tx, void * rx, size_t n) {
+    volatile uint32_t isDone[1] = {0};
+    SPITransaction_t transaction = {
+        .device=device,
+        .tx=tx,
+        .rx=rx,
+        .n=n,
+        .doneTask=SPIDeviceTransferDone,
+        .doneArgs=(uint32_t *)isDone
+    };
+
+    while (!SPIDeviceSubmit(transaction)) {}
+    while (!isDone[0]) {}
+}
@@ -6,8 +6,27 @@
  * @date 2021-09-23
  * @copyright Copyright (c) 2021
  * @note
- * Unsupported Features. This driver does not support DMA control. This driver
- * does not support interrupts.
+ * DMA. When isDMA is set at initialization, SPITransferAsync and
+ * SPITransmitGather hand transfers to the uDMA and return immediately. One
+ * transfer may be queued behind the active one, so the application can render
+ * frame N+1 while frame N streams out. The queued transfer starts from the
+ * completion interrupt.
+ *
+ * Interrupts. SPITransferInterrupt services the FIFOs from the SSI interrupt
+ * at the half full (RX), half empty (TX) and receive timeout levels. It shares
+ * the transfer queue with the uDMA transfers.
+ *
+ * Shared Buses. Several devices can share one SSI module, each with its own
+ * GPIO chip select and frame settings. Initialize the module once with
+ * isManualChipSelect, then describe each device with SPIDeviceInit. The
+ * device's CR0 and CPSR values are cached and only written when the bus
+ * switches to a device with different settings. SPIDeviceSubmit queues
+ * transactions from the main loop or from interrupts and runs them in order.
+ *
+ * Clock Changes. When PLLSetClock changes the system clock, every module
+ * finishes its transfers and has its CPSR and SCR rescaled to keep its bit
+ * rate. Devices are rescaled when selected; call SPIDeviceInit again after a
+ * switch to skip the rescale.
  */
 
 #pragma once
@@ -15,6 +34,27 @@
 /** General imports. */
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+/** Device specific imports. */
+#include <lib/DMA/DMA.h>
+#include <lib/GPIO/GPIO.h>
+
+/** @brief SPI_DUMMY is the frame transmitted when reading without a transmit
+ *         buffer. Truncated to the frame size. */
+#define SPI_DUMMY 0xFFFF
+
+/** @brief SPI_MAX_SEGMENTS is the maximum number of segments chained by
+ *         SPITransmitGather. */
+#define SPI_MAX_SEGMENTS 8
+
+/** @brief SPI_QUEUE_SIZE is the maximum number of device transactions waiting
+ *         on a single SSI module. */
+#define SPI_QUEUE_SIZE 8
+
+/** @brief SPI_DEVICE_CACHE_SIZE is the number of device settings rescaled to
+ *         the current system clock that are kept for a single SSI module. */
+#define SPI_DEVICE_CACHE_SIZE 4
 
 /** @brief SSIModule_t is an enumeration defining a set of pins used for SPI
  *         communication. */ 
@@ -130,8 +170,207 @@ typedef struct SSIConfig {
      * Default is false (no loopback).
      */
     bool isLoopback;
+
+    /**
+     * @brief Whether the SSI module is connected to the uDMA for asynchronous
+     *        transfers. Required by SPITransferAsync and SPITransmitGather.
+     * 
+     * Default is false (Blocking transfers only).
+     */
+    bool isDMA;
+
+    /**
+     * @brief Pointer to function called when an asynchronous transfer
+     *        completes, unless the transfer defines its own. Called from the
+     *        SSI interrupt.
+     * 
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     * 
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+
+    /**
+     * @brief Whether the Fss pin is left unconfigured so that devices sharing
+     *        the bus drive their own GPIO chip selects. See SPIDeviceInit.
+     * 
+     * Default is false (The SSI drives Fss).
+     */
+    bool isManualChipSelect;
+
+    /**
+     * @brief SSI interrupt priority. From 0 - 7. Lower value is higher
+     *        priority. Used by asynchronous transfers.
+     * 
+     * Default is 0 (Highest priority).
+     */
+    uint8_t priority;
 } SSIConfig_t;
 
+/** @brief SPISegment_t is a user defined struct that specifies one piece of a
+ *         scatter-gather transmission, i.e. a command header, a pixel buffer,
+ *         or a trailer. */
+typedef struct SPISegment {
+    /** @brief Frames to transmit. See SPITransfer for the element size. */
+    const void * tx;
+
+    /** @brief The number of frames in the segment. From 1 - 1024. */
+    uint16_t count;
+} SPISegment_t;
+
+/** @brief SPIDeviceConfig_t is a user defined struct that specifies a device on
+ *         a shared SSI module. */
+typedef struct SPIDeviceConfig {
+    /** 
+     * @brief The SSI module the device is connected to. The module must be
+     *        initialized with SSIInit.
+     * 
+     * Default is SSI0_PA (Port A).
+     */
+    SSIModule_t ssi;
+
+    /** 
+     * @brief The GPIO pin driving the device's chip select.
+     * 
+     * Default is PIN_A0.
+     */
+    GPIOPin_t chipSelect;
+
+    /** 
+     * @brief The frame size used by the device. From 4 to 16 bits wide.
+     * 
+     * Default is SSI_SIZE_4, or 4 bits.
+     */
+    enum SSIDataSize dataSize;
+
+    /**
+     * @brief Serial clock prescaler (CPSDVSR) used by the device. See
+     *        SSI_CLOCKING.md
+     * 
+     * This value must be specified and greater than 0. It must also be even.
+     * Failing one of these conditions will trigger an internal assert in debug
+     * mode.
+     */
+    uint8_t ssiPrescaler;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Serial clock rate modifier (SCR). See SSI_CLOCKING.md.
+     * 
+     * Default is 0.
+     */
+    uint8_t ssiClockModifier;
+
+    /** 
+     * @brief What frame format of the SSI should be used. 
+     * 
+     * Default is FREESCALE_SPI.
+     */
+    enum SSIFrameFormat frameFormat;
+
+    /** 
+     * @brief Whether the clock line is fixed low when not executing.
+     * 
+     * Default is false (Clock is high when not executing).
+     */
+    bool isClockLow;
+
+    /** 
+     * @brief Whether the data bits are captured on the 1st or 2nd edge.
+     * 
+     * Default is SSI_FIRST_EDGE.
+     */ 
+    enum SSIPolarity polarity;
+
+    /** 
+     * @brief Whether the chip select is active high.
+     * 
+     * Default is false (Active low).
+     */
+    bool isChipSelectHigh;
+} SPIDeviceConfig_t;
+
+/** @brief SPIDevice_t is a struct containing the cached settings of a device
+ *         on a shared SSI module. */
+typedef struct SPIDevice {
+    /** @brief The SSI module the device is connected to. */
+    SSIModule_t ssi;
+
+    /** @brief The GPIO pin driving the device's chip select. */
+    GPIOPin_t chipSelect;
+
+    /** @brief Whether the chip select is active high. */
+    bool isChipSelectHigh;
+
+    /** @brief SSICR0 value of the device. */
+    uint16_t cr0;
+
+    /** @brief SSICPSR value of the device. */
+    uint8_t cpsr;
+
+    /** @brief The system clock frequency cr0 and cpsr were computed for. */
+    uint32_t clock;
+} SPIDevice_t;
+
+/** @brief SPITransaction_t is a user defined struct that specifies a single
+ *         chip select framed transfer with a device. */
+typedef struct SPITransaction {
+    /** 
+     * @brief The device to transfer with. Must remain valid until the
+     *        transaction completes.
+     */
+    const SPIDevice_t * device;
+
+    /** @brief Frames to transmit. See SPITransfer. NULL for RX only. */
+    const void * tx;
+
+    /** @brief Buffer to receive into. See SPITransfer. NULL for TX only. */
+    void * rx;
+
+    /** @brief The number of frames to transfer. */
+    size_t n;
+
+    /** ------------- Optional Fields. ------------- */
+
+    /**
+     * @brief Pointer to function called from the SSI interrupt once the
+     *        transaction completes and chip select is released.
+     * 
+     * Default is NULL (No function defined).
+     */
+    void (*doneTask)(uint32_t *args);
+
+    /**
+     * @brief The pointer to an array of uint32_t arguments that fed into
+     *        doneTask upon being called.
+     * 
+     * Default is NULL (No pointer to any arguments is defined).
+     */
+    uint32_t * doneArgs;
+} SPITransaction_t;
+
+/**
+ * @brief SSIGetDivisors computes the CPSDVSR and SCR that run the serial clock
+ *        at the closest rate not above bitRate, at a given system clock,
+ *        without touching any hardware. See SSI_CLOCKING.md.
+ * 
+ * @param systemClock The system clock frequency, in Hz. Usually
+ *                    PLLGetFrequency().
+ * @param bitRate The requested serial clock rate, in Hz. Must be greater than 0.
+ * @param prescaler Output for ssiPrescaler (CPSDVSR), from 2 - 254.
+ * @param clockModifier Output for ssiClockModifier (SCR), from 0 - 255.
+ * @return The serial clock rate achieved, in Hz. The slowest possible rate if
+ *         bitRate cannot be reached.
+ */
+uint32_t SSIGetDivisors(uint32_t systemClock, uint32_t bitRate, uint8_t * prescaler, uint8_t * clockModifier);
+
 /**
  * @brief SSIInit initializes a given SSI module. 
  * 
@@ -157,3 +396,163 @@ uint16_t SPIRead(SSIModule_t ssi);
  * @param data Right justified 16-bit data to write.
  */
 void SPIWrite(SSIModule_t ssi, uint16_t data);
+
+/**
+ * @brief SPITransfer performs a full duplex block transfer. The transmit FIFO
+ *        is kept full while the receive FIFO is drained as frames arrive, so
+ *        the bus runs back to back at the configured clock rate. Blocks until
+ *        every frame is received.
+ * 
+ * @param ssi SSI to transfer over.
+ * @param tx Frames to transmit. Frames of 4 - 8 bits are read as uint8_t and
+ *           frames of 9 - 16 bits are read as uint16_t. If NULL, SPI_DUMMY is
+ *           transmitted for every frame (RX only).
+ * @param rx Buffer to receive into, using the same element size as tx. If NULL,
+ *           received frames are discarded (TX only).
+ * @param n The number of frames to transfer.
+ * @note Any frames left in the receive FIFO by previous SPIWrite calls are
+ *       discarded before the transfer starts.
+ */
+void SPITransfer(SSIModule_t ssi, const void * tx, void * rx, size_t n);
+
+/**
+ * @brief SPITransmit writes a block of frames and discards the received
+ *        frames. Equivalent to SPITransfer(ssi, tx, NULL, n).
+ * 
+ * @param ssi SSI to write into.
+ * @param tx Frames to transmit. See SPITransfer for the element size.
+ * @param n The number of frames to transmit.
+ */
+void SPITransmit(SSIModule_t ssi, const void * tx, size_t n);
+
+/**
+ * @brief SPIReceive reads a block of frames, transmitting SPI_DUMMY for each.
+ *        Equivalent to SPITransfer(ssi, NULL, rx, n).
+ * 
+ * @param ssi SSI to read from.
+ * @param rx Buffer to receive into. See SPITransfer for the element size.
+ * @param n The number of frames to receive.
+ */
+void SPIReceive(SSIModule_t ssi, void * rx, size_t n);
+
+/**
+ * @brief SPITransferAsync starts a full duplex block transfer through the
+ *        uDMA and returns immediately. If a transfer is already running, this
+ *        one is queued and starts as soon as it completes.
+ * 
+ * @param ssi SSI to transfer over. Must be initialized with isDMA.
+ * @param tx Frames to transmit. See SPITransfer for the element size. If NULL,
+ *           SPI_DUMMY is transmitted for every frame (RX only).
+ * @param rx Buffer to receive into. If NULL, received frames are discarded
+ *           (TX only).
+ * @param n The number of frames to transfer. From 1 - 1024.
+ * @return False if a transfer is both running and queued. Nothing is started.
+ * @note Both buffers must remain valid until the doneTask is called.
+ */
+bool SPITransferAsync(SSIModule_t ssi, const void * tx, void * rx, size_t n);
+
+/**
+ * @brief SPITransmitGather starts a transmission of several segments chained
+ *        with uDMA scatter-gather and returns immediately. The segments are
+ *        sent back to back as a single transaction. Queued like
+ *        SPITransferAsync.
+ * 
+ * @param ssi SSI to transmit over. Must be initialized with isDMA.
+ * @param segments Segments to send, in order. The array and the buffers it
+ *                 points to must remain valid until the doneTask is called.
+ * @param numSegments The number of segments. From 1 - SPI_MAX_SEGMENTS.
+ * @return False if a transfer is both running and queued. Nothing is started.
+ */
+bool SPITransmitGather(SSIModule_t ssi, const SPISegment_t * segments, uint8_t numSegments);
+
+/**
+ * @brief SPITransferInterrupt starts a full duplex block transfer serviced by
+ *        the SSI interrupt and returns immediately. Frames are moved whenever
+ *        the receive FIFO is half full, the transmit FIFO is half empty, or
+ *        the receive FIFO times out. Queued like SPITransferAsync. Useful for
+ *        mid-size transfers where uDMA setup isn't worth it.
+ * 
+ * @param ssi SSI to transfer over.
+ * @param tx Frames to transmit. See SPITransfer for the element size. If NULL,
+ *           SPI_DUMMY is transmitted for every frame (RX only).
+ * @param rx Buffer to receive into. If NULL, received frames are discarded
+ *           (TX only).
+ * @param n The number of frames to transfer.
+ * @param doneTask Function called from the SSI interrupt once the last frame
+ *                 is received. If NULL, the doneTask of the module is called.
+ * @param doneArgs Arguments fed into doneTask.
+ * @return False if a transfer is both running and queued. Nothing is started.
+ * @note Completes once the last frame is received, so the bus is idle when
+ *       doneTask is called.
+ */
+bool SPITransferInterrupt(SSIModule_t ssi, const void * tx, void * rx, size_t n, void (*doneTask)(uint32_t *args), uint32_t * doneArgs);
+
+/**
+ * @brief SPIIsBusy returns whether an asynchronous transfer is running or
+ *        queued, or the SSI is still shifting frames out. Check this before
+ *        deasserting chip select.
+ * 
+ * @param ssi SSI to check.
+ * @return True if the bus is in use.
+ */
+bool SPIIsBusy(SSIModule_t ssi);
+
+/** SSI handler declarations. */
+void SSI0_Handler(void);
+void SSI1_Handler(void);
+void SSI2_Handler(void);
+void SSI3_Handler(void);
+
+/**
+ * @brief SPIDeviceInit describes a device on a shared SSI module and releases
+ *        its chip select. Does not touch the SSI module.
+ * 
+ * @param config Configuration of the device.
+ * @return A SPIDevice_t holding the cached register settings of the device.
+ */
+SPIDevice_t SPIDeviceInit(SPIDeviceConfig_t config);
+
+/**
+ * @brief SPIDeviceSelect applies the settings of a device, if the bus is not
+ *        already using them, and asserts its chip select. The bus must be idle.
+ *        Used for manual framing with SPITransfer; queued transactions select
+ *        devices automatically.
+ * 
+ * @param device Device to select.
+ */
+void SPIDeviceSelect(const SPIDevice_t * device);
+
+/**
+ * @brief SPIDeviceDeselect waits for the bus to finish shifting and releases
+ *        the chip select of a device.
+ * 
+ * @param device Device to deselect.
+ */
+void SPIDeviceDeselect(const SPIDevice_t * device);
+
+/**
+ * @brief SPIDeviceSubmit queues a transaction on the device's SSI module. Safe
+ *        to call from both the main loop and interrupts. Transactions run in
+ *        submission order, each framed by its device's chip select. Uses the
+ *        uDMA when the module was initialized with isDMA and the transaction
+ *        is at most 1024 frames, and the SSI interrupt otherwise.
+ * 
+ * @param transaction Transaction to queue. Buffers must remain valid until
+ *                    the doneTask is called.
+ * @return False if SPI_QUEUE_SIZE transactions are already waiting.
+ * @note A module used as a shared bus must not also be used with
+ *       SPITransferAsync, SPITransmitGather, or SPITransferInterrupt.
+ */
+bool SPIDeviceSubmit(SPITransaction_t transaction);
+
+/**
+ * @brief SPIDeviceTransfer queues a transaction and waits for it to complete.
+ *        This is BLOCKING and requires interrupts to be enabled.
+ * 
+ * @param device Device to transfer with.
+ * @param tx Frames to transmit. See SPITransfer. NULL for RX only.
+ * @param rx Buffer to receive into. See SPITransfer. NULL for TX only.
+ * @param n The number of frames to transfer.
+ * @note Not to be used in interrupt handlers.
+ */
+void SPIDeviceTransfer(const SPIDevice_t * device, const void * tx, void * rx, size_t n);
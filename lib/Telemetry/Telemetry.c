@@ -0,0 +1,226 @@
+/**
+ * @file Telemetry.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Framed binary telemetry over UART.
+ * @version 0.1
+ * @date 2022-03-09
+ * @copyright Copyright (c) 2022
+ */
+
+/** General imports. */
+#include <stdlib.h>
+#include <assert.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/PLL/PLL.h>
+#include <lib/Common/Common.h>
+#include <lib/Telemetry/Telemetry.h>
+
+
+uint32_t StartCritical(void);       // Defined in startup.s
+void EndCritical(uint32_t sr);      // Defined in startup.s
+
+/** @brief TelemetryCRCTable is the CRC-16/CCITT-FALSE remainder of each
+ *         nibble. */
+static const uint16_t TelemetryCRCTable[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/** @brief TelemetryBatches are the two sample batches and the frame being
+ *         transmitted. */
+static struct TelemetryBatches {
+    /** @brief The samples of each batch. */
+    TelemetrySample_t samples[2][TELEMETRY_FRAME_SAMPLES];
+
+    /** @brief The number of samples in each batch. */
+    volatile uint8_t count[2];
+
+    /** @brief Whether each batch is waiting to be sent. */
+    volatile bool isReady[2];
+
+    /** @brief The batch being written. */
+    volatile uint8_t active;
+
+    /** @brief The number of samples dropped because both batches were full. */
+    volatile uint32_t dropped;
+
+    /** @brief The sequence number of the next frame. */
+    uint16_t sequence;
+
+    /** @brief The UART to transmit across. */
+    UART_t uart;
+
+    /** @brief The encoded frame. Owned by the uDMA until the UART is idle. */
+    uint8_t frame[TELEMETRY_ENCODED_SIZE];
+} TelemetryBatches;
+
+void TelemetryInit(UART_t uart) {
+    /* 1. Enable the cycle counter. */
+    CommonEnableCycleCounter();
+
+    /* 2. Empty the batches. */
+    uint32_t sr = StartCritical();
+    TelemetryBatches.count[0] = 0;
+    TelemetryBatches.count[1] = 0;
+    TelemetryBatches.isReady[0] = false;
+    TelemetryBatches.isReady[1] = false;
+    TelemetryBatches.active = 0;
+    TelemetryBatches.dropped = 0;
+    TelemetryBatches.sequence = 0;
+    TelemetryBatches.uart = uart;
+    EndCritical(sr);
+}
+
+/**
+ * @brief TelemetrySwap marks the active batch as ready and starts writing the
+ *        other one. Must be called with interrupts masked.
+ *
+ * @return False if the other batch is still waiting to be sent.
+ */
+static bool TelemetrySwap(void) {
+    uint8_t active = TelemetryBatches.active;
+    if (TelemetryBatches.isReady[active ^ 1]) return false;
+
+    TelemetryBatches.isReady[active] = true;
+    TelemetryBatches.count[active ^ 1] = 0;
+    TelemetryBatches.active = active ^ 1;
+    return true;
+}
+
+bool TelemetryRecord(uint8_t channel, int32_t value) {
+    /* 1. Write the sample into the active batch. Interrupts are masked so the
+          timestamps in a batch stay in order. */
+    uint32_t sr = StartCritical();
+    uint8_t active = TelemetryBatches.active;
+    uint8_t count = TelemetryBatches.count[active];
+    if (count == TELEMETRY_FRAME_SAMPLES) {
+        ++TelemetryBatches.dropped;
+        EndCritical(sr);
+        return false;
+    }
+
+    TelemetrySample_t * sample = &TelemetryBatches.samples[active][count];
+    sample->timestamp = GET_REG(DWT_BASE + DWT_CYCCNT_OFFSET);
+    sample->value = value;
+    sample->channel = channel;
+    TelemetryBatches.count[active] = count + 1;
+
+    /* 2. Hand a full batch to TelemetryService. If the other batch has not
+          been sent yet, this one stays full and later samples are dropped. */
+    if (count + 1 == TELEMETRY_FRAME_SAMPLES) TelemetrySwap();
+    EndCritical(sr);
+    return true;
+}
+
+bool TelemetryService(void) {
+    /* 1. Retry a full batch that could not be swapped out when it filled. */
+    uint32_t sr = StartCritical();
+    if (TelemetryBatches.count[TelemetryBatches.active] == TELEMETRY_FRAME_SAMPLES) {
+        TelemetrySwap();
+    }
+    EndCritical(sr);
+
+    /* 2. The ready batch is never the active one. */
+    uint8_t ready = TelemetryBatches.active ^ 1;
+    if (!TelemetryBatches.isReady[ready]) return false;
+    if (UARTIsBusy(TelemetryBatches.uart)) return false;
+
+    /* 3. Encode the batch, then release it to the writers. */
+    uint16_t length = TelemetryEncodeFrame(
+        TelemetryBatches.samples[ready],
+        TelemetryBatches.count[ready],
+        TelemetryBatches.sequence++,
+        TelemetryBatches.frame
+    );
+    TelemetryBatches.isReady[ready] = false;
+
+    /* 4. Transmit the frame in the background. */
+    return UARTSendAsync(TelemetryBatches.uart, TelemetryBatches.frame, length);
+}
+
+void TelemetryFlush(void) {
+    uint32_t sr = StartCritical();
+    if (TelemetryBatches.count[TelemetryBatches.active] > 0) TelemetrySwap();
+    EndCritical(sr);
+}
+
+uint32_t TelemetryGetDropped(void) {
+    return TelemetryBatches.dropped;
+}
+
+uint16_t TelemetryCRC(const uint8_t * bytes, uint16_t numBytes) {
+    uint16_t crc = 0xFFFF;
+    uint16_t i;
+    for (i = 0; i < numBytes; ++i) {
+        crc = (crc << 4) ^ TelemetryCRCTable[(crc >> 12) ^ (bytes[i] >> 4)];
+        crc = (crc << 4) ^ TelemetryCRCTable[(crc >> 12) ^ (bytes[i] & 0xF)];
+    }
+    return crc;
+}
+
+/**
+ * @brief TelemetryPut writes a little endian value into a buffer.
+ *
+ * @param bytes The buffer.
+ * @param value The value.
+ * @param numBytes The size of the value in bytes.
+ * @return The position after the value.
+ */
+static uint8_t * TelemetryPut(uint8_t * bytes, uint32_t value, uint8_t numBytes) {
+    while (numBytes-- > 0) {
+        *bytes++ = value & 0xFF;
+        value >>= 8;
+    }
+    return bytes;
+}
+
+uint16_t TelemetryEncodeFrame(const TelemetrySample_t * samples, uint8_t count, uint16_t sequence, uint8_t * frame) {
+    /* Initialization asserts. */
+    assert(samples != NULL || count == 0);
+    assert(count <= TELEMETRY_FRAME_SAMPLES);
+    assert(frame != NULL);
+
+    /* 1. Build the raw frame. */
+    uint8_t raw[TELEMETRY_FRAME_SIZE];
+    uint8_t * position = raw;
+    position = TelemetryPut(position, TELEMETRY_VERSION, 1);
+    position = TelemetryPut(position, count, 1);
+    position = TelemetryPut(position, sequence, 2);
+    position = TelemetryPut(position, PLLGetFrequency(), 4);
+
+    uint8_t i;
+    for (i = 0; i < count; ++i) {
+        position = TelemetryPut(position, samples[i].channel, 1);
+        position = TelemetryPut(position, samples[i].timestamp, 4);
+        position = TelemetryPut(position, (uint32_t)samples[i].value, 4);
+    }
+
+    uint16_t rawLength = position - raw;
+    position = TelemetryPut(position, TelemetryCRC(raw, rawLength), 2);
+    rawLength += 2;
+
+    /* 2. COBS encode. Each code byte is the distance to the next zero, or
+          0xFF for a run of 254 nonzero bytes without one. */
+    uint16_t codeIndex = 0;
+    uint16_t length = 1;
+    uint8_t code = 1;
+    uint16_t j;
+    for (j = 0; j < rawLength; ++j) {
+        if (raw[j] != 0) {
+            frame[length++] = raw[j];
+            ++code;
+        }
+        if (raw[j] == 0 || code == 0xFF) {
+            frame[codeIndex] = code;
+            codeIndex = length++;
+            code = 1;
+        }
+    }
+    frame[codeIndex] = code;
+
+    /* 3. Delimit. */
+    frame[length++] = 0x00;
+    return length;
+}
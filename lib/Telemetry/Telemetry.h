@@ -0,0 +1,141 @@
+/**
+ * @file Telemetry.h
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Framed binary telemetry over UART.
+ * @version 0.1
+ * @date 2022-03-09
+ * @copyright Copyright (c) 2022
+ * @note
+ * Usage. TelemetryRecord stores a channel ID, a cycle counter timestamp and a
+ * 32 bit value into a batch. Nothing is encoded at the call site, so it is
+ * safe to call from interrupts. Full batches are encoded into a frame and
+ * handed to the uDMA by TelemetryService in the idle loop.
+ *
+ *      TelemetryRecord(CHANNEL_SPEED, speed);
+ *      ...
+ *      while (1) { TelemetryService(); WaitForInterrupt(); }
+ *
+ * Frames. Each frame holds up to TELEMETRY_FRAME_SAMPLES samples. All fields
+ * are little endian.
+ *
+ *      Header:  version (1) | count (1) | sequence (2) | clock in Hz (4)
+ *      Sample:  channel (1) | timestamp in cycles (4) | value (4, signed)
+ *      Trailer: CRC-16/CCITT-FALSE of the header and samples (2)
+ *
+ * The frame is then COBS encoded, so it contains no zero bytes, and ends with
+ * a single 0x00 delimiter. A receiver that joins mid stream discards bytes up
+ * to the first delimiter. Sequence numbers increment per frame, so gaps show
+ * lost frames. examples/Telemetry/host/TelemetryDecoder.c decodes the stream
+ * into CSV.
+ *
+ * Concurrency. Samples are written into one of two batches with interrupts
+ * masked for a few instructions. When the other batch is still waiting to be
+ * sent, the sample is dropped and counted. TelemetryService and
+ * TelemetryFlush must be called from a single context.
+ */
+#pragma once
+
+/** General imports. */
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Device specific imports. */
+#include <lib/UART/UART.h>
+
+
+/** @brief TELEMETRY_VERSION is the frame format version. */
+#define TELEMETRY_VERSION 1
+
+/** @brief TELEMETRY_FRAME_SAMPLES is the number of samples in a full frame. */
+#define TELEMETRY_FRAME_SAMPLES 32
+
+/** @brief TELEMETRY_HEADER_SIZE is the size of a frame header in bytes. */
+#define TELEMETRY_HEADER_SIZE 8
+
+/** @brief TELEMETRY_SAMPLE_SIZE is the size of an encoded sample in bytes. */
+#define TELEMETRY_SAMPLE_SIZE 9
+
+/** @brief TELEMETRY_FRAME_SIZE is the size of the largest frame before COBS
+ *         encoding, including the CRC. */
+#define TELEMETRY_FRAME_SIZE \
+    (TELEMETRY_HEADER_SIZE + TELEMETRY_FRAME_SAMPLES * TELEMETRY_SAMPLE_SIZE + 2)
+
+/** @brief TELEMETRY_ENCODED_SIZE is the size of the largest frame after COBS
+ *         encoding, including the delimiter. Must not exceed 1024, the
+ *         largest uDMA transfer. */
+#define TELEMETRY_ENCODED_SIZE \
+    (TELEMETRY_FRAME_SIZE + TELEMETRY_FRAME_SIZE / 254 + 2)
+
+/** @brief TelemetrySample_t is a single recorded value. */
+typedef struct TelemetrySample {
+    /** @brief The cycle counter when the sample was recorded. */
+    uint32_t timestamp;
+
+    /** @brief The value. */
+    int32_t value;
+
+    /** @brief The user defined channel ID. */
+    uint8_t channel;
+} TelemetrySample_t;
+
+/**
+ * @brief TelemetryInit empties the batches and enables the DWT cycle counter
+ *        used for timestamps.
+ *
+ * @param uart The UART to transmit across. Must be initialized with isDMA.
+ */
+void TelemetryInit(UART_t uart);
+
+/**
+ * @brief TelemetryRecord adds a sample to the current batch.
+ *
+ * @param channel The channel ID.
+ * @param value The value.
+ * @return False if both batches were full and the sample was dropped.
+ */
+bool TelemetryRecord(uint8_t channel, int32_t value);
+
+/**
+ * @brief TelemetryService sends the oldest full batch when the UART is idle.
+ *        Call from the idle loop.
+ *
+ * @return Whether a frame was started.
+ */
+bool TelemetryService(void);
+
+/**
+ * @brief TelemetryFlush marks a partially filled batch as ready, so the next
+ *        TelemetryService sends it. Use at low sample rates, i.e. from a
+ *        periodic timer, to bound latency.
+ */
+void TelemetryFlush(void);
+
+/**
+ * @brief TelemetryGetDropped returns the number of samples dropped because
+ *        both batches were full.
+ *
+ * @return The number of samples dropped since TelemetryInit.
+ */
+uint32_t TelemetryGetDropped(void);
+
+/**
+ * @brief TelemetryEncodeFrame builds a frame, computes its CRC and COBS encodes
+ *        it, for any other backend.
+ *
+ * @param samples The samples to encode.
+ * @param count The number of samples, from 0 - TELEMETRY_FRAME_SAMPLES.
+ * @param sequence The frame sequence number.
+ * @param frame Output buffer of at least TELEMETRY_ENCODED_SIZE bytes.
+ * @return The length of the encoded frame, including the delimiter.
+ */
+uint16_t TelemetryEncodeFrame(const TelemetrySample_t * samples, uint8_t count, uint16_t sequence, uint8_t * frame);
+
+/**
+ * @brief TelemetryCRC computes the CRC-16/CCITT-FALSE (polynomial 0x1021,
+ *        initial value 0xFFFF) of a buffer.
+ *
+ * @param bytes The buffer.
+ * @param numBytes The length of the buffer.
+ * @return The CRC.
+ */
+uint16_t TelemetryCRC(const uint8_t * bytes, uint16_t numBytes);
@@ -18,6 +18,8 @@
 /** Device specific imports. */
 #include <inc/RegDefs.h>
 #include <lib/FaultHandler/FaultHandler.h>
+#include <lib/Check/Check.h>
+#include <lib/Profile/Profile.h>
 #include <lib/Timer/Timer.h>
 
 
@@ -48,6 +50,16 @@ static struct TimerInterruptSettings {
 
     /** @brief User args associated with the interrupt function. */
     uint32_t * timerArgs;
+
+    /** @brief The period at clock, in cycles. 0 if the timer is not rescaled
+     *         on clock changes. */
+    uint64_t period;
+
+    /** @brief The system clock frequency period was set for. */
+    uint32_t clock;
+
+    /** @brief The largest period TimerUpdatePeriod can set, in cycles. */
+    uint32_t maxPeriod;
 } TimerInterruptSettings[TIMER_COUNT] = {
     {INTD, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI4_OFFSET),  (uint32_t *)(PERIPHERALS_BASE + NVIC_EN0_OFFSET), 19,    NULL,   NULL}, /* Timer 0A. */
     {INTA, (uint32_t *)(PERIPHERALS_BASE + NVIC_PRI5_OFFSET),  (uint32_t *)(PERIPHERALS_BASE + NVIC_EN0_OFFSET), 20,    NULL,   NULL}, /* Timer 0B. */
@@ -78,6 +90,35 @@ static struct TimerInterruptSettings {
     {INTA, 0, 0, 0, NULL, NULL}, /* SYSTICK. */
 };
 
+/** @brief Whether TimerUpdateClock has been registered with the PLL. */
+static bool isTimerClockTaskAdded = false;
+
+/**
+ * @brief TimerUpdateClock rescales the period of every clock scaled timer when
+ *        the system clock changes.
+ *
+ * @param frequency The new system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void TimerUpdateClock(uint32_t frequency, uint32_t * args) {
+    uint8_t ID;
+    for (ID = 0; ID < TIMER_COUNT; ++ID) {
+        struct TimerInterruptSettings * settings = &TimerInterruptSettings[ID];
+        if (settings->period == 0) continue;
+
+        /* Round to nearest, from the original period to avoid drift. */
+        uint64_t period = (settings->period * frequency + settings->clock / 2) / settings->clock;
+        if (period == 0) period = 1;
+        if (period > settings->maxPeriod) period = settings->maxPeriod;
+
+        Timer_t timer = {
+            .timerID=(TimerID_t)ID,
+            .period=period
+        };
+        TimerUpdatePeriod(timer);
+    }
+}
+
 Timer_t TimerInit(TimerConfig_t config) {
     /* Initialization asserts. */
     assert(config.timerID < TIMER_COUNT);
@@ -95,6 +136,16 @@ Timer_t TimerInit(TimerConfig_t config) {
     TimerInterruptSettings[ID].timerTask = config.timerTask;
     TimerInterruptSettings[ID].timerArgs = config.timerArgs;
 
+    /* Keep the period for rescaling on clock changes. */
+    TimerInterruptSettings[ID].period = config.isClockScaled ? config.period : 0;
+    TimerInterruptSettings[ID].clock = PLLGetFrequency();
+    if (ID == SYSTICK) TimerInterruptSettings[ID].maxPeriod = 0x1000000;
+    else if (ID <= TIMER_5B && config.isIndividual) TimerInterruptSettings[ID].maxPeriod = 0x10000;
+    else TimerInterruptSettings[ID].maxPeriod = 0xFFFFFFFF;
+    if (config.isClockScaled && !isTimerClockTaskAdded) {
+        isTimerClockTaskAdded = PLLAddClockTask(TimerUpdateClock, NULL);
+    }
+
     /* Special case for SYSTICK. */
     if (ID == SYSTICK) {
         /* Disable during setup. */
@@ -185,8 +236,8 @@ Timer_t TimerInit(TimerConfig_t config) {
 }
 
 void TimerStart(Timer_t timer) {
-    /* Initialization asserts. */
-    assert(timer.timerID < TIMER_COUNT);
+    /* Always on checks. A bad ID would write outside of the timer blocks. */
+    if (!CHECK(CHECK_TIMER, timer.timerID < TIMER_COUNT)) return;
 
     uint8_t ID = timer.timerID;
 
@@ -212,8 +263,8 @@ void TimerStart(Timer_t timer) {
 }
 
 void TimerStop(Timer_t timer) {
-    /* Initialization asserts. */
-    assert(timer.timerID < TIMER_COUNT);
+    /* Always on checks. A bad ID would write outside of the timer blocks. */
+    if (!CHECK(CHECK_TIMER, timer.timerID < TIMER_COUNT)) return;
 
     uint8_t ID = timer.timerID;
 
@@ -239,9 +290,9 @@ void TimerStop(Timer_t timer) {
 }
 
 void TimerUpdatePeriod(Timer_t timer) {
-    /* Initialization asserts. */
-    assert(timer.timerID < TIMER_COUNT);
-    assert(0 < timer.period);
+    /* Always on checks. A bad ID would write outside of the timer blocks. */
+    if (!CHECK(CHECK_TIMER, timer.timerID < TIMER_COUNT)) return;
+    if (!CHECK(CHECK_TIMER, 0 < timer.period)) return;
 
     uint8_t ID = timer.timerID;
 
@@ -263,12 +314,13 @@ void TimerUpdatePeriod(Timer_t timer) {
     else timerOffset = 0x1000 * (uint32_t)((ID - 16) >> 1) + 0x0001C000;
 
     /* 2. Update the period. */
-    GET_REG(GPTM_BASE + timerOffset + GPTMTAILR_OFFSET) = timer.period - 1;
+    if ((ID % 2) == 0) GET_REG(GPTM_BASE + timerOffset + GPTMTAILR_OFFSET) = timer.period - 1;
+    else GET_REG(GPTM_BASE + timerOffset + GPTMTBILR_OFFSET) = timer.period - 1;
 }
 
 uint64_t TimerGetValue(Timer_t timer) {
-    /* Initialization asserts. */
-    assert(timer.timerID < TIMER_COUNT);
+    /* Always on checks. A bad ID would write outside of the timer blocks. */
+    if (!CHECK(CHECK_TIMER, timer.timerID < TIMER_COUNT)) return 0;
 
     /* Special case for SYSTICK. */
     if (timer.timerID == SYSTICK) {
@@ -311,152 +363,169 @@ uint32_t freqToPeriod(uint32_t freq, uint32_t maxFreq) {
 }
 
 
+#ifdef __PROFILE__
+/**
+ * @brief TimerGetLatency returns the number of timer ticks since the last
+ *        timeout of a periodic timer.
+ *
+ * @param ID The timer.
+ * @return The ticks elapsed since the counter was reloaded.
+ */
+static uint32_t TimerGetLatency(uint8_t ID) {
+    if (ID == SYSTICK) {
+        return GET_REG(PERIPHERALS_BASE + SYSTICK_LOAD_OFFSET) -
+            (GET_REG(PERIPHERALS_BASE + SYSTICK_CURR_OFFSET) & 0x00FFFFFF);
+    }
+
+    uint32_t timerOffset = 0;
+    /* Timers TIMER_0A to WTIMER_1B. */
+    if (ID < WTIMER_2A) timerOffset = 0x1000 * (uint32_t)(ID >> 1);
+    /* Timers WTIMER_2A to WTIMER_5B. Jump the base to 0x4004.C000. Our magic
+       number, 16, is the enumerated value of WTIMER_2A. */
+    else timerOffset = 0x1000 * (uint32_t)((ID-16) >> 1) + 0x0001C000;
+
+    if ((ID % 2) == 0) {
+        return GET_REG(GPTM_BASE + timerOffset + GPTMTAILR_OFFSET) -
+            GET_REG(GPTM_BASE + timerOffset + GPTMTAV_OFFSET);
+    }
+    return GET_REG(GPTM_BASE + timerOffset + GPTMTBILR_OFFSET) -
+        GET_REG(GPTM_BASE + timerOffset + GPTMTBV_OFFSET);
+}
+
+/**
+ * @brief TimerIsOverrun returns whether a timer timed out again while its
+ *        handler was running. The handler clears the flag on entry.
+ *
+ * @param ID The timer.
+ * @return Whether the timer interrupt is pending again.
+ */
+static bool TimerIsOverrun(uint8_t ID) {
+    if (ID == SYSTICK) {
+        /* PENDSTSET. */
+        return GET_REG(PERIPHERALS_BASE + SYS_INTCTRL_OFFSET) & 0x04000000;
+    }
+
+    uint32_t timerOffset = 0;
+    if (ID < WTIMER_2A) timerOffset = 0x1000 * (uint32_t)(ID >> 1);
+    else timerOffset = 0x1000 * (uint32_t)((ID-16) >> 1) + 0x0001C000;
+
+    return GET_REG(GPTM_BASE + timerOffset + GPTMRIS_OFFSET) &
+        (((ID % 2) == 0) ? 0x00000001 : 0x00000100);
+}
+#endif
+
+/**
+ * @brief TimerDispatch calls the user task of a timer. With __PROFILE__, the
+ *        call is timed into the timer's profile slot.
+ *
+ * @param ID The timer.
+ */
+static void TimerDispatch(uint8_t ID) {
+    PROFILE_BEGIN(sample, TimerGetLatency(ID));
+    if (TimerInterruptSettings[ID].timerTask != NULL) {
+        TimerInterruptSettings[ID].timerTask(TimerInterruptSettings[ID].timerArgs);
+    }
+    PROFILE_END(sample, PROFILE_SLOT_TIMER(ID), TimerIsOverrun(ID));
+}
+
 /** Handler implementations for wide timers. */
 void Timer0A_Handler(void) {
     GET_REG(GPTM_BASE + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[0].timerTask != NULL) {
-        TimerInterruptSettings[0].timerTask(TimerInterruptSettings[0].timerArgs);
-    }
+    TimerDispatch(0);
 }
 void Timer0B_Handler(void) {
     GET_REG(GPTM_BASE + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[1].timerTask != NULL) {
-        TimerInterruptSettings[1].timerTask(TimerInterruptSettings[1].timerArgs);
-    }
+    TimerDispatch(1);
 }
 void Timer1A_Handler(void) {
     GET_REG(GPTM_BASE + 0x1000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[2].timerTask != NULL) {
-        TimerInterruptSettings[2].timerTask(TimerInterruptSettings[2].timerArgs);
-    }
+    TimerDispatch(2);
 }
 void Timer1B_Handler(void) {
     GET_REG(GPTM_BASE + 0x1000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[3].timerTask != NULL) {
-        TimerInterruptSettings[3].timerTask(TimerInterruptSettings[3].timerArgs);
-    }
+    TimerDispatch(3);
 }
 void Timer2A_Handler(void) {
     GET_REG(GPTM_BASE + 0x2000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[4].timerTask != NULL) {
-        TimerInterruptSettings[4].timerTask(TimerInterruptSettings[4].timerArgs);
-    }
+    TimerDispatch(4);
 }
 void Timer2B_Handler(void) {
     GET_REG(GPTM_BASE + 0x2000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[5].timerTask != NULL) {
-        TimerInterruptSettings[5].timerTask(TimerInterruptSettings[5].timerArgs);
-    }
+    TimerDispatch(5);
 }
 void Timer3A_Handler(void) {
     GET_REG(GPTM_BASE + 0x3000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[6].timerTask != NULL) {
-        TimerInterruptSettings[6].timerTask(TimerInterruptSettings[6].timerArgs);
-    }
+    TimerDispatch(6);
 }
 void Timer3B_Handler(void) {
     GET_REG(GPTM_BASE + 0x3000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[7].timerTask != NULL) {
-        TimerInterruptSettings[7].timerTask(TimerInterruptSettings[7].timerArgs);
-    }
+    TimerDispatch(7);
 }
 void Timer4A_Handler(void) {
     GET_REG(GPTM_BASE + 0x4000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[8].timerTask != NULL) {
-        TimerInterruptSettings[8].timerTask(TimerInterruptSettings[8].timerArgs);
-    }
+    TimerDispatch(8);
 }
 void Timer4B_Handler(void) {
     GET_REG(GPTM_BASE + 0x4000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[9].timerTask != NULL) {
-        TimerInterruptSettings[9].timerTask(TimerInterruptSettings[9].timerArgs);
-    }
+    TimerDispatch(9);
 }
 void Timer5A_Handler(void) {
     GET_REG(GPTM_BASE + 0x5000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[10].timerTask != NULL) {
-        TimerInterruptSettings[10].timerTask(TimerInterruptSettings[10].timerArgs);
-    }
+    TimerDispatch(10);
 }
 void Timer5B_Handler(void) {
     GET_REG(GPTM_BASE + 0x5000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[11].timerTask != NULL) {
-        TimerInterruptSettings[11].timerTask(TimerInterruptSettings[11].timerArgs);
-    }
+    TimerDispatch(11);
 }
 
 /** Handler implementations for wide timers. */
 void WideTimer0A_Handler(void) {
     GET_REG(GPTM_BASE + 0x6000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[12].timerTask != NULL) {
-        TimerInterruptSettings[12].timerTask(TimerInterruptSettings[12].timerArgs);
-    }
+    TimerDispatch(12);
 }
 void WideTimer0B_Handler(void) {
     GET_REG(GPTM_BASE + 0x6000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[13].timerTask != NULL) {
-        TimerInterruptSettings[13].timerTask(TimerInterruptSettings[13].timerArgs);
-    }
+    TimerDispatch(13);
 }
 void WideTimer1A_Handler(void) {
     GET_REG(GPTM_BASE + 0x7000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[14].timerTask != NULL) {
-        TimerInterruptSettings[14].timerTask(TimerInterruptSettings[14].timerArgs);
-    }
+    TimerDispatch(14);
 }
 void WideTimer1B_Handler(void) {
     GET_REG(GPTM_BASE + 0x7000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[15].timerTask != NULL) {
-        TimerInterruptSettings[15].timerTask(TimerInterruptSettings[15].timerArgs);
-    }
+    TimerDispatch(15);
 }
 void WideTimer2A_Handler(void) {
     GET_REG(GPTM_BASE + 0x1C000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[16].timerTask != NULL) {
-        TimerInterruptSettings[16].timerTask(TimerInterruptSettings[16].timerArgs);
-    }
+    TimerDispatch(16);
 }
 void WideTimer2B_Handler(void) {
     GET_REG(GPTM_BASE + 0x1C000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[17].timerTask != NULL) {
-        TimerInterruptSettings[17].timerTask(TimerInterruptSettings[17].timerArgs);
-    }
+    TimerDispatch(17);
 }
 void WideTimer3A_Handler(void) {
     GET_REG(GPTM_BASE + 0x1D000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[18].timerTask != NULL) {
-        TimerInterruptSettings[18].timerTask(TimerInterruptSettings[18].timerArgs);
-    }
+    TimerDispatch(18);
 }
 void WideTimer3B_Handler(void) {
     GET_REG(GPTM_BASE + 0x1D000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[19].timerTask != NULL) {
-        TimerInterruptSettings[19].timerTask(TimerInterruptSettings[19].timerArgs);
-    }
+    TimerDispatch(19);
 }
 void WideTimer4A_Handler(void) {
     GET_REG(GPTM_BASE + 0x1E000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[20].timerTask != NULL) {
-        TimerInterruptSettings[20].timerTask(TimerInterruptSettings[20].timerArgs);
-    }
+    TimerDispatch(20);
 }
 void WideTimer4B_Handler(void) {
     GET_REG(GPTM_BASE + 0x1E000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[21].timerTask != NULL) {
-        TimerInterruptSettings[21].timerTask(TimerInterruptSettings[21].timerArgs);
-    }
+    TimerDispatch(21);
 }
 void WideTimer5A_Handler(void) {
     GET_REG(GPTM_BASE + 0x1F000 + GPTMICR_OFFSET) |= TIMERXA_ICR_TATOCINT;
-    if (TimerInterruptSettings[22].timerTask != NULL) {
-        TimerInterruptSettings[22].timerTask(TimerInterruptSettings[22].timerArgs);
-    }
+    TimerDispatch(22);
 }
 void WideTimer5B_Handler(void) {
     GET_REG(GPTM_BASE + 0x1F000 + GPTMICR_OFFSET) |= TIMERXB_ICR_TATOCINT;
-    if (TimerInterruptSettings[23].timerTask != NULL) {
-        TimerInterruptSettings[23].timerTask(TimerInterruptSettings[23].timerArgs);
-    }
+    TimerDispatch(23);
 }
 
 /** @brief System clock ticks since program start. Used for delay functions. */
@@ -466,9 +535,7 @@ void SysTick_Handler(void) {
     /* Note: This will roll over at 0xFFFFFFFFFFFFFFFF. Be warned. */
     ++systick;
 
-    if (TimerInterruptSettings[24].timerTask != NULL) {
-        TimerInterruptSettings[24].timerTask(TimerInterruptSettings[24].timerArgs);
-    }
+    TimerDispatch(24);
 }
 
 uint64_t SysTickGetTick(void) {
@@ -478,12 +545,13 @@ uint64_t SysTickGetTick(void) {
 Timer_t DelayInit(void) {
     TimerConfig_t config = {
         .timerID=SYSTICK,
-        .period=freqToPeriod(MAX_FREQ/80, MAX_FREQ),
+        .period=freqToPeriod(1000000, MAX_FREQ),
         .isIndividual=false,
         .timerTask=NULL,
         .isPeriodic=true,
         .priority=1,
-        .timerArgs=NULL
+        .timerArgs=NULL,
+        .isClockScaled=true
     };
     Timer_t timer = TimerInit(config);
     TimerStart(timer);
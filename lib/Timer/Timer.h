@@ -15,8 +15,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/** Device specific imports. */
+#include <lib/PLL/PLL.h>
 
-#define MAX_FREQ 80000000 /** 80 MHz. */
+
+/** The current system clock frequency, in Hz. Set by PLLInit and PLLSetClock. */
+#define MAX_FREQ PLLGetFrequency()
 
 /** @brief TimerID_t is an enumeration defining all possible timers, including SysTick. */
 typedef enum TimerID {
@@ -120,6 +124,18 @@ typedef struct TimerConfig {
      *       timerArgs inside of their timerTask function implementation.
      */
     uint32_t * timerArgs;
+
+    /**
+     * @brief Whether the period is rescaled when PLLSetClock changes the
+     *        system clock, so the timer keeps its frequency.
+     *
+     * Default is false (The period stays in cycles, and the frequency follows
+     * the system clock).
+     *
+     * @note Rescaled periods are limited to the width of the timer. The
+     *       prescale value is not changed.
+     */
+    bool isClockScaled;
 } TimerConfig_t;
 
 /** @brief Timer_t is a struct containing user relevant data of a timer. */
@@ -237,7 +253,8 @@ uint64_t SysTickGetTick(void);
 
 /**
  * @brief DelayInit initializes the SysTick timer to run at 1 MHz and start an
- *        internal ticker.
+ *        internal ticker. SysTick is kept at 1 MHz when PLLSetClock changes the
+ *        system clock.
  *
  * @return Configuration for SysTick.
  * @note This can be overwritten by other SysTick initializations. If another
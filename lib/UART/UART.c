@@ -6,8 +6,12 @@
  * @date 2021-10-18
  * @copyright Copyright (c) 2021
  * @note
+ * uDMA. With isDMA set, UARTSendAsync moves the transmit buffer into the FIFO
+ * on the channel in UARTDMAMapping, and UARTIsBusy reports when it is done.
+ * Receive is not DMA driven.
+ *
  * Unsupported Features. This driver does not support interrupts. This driver
- * does not support uDMA. This driver does not support modem handshake support.
+ * does not support modem handshake support.
  */
 
 /** General Imports. */
@@ -18,6 +22,7 @@
 #include <inc/RegDefs.h>
 #include <lib/UART/UART.h>
 #include <lib/GPIO/GPIO.h>
+#include <lib/PLL/PLL.h>
 
 
 static GPIOPin_t UARTPinMapping[9][2] = {
@@ -32,21 +37,135 @@ static GPIOPin_t UARTPinMapping[9][2] = {
     {PIN_E0, PIN_E1}
 };
 
-static uint32_t UARTSpeedMapping[8][2] = {
-    {520,  53}, // 9600
-    {4166, 43}, // 1200
-    {2083, 21}, // 2400
-    {1041, 43}, // 4800
-    {260,  27}, // 19200
-    {130,  13}, // 38400
-    {86,   52}, // 57600
-    {43,   26}  // 115200
+/** @brief UARTDMAMapping is the transmit uDMA channel and its channel
+ *         encoding for each module. See Table 9-1. uDMA Channel Assignments
+ *         on p. 587 of the TM4C Datasheet. */
+static uint8_t UARTDMAMapping[8][2] = {
+    // Channel  // Encoding
+    {DMA9,      0},
+    {DMA23,     0},
+    {DMA13,     1},
+    {DMA17,     2},
+    {DMA19,     2},
+    {DMA7,      2},
+    {DMA11,     2},
+    {DMA21,     2}
 };
 
+/** @brief UARTIsDMA is whether each module was initialized with isDMA. */
+static bool UARTIsDMA[8] = { false };
+
+/** @brief UARTBaudrates is the rate each module was initialized with, in bits
+ *         per second. 0 if the module is not initialized. */
+static uint32_t UARTBaudrates[8] = { 0 };
+
+/** @brief UARTAchievedBaudrates is the rate each module runs at, in bits per
+ *         second, at the current system clock. */
+static uint32_t UARTAchievedBaudrates[8] = { 0 };
+
+/** @brief Whether the UART clock tasks have been registered with the PLL. */
+static bool isUARTClockTaskAdded = false;
+
+uint32_t UARTGetDivisor(uint32_t systemClock, uint32_t baudrate, bool * isHighSpeed) {
+    /* Initialization asserts. */
+    assert(0 < baudrate && baudrate <= systemClock / 8);
+    assert(isHighSpeed != NULL);
+
+    /* BRD = SysClk / (ClkDiv * baudrate), in 1/64ths, rounded to nearest. A
+       ClkDiv of 16 samples each bit more often, so it is kept while the
+       integer part of the divisor is at least 1. See p. 896 of the TM4C
+       Datasheet. */
+    *isHighSpeed = baudrate > systemClock / 16;
+    uint32_t clockDivider = *isHighSpeed ? 8 : 16;
+    uint64_t divisor = (((uint64_t)systemClock * 128) / ((uint64_t)clockDivider * baudrate) + 1) / 2;
+
+    /* IBRD is 16 bits wide. */
+    if (divisor > 0x3FFFFF) divisor = 0x3FFFFF;
+    return (uint32_t)divisor;
+}
+
+uint32_t UARTGetBaudrate(uint32_t systemClock, uint32_t divisor, bool isHighSpeed) {
+    /* Initialization asserts. */
+    assert(divisor >= 64);
+
+    uint64_t scaledDivisor = (uint64_t)divisor * (isHighSpeed ? 8 : 16);
+    return (uint32_t)(((uint64_t)systemClock * 64 + scaledDivisor / 2) / scaledDivisor);
+}
+
+/**
+ * @brief UARTSetBaudrate sets the baud rate divisor and ClkDiv of a disabled
+ *        UART from the current system clock. The divisor is latched by the
+ *        next LCRH write.
+ *
+ * @param moduleBase Base address of the UART module.
+ * @param systemClock The system clock frequency, in Hz.
+ * @param baudrate The rate, in bits per second. From 1 - systemClock / 8.
+ * @return The rate achieved, in bits per second.
+ */
+static uint32_t UARTSetBaudrate(uint32_t moduleBase, uint32_t systemClock, uint32_t baudrate) {
+    bool isHighSpeed;
+    uint32_t divisor = UARTGetDivisor(systemClock, baudrate, &isHighSpeed);
+    GET_REG(moduleBase + UART_IBRD_OFFSET) = divisor >> 6;
+    GET_REG(moduleBase + UART_FBRD_OFFSET) = divisor & 0x3F;
+    if (isHighSpeed) GET_REG(moduleBase + UART_CTL_OFFSET) |= 0x0020;
+    else GET_REG(moduleBase + UART_CTL_OFFSET) &= ~0x0020;
+
+    return UARTGetBaudrate(systemClock, divisor, isHighSpeed);
+}
+
+/**
+ * @brief UARTPrepareClock lets the frames in flight on every initialized UART
+ *        finish before the system clock changes.
+ *
+ * @param frequency The upcoming system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void UARTPrepareClock(uint32_t frequency, uint32_t * args) {
+    uint8_t module;
+    for (module = 0; module < 8; ++module) {
+        if (UARTBaudrates[module] == 0) continue;
+
+        /* Wait for the transmitter to go idle. */
+        UART_t uart = { .module=module };
+        while (UARTIsBusy(uart)) {}
+    }
+}
+
+/**
+ * @brief UARTUpdateClock recomputes the baud rate divisors of every
+ *        initialized UART when the system clock changes. A rate above the
+ *        new SysClk / 8 is clamped to it; the requested rate is kept and
+ *        restored once the clock allows it again.
+ *
+ * @param frequency The new system clock frequency, in Hz.
+ * @param args Unused.
+ */
+static void UARTUpdateClock(uint32_t frequency, uint32_t * args) {
+    uint8_t module;
+    for (module = 0; module < 8; ++module) {
+        if (UARTBaudrates[module] == 0) continue;
+        uint32_t moduleBase = 0x1000 * module + UART_BASE;
+
+        /* 1. Disable the UART. */
+        GET_REG(moduleBase + UART_CTL_OFFSET) &= ~0x0001;
+
+        /* 2. Set the divisor and latch it with an LCRH write. This runs inside
+              PLLSetClock with interrupts masked, so an unreachable rate is
+              clamped instead of asserted. */
+        uint32_t baudrate = UARTBaudrates[module];
+        if (baudrate > frequency / 8) baudrate = frequency / 8;
+        UARTAchievedBaudrates[module] = UARTSetBaudrate(moduleBase, frequency, baudrate);
+        GET_REG(moduleBase + UART_LCRH_OFFSET) = GET_REG(moduleBase + UART_LCRH_OFFSET);
+
+        /* 3. Re-enable UART operation. */
+        GET_REG(moduleBase + UART_CTL_OFFSET) |= 0x0001;
+    }
+}
+
 UART_t UARTInit(UARTConfig_t config) {
     /* Initialization asserts. */
     assert(config.module <= UART_MODULE_7);
-    assert(config.baudrate <= UART_BAUD_115200);
+    assert(config.baudrate <= PLLGetFrequency() / 8);
     assert(config.dataLength <= UART_BITS_7);
     assert(config.parity <= UART_PARITY_EVEN);
 
@@ -70,9 +189,16 @@ UART_t UARTInit(UARTConfig_t config) {
     /* 4. Disable UART operation. */
     GET_REG(moduleBase + UART_CTL_OFFSET) &= 0xFFFE;
 
-    /* 5. Set baud rate. */
-    GET_REG(moduleBase + UART_IBRD_OFFSET) = UARTSpeedMapping[config.baudrate][0];
-    GET_REG(moduleBase + UART_FBRD_OFFSET) = UARTSpeedMapping[config.baudrate][1];
+    /* 5. Set baud rate from the current system clock, and keep it when the
+          clock changes. */
+    uint32_t baudrate = (config.baudrate == 0) ? UART_DEFAULT_BAUDRATE : config.baudrate;
+    UARTBaudrates[config.module] = baudrate;
+    uint32_t achieved = UARTSetBaudrate(moduleBase, PLLGetFrequency(), baudrate);
+    UARTAchievedBaudrates[config.module] = achieved;
+    if (!isUARTClockTaskAdded) {
+        isUARTClockTaskAdded = PLLAddClockPrepareTask(UARTPrepareClock, NULL) &&
+            PLLAddClockTask(UARTUpdateClock, NULL);
+    }
 
     /* 6. Set data length, fifo enabled, stop bits, and parity. */
     GET_REG(moduleBase + UART_LCRH_OFFSET) &= ~(0x0000FFFF);
@@ -102,13 +228,40 @@ UART_t UARTInit(UARTConfig_t config) {
     /* 9. Re-enable UART operation. */
     GET_REG(moduleBase + UART_CTL_OFFSET) |= 0x0001;
 
+    /* 10. Connect the transmit FIFO to the uDMA. Completion is polled, so the
+           UART interrupt is left disabled. */
+    UARTIsDMA[config.module] = config.isDMA;
+    GET_REG(moduleBase + UART_DMACTL_OFFSET) = 0x0;
+    if (config.isDMA) {
+        DMAConfig_t dmaConfig = {
+            .channel=UARTDMAMapping[config.module][0],
+            .assignment=UARTDMAMapping[config.module][1],
+            .isHighPriority=false,
+            .isOnlyBurst=false,
+            .doneTask=NULL,
+            .doneArgs=NULL,
+            .priority=0
+        };
+        DMAInit(dmaConfig);
+    }
+
     UART_t uart = {
-        .module=config.module
+        .module=config.module,
+        .baudrate=achieved,
+        .baudError=(int32_t)(((int64_t)achieved - baudrate) * 1000000 / baudrate),
+        .isDMA=config.isDMA
     };
 
     return uart;
 }
 
+uint32_t UARTGetCurrentBaudrate(UART_t uart) {
+    /* Initialization asserts. */
+    assert(uart.module <= UART_MODULE_7);
+
+    return UARTAchievedBaudrates[uart.module];
+}
+
 uint8_t UARTSend(UART_t uart, uint8_t * values, uint8_t numValues) {
     uint32_t moduleBase = 0x1000 * uart.module + UART_BASE;
 
@@ -124,6 +277,49 @@ uint8_t UARTSend(UART_t uart, uint8_t * values, uint8_t numValues) {
     return i;
 }
 
+bool UARTSendAsync(UART_t uart, const uint8_t * values, uint16_t numValues) {
+    /* Initialization asserts. */
+    assert(uart.module <= UART_MODULE_7);
+    assert(UARTIsDMA[uart.module]);
+    assert(values != NULL);
+    assert(0 < numValues && numValues <= 1024);
+
+    DMA_t dma = { .channel=UARTDMAMapping[uart.module][0] };
+    if (DMAIsActive(dma)) return false;
+
+    /* 1. Arm the transmit channel. The FIFO requests at half empty, so four
+          bytes are moved per arbitration. */
+    uint32_t moduleBase = 0x1000 * uart.module + UART_BASE;
+    DMATransfer_t transfer = {
+        .source=values,
+        .destination=(volatile void *)(uintptr_t)(moduleBase + UART_DR_OFFSET),
+        .count=numValues,
+        .size=DMA_SIZE_8,
+        .isSourceIncrementing=true,
+        .isDestinationIncrementing=false,
+        .arbitration=DMA_ARB_4,
+        .mode=DMA_MODE_BASIC
+    };
+    DMASetTransfer(dma, transfer, false);
+    DMAStart(dma);
+
+    /* 2. Let the transmit FIFO request transfers. */
+    GET_REG(moduleBase + UART_DMACTL_OFFSET) |= 0x2;
+    return true;
+}
+
+bool UARTIsBusy(UART_t uart) {
+    /* Initialization asserts. */
+    assert(uart.module <= UART_MODULE_7);
+
+    uint32_t moduleBase = 0x1000 * uart.module + UART_BASE;
+    if (UARTIsDMA[uart.module]) {
+        DMA_t dma = { .channel=UARTDMAMapping[uart.module][0] };
+        if (DMAIsActive(dma)) return true;
+    }
+    return GET_REG(moduleBase + UART_FR_OFFSET) & 0x08;
+}
+
 uint8_t UARTReceive(UART_t uart, uint8_t * values, uint8_t maxNumValues) {
     uint32_t moduleBase = 0x1000 * uart.module + UART_BASE;
 
@@ -7,7 +7,17 @@
  * @copyright Copyright (c) 2021
  * @note
  * Unsupported Features. This driver does not support interrupts. This driver
- * does not support uDMA. This driver does not support modem handshake support.
+ * does not support modem handshake support.
+ *
+ * DMA. When isDMA is set at initialization, UARTSendAsync hands a buffer to
+ * the uDMA and returns immediately. Completion is polled with UARTIsBusy.
+ *
+ * Baud Rates. Any rate up to SysClk / 8 is computed from the system clock at
+ * initialization, and recomputed when PLLSetClock changes the clock. UART_t
+ * reports the rate achieved and its error. Both ends of a link should stay
+ * within about 2% of each other. If a new clock cannot reach the rate, it is
+ * clamped to SysClk / 8 until a faster clock returns; UARTGetCurrentBaudrate
+ * reports the rate in use.
  */
 
 #pragma once
@@ -16,6 +26,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/** Device specific imports. */
+#include <lib/DMA/DMA.h>
+
 
 /**
  * @brief UARTModule is an enumeration specifying a set of pins used for UART
@@ -46,19 +59,9 @@ enum UARTModule {
                     // PE1 TX
 };
 
-/**
- * @brief UARTBaudrate is an enumeration specifying a set of baud rates used for
- *        UART communication. */
-enum UARTBaudrate {
-    UART_BAUD_9600,
-    UART_BAUD_1200,
-    UART_BAUD_2400,
-    UART_BAUD_4800,
-    UART_BAUD_19200,
-    UART_BAUD_38400,
-    UART_BAUD_57600,
-    UART_BAUD_115200
-};
+/** @brief UART_DEFAULT_BAUDRATE is the rate used when none is specified, in
+ *         bits per second. */
+#define UART_DEFAULT_BAUDRATE 9600
 
 /**
  * @brief UARTDataLength is an enumeration specifying the length of the data
@@ -93,11 +96,13 @@ typedef struct UARTConfig {
     /** ------------- Optional Fields. ------------- */
 
     /**
-     * @brief The baudrate used in communication with the received device.
+     * @brief The baudrate used in communication with the received device, in
+     *        bits per second. Any rate up to SysClk / 8 (10 Mbaud at 80 MHz)
+     *        is allowed; see UARTGetDivisor.
      * 
-     * Default is 9600 bits per second.
+     * Default is 0 (UART_DEFAULT_BAUDRATE, 9600 bits per second).
      */
-    enum UARTBaudrate baudrate;
+    uint32_t baudrate;
 
     /**
      * @brief The length of the data in a frame.
@@ -136,6 +141,14 @@ typedef struct UARTConfig {
      * Default false, the UART is not in loopback mode.
      */
     bool isLoopback;
+
+    /**
+     * @brief Whether the transmit FIFO is connected to the uDMA, for
+     *        UARTSendAsync.
+     * 
+     * Default false (UARTSend only).
+     */
+    bool isDMA;
 } UARTConfig_t;
 
 /**
@@ -144,8 +157,42 @@ typedef struct UARTConfig {
 typedef struct UART {
     /** @brief The UART module used for communicating with another device. */
     enum UARTModule module;
+
+    /** @brief The baud rate achieved at initialization, in bits per second. */
+    uint32_t baudrate;
+
+    /** @brief The error of the achieved baud rate against the requested rate,
+     *         in parts per million. */
+    int32_t baudError;
+
+    /** @brief Whether the UART was initialized with isDMA, for UARTSendAsync. */
+    bool isDMA;
 } UART_t;
 
+/**
+ * @brief UARTGetDivisor computes the baud rate divisor of a rate at a given
+ *        system clock, without touching any hardware. The divisor is rounded
+ *        to the nearest 1/64th. A system clock divider (ClkDiv) of 16 is used
+ *        when possible, and 8 (high speed) otherwise.
+ * 
+ * @param systemClock The system clock frequency, in Hz. Usually
+ *                    PLLGetFrequency().
+ * @param baudrate The rate, in bits per second. From 1 - systemClock / 8.
+ * @param isHighSpeed Output. Whether ClkDiv is 8 instead of 16.
+ * @return The divisor, in 1/64ths. IBRD is bits [21:6] and FBRD is bits [5:0].
+ */
+uint32_t UARTGetDivisor(uint32_t systemClock, uint32_t baudrate, bool * isHighSpeed);
+
+/**
+ * @brief UARTGetBaudrate computes the rate produced by a baud rate divisor.
+ * 
+ * @param systemClock The system clock frequency, in Hz.
+ * @param divisor The divisor, in 1/64ths. See UARTGetDivisor.
+ * @param isHighSpeed Whether ClkDiv is 8 instead of 16.
+ * @return The baud rate, in bits per second, rounded to nearest.
+ */
+uint32_t UARTGetBaudrate(uint32_t systemClock, uint32_t divisor, bool isHighSpeed);
+
 /**
  * @brief UARTInit initializes a UART module given an UARTConfig_t
  * configuration. 
@@ -155,6 +202,16 @@ typedef struct UART {
  */
 UART_t UARTInit(UARTConfig_t config);
 
+/**
+ * @brief UARTGetCurrentBaudrate returns the rate a UART runs at under the
+ *        current system clock. This differs from the rate in UART_t once
+ *        PLLSetClock has clamped it to a slower clock.
+ * 
+ * @param uart The UART module to check.
+ * @return The rate achieved, in bits per second.
+ */
+uint32_t UARTGetCurrentBaudrate(UART_t uart);
+
 /**
  * @brief UARTSend transmits a specified number of values across the data line of
  *        a provided UART.
@@ -166,6 +223,27 @@ UART_t UARTInit(UARTConfig_t config);
  */
 uint8_t UARTSend(UART_t uart, uint8_t * values, uint8_t numValues);
 
+/**
+ * @brief UARTSendAsync starts transmitting a buffer with the uDMA and returns
+ *        immediately. The UART must be initialized with isDMA.
+ * 
+ * @param uart The UART module to transmit across.
+ * @param values Pointer to the data array to send. Must remain valid until
+ *               UARTIsBusy returns false.
+ * @param numValues The number of values to send, from 1 - 1024.
+ * @return False if the previous transfer is still running.
+ */
+bool UARTSendAsync(UART_t uart, const uint8_t * values, uint16_t numValues);
+
+/**
+ * @brief UARTIsBusy returns whether the UART is still transmitting, either
+ *        from the uDMA or from the transmit FIFO.
+ * 
+ * @param uart The UART module to check.
+ * @return Whether the UART is transmitting.
+ */
+bool UARTIsBusy(UART_t uart);
+
 /**
  * @brief UARTReceive receives a variable number of values from the receive FIFO.
  *        
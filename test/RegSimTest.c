@@ -0,0 +1,169 @@
+/**
+ * @file RegSimTest.c
+ * @author Matthew Yu (matthewjkyu@gmail.com)
+ * @brief Host test of the RegSim peripheral models, driven through the
+ *        drivers.
+ * @version 0.1
+ * @date 2022-03-05
+ * @copyright Copyright (c) 2022
+ * @note
+ * Build and run from the repository root with `make test`. Covers:
+ *      - Clock gates: GPIOInit and UARTInit return once their peripheral
+ *        reports ready, and the UART FIFOs start empty.
+ *      - PLL lock: PLLSetClock moves between the PLL and the PIOSC, the lock
+ *        flag is sticky until cleared through MISC, and leaving bypass before
+ *        the PLL locks stops the simulation.
+ *      - UART clock changes: a rate the new clock cannot reach is clamped to
+ *        SysClk / 8, and restored when the clock returns.
+ *      - ADC: ADCSampleSingle returns the value poked into SSFIFO and clears
+ *        the raw interrupt status.
+ */
+#define _DEFAULT_SOURCE
+
+/** General imports. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/** Device specific imports. */
+#include <inc/RegDefs.h>
+#include <lib/RegSim/RegSim.h>
+#include <lib/PLL/PLL.h>
+#include <lib/GPIO/GPIO.h>
+#include <lib/UART/UART.h>
+#include <lib/ADC/ADC.h>
+
+
+/** @brief The number of failed expectations. */
+static unsigned numFailures = 0;
+
+/** @brief EXPECT reports a failed expectation and carries on. */
+#define EXPECT(expr) \
+    do { \
+        if (!(expr)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #expr); \
+            ++numFailures; \
+        } \
+    } while (0)
+
+/** Clock gates mirror into the peripheral ready registers. */
+static void testPeripheralReady(void) {
+    RegSimReset();
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_PRGPIO_OFFSET) == 0);
+
+    GPIOConfig_t ledConfig = {
+        .pin=PIN_F1,
+        .pull=GPIO_PULL_DOWN,
+        .isOutput=true
+    };
+    GPIOInit(ledConfig);
+    RegSimFlush();
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_PRGPIO_OFFSET) & 0x20);
+
+    PLLInit(BUS_80_MHZ);
+    UARTConfig_t uartConfig = {
+        .module=UART_MODULE_1,
+        .baudrate=115200
+    };
+    UARTInit(uartConfig);
+    RegSimFlush();
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_PRUART_OFFSET) & 0x02);
+    EXPECT(RegSimPeek(UART_BASE + 0x1000 + UART_FR_OFFSET) == 0x90);
+}
+
+/** The PLL locks after power up, and the lock flag is sticky. */
+static void testPLLLock(void) {
+    RegSimReset();
+
+    EXPECT(PLLSetClock(PLL_SOURCE_PLL, BUS_80_MHZ) == 80000000);
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x40);
+
+    EXPECT(PLLSetClock(PLL_SOURCE_PIOSC, 0) == 16000000);
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x40);
+    EXPECT(PLLSetClock(PLL_SOURCE_PLL, BUS_50_MHZ) == 50000000);
+    EXPECT(PLLSetClock(PLL_SOURCE_PLL, BUS_80_MHZ) == 80000000);
+
+    /* MISC is write 1 to clear. */
+    GET_REG(SYSCTL_BASE + SYSCTL_MISC_OFFSET) = 0x40;
+    RegSimFlush();
+    EXPECT(!(RegSimPeek(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x40));
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_RIS_OFFSET) & 0x100);
+
+    /* Leaving bypass right after a power up, without waiting for the lock,
+       stops the simulation. Run it in a child process. */
+    PLLSetClock(PLL_SOURCE_PIOSC, 0);
+    fflush(stderr);
+    pid_t child = fork();
+    if (child == 0) {
+        freopen("/dev/null", "w", stderr);
+        GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00002000;
+        GET_REG(SYSCTL_BASE + SYSCTL_RCC2_OFFSET) &= ~0x00000800;
+        RegSimFlush();
+        _exit(EXIT_SUCCESS);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE);
+}
+
+/** A UART keeps running across a clock too slow for its rate. */
+static void testUARTClockChange(void) {
+    RegSimReset();
+    PLLInit(BUS_80_MHZ);
+
+    UARTConfig_t config = {
+        .module=UART_MODULE_1,
+        .baudrate=3000000
+    };
+    UART_t uart = UARTInit(config);
+    EXPECT(uart.baudError > -20000 && uart.baudError < 20000);
+    EXPECT(UARTGetCurrentBaudrate(uart) == uart.baudrate);
+
+    PLLSetClock(PLL_SOURCE_PIOSC, 0);
+    EXPECT(UARTGetCurrentBaudrate(uart) == 2000000);
+    RegSimFlush();
+    EXPECT(RegSimPeek(UART_BASE + 0x1000 + UART_CTL_OFFSET) & 0x0020);
+
+    PLLSetClock(PLL_SOURCE_PLL, BUS_80_MHZ);
+    EXPECT(UARTGetCurrentBaudrate(uart) == uart.baudrate);
+}
+
+/** A triggered sample sequencer completes with the poked sample. */
+static void testADC(void) {
+    RegSimReset();
+    PLLInit(BUS_80_MHZ);
+
+    ADCConfig_t config = {
+        .pin=AIN0,
+        .module=ADC_MODULE_0,
+        .sequencer=ADC_SS_3,
+        .position=ADC_SEQPOS_0
+    };
+    ADC_t adc = ADCInit(config);
+    RegSimFlush();
+    EXPECT(RegSimPeek(SYSCTL_BASE + SYSCTL_PRADC_OFFSET) & 0x01);
+
+    RegSimPoke(ADC0_BASE + ADC_SS3 + ADC_SSFIFO, 0x0ABC);
+    EXPECT(ADCSampleSingle(adc) == 0x0ABC);
+    RegSimFlush();
+    EXPECT(!(RegSimPeek(ADC0_BASE + ADC_RIS) & 0x8));
+    EXPECT(RegSimPeek(ADC0_BASE + ADC_SS3 + ADC_SSFSTAT) & 0x100);
+
+    RegSimPoke(ADC0_BASE + ADC_SS3 + ADC_SSFIFO, 0x1FFF);
+    EXPECT(ADCSampleSingle(adc) == 0x0FFF);
+}
+
+int main(void) {
+    testPeripheralReady();
+    testPLLLock();
+    testUARTClockChange();
+    testADC();
+
+    if (numFailures > 0) {
+        fprintf(stderr, "RegSimTest: %u failed.\n", numFailures);
+        return EXIT_FAILURE;
+    }
+    printf("RegSimTest: passed.\n");
+    return EXIT_SUCCESS;
+}